@@ -249,7 +249,7 @@ device_draw(struct device *dev, struct zr_context *ctx, enum zr_anti_aliasing AA
         }
         {
             /* <massive sign> allegro does not support 16-bit indicies:
-             * @OPT: define zr_draw_index as int to fix this issue. */
+             * @OPT: set ZR_COMPILE_WITH_32BIT_DRAW_INDEX to 1 to fix this issue. */
             unsigned int i = 0;
             zr_draw_index *elements = (zr_draw_index*)dev->element_buffer;
             indicies = calloc(sizeof(int), ctx->canvas.element_count);
@@ -81,8 +81,8 @@ draw(struct zr_context *ctx, int width, int height)
         } break;
         case ZR_COMMAND_TEXT: {
             const struct zr_command_text *t = zr_command(text, cmd);
-            ALLEGRO_FONT *font = t->font->userdata.ptr;
-            float y = (t->y + t->h/2) - t->font->height/2;
+            ALLEGRO_FONT *font = t->font.userdata.ptr;
+            float y = (t->y + t->h/2) - t->font.height/2;
             al_draw_text(font, al_map_rgba(t->foreground.r, t->foreground.g, t->foreground.g, t->foreground.a),
                     t->x, y, ALLEGRO_ALIGN_LEFT, t->string);
         } break;
@@ -42,6 +42,12 @@
 
 #include "../demo.c"
 
+#if ZR_COMPILE_WITH_32BIT_DRAW_INDEX
+#define DRAW_INDEX_TYPE GL_UNSIGNED_INT
+#else
+#define DRAW_INDEX_TYPE GL_UNSIGNED_SHORT
+#endif
+
 
 @implementation ZahnradBackend (Adapter)
 
@@ -442,7 +448,7 @@ static void mem_free(zr_handle unused, void* ptr)
                       (GLint)((height - (cmd->clip_rect.y + cmd->clip_rect.h)) * scale),
                       (GLint)(cmd->clip_rect.w * scale),
                       (GLint)(cmd->clip_rect.h * scale));
-            glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, GL_UNSIGNED_SHORT, offset);
+            glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, DRAW_INDEX_TYPE, offset);
             offset += cmd->elem_count;
         }
     }
@@ -489,7 +495,7 @@ static void mem_free(zr_handle unused, void* ptr)
                           (GLint)((height - (GLint)(cmd->clip_rect.y + cmd->clip_rect.h)) * scale),
                           (GLint)(cmd->clip_rect.w * scale),
                           (GLint)(cmd->clip_rect.h * scale));
-                glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, GL_UNSIGNED_SHORT, offset);
+                glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, DRAW_INDEX_TYPE, offset);
                 offset += cmd->elem_count;
             }
         }
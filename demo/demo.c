@@ -887,6 +887,25 @@ demo_window(struct zr_layout *layout, struct zr_context *ctx, enum theme *theme)
                 zr_layout_pop(ctx);
             }
 
+            if (zr_layout_push(ctx, ZR_LAYOUT_NODE, "List View", ZR_MINIMIZED))
+            {
+                struct zr_layout tab;
+                zr_layout_row_dynamic(ctx, 300, 1);
+                if (zr_group_begin(ctx, &tab, "Group_List_View", ZR_WINDOW_BORDER)) {
+                    zr_size i;
+                    struct zr_list_view view;
+                    zr_list_view_begin(ctx, &view, 1000000, 18);
+                    zr_layout_row_dynamic(ctx, 18, 2);
+                    for (i = view.begin; i < view.end; ++i) {
+                        zr_labelf(ctx, ZR_TEXT_LEFT, "row %lu", (unsigned long)i);
+                        zr_labelf(ctx, ZR_TEXT_RIGHT, "0x%08lx", (unsigned long)(i * 2654435761u));
+                    }
+                    zr_list_view_end(ctx, &view);
+                    zr_group_end(ctx);
+                }
+                zr_layout_pop(ctx);
+            }
+
             if (zr_layout_push(ctx, ZR_LAYOUT_NODE, "Complex", ZR_MINIMIZED))
             {
                 int i;
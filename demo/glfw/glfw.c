@@ -38,6 +38,12 @@
 #include "../../zahnrad.h"
 #include "../demo.c"
 
+#if ZR_COMPILE_WITH_32BIT_DRAW_INDEX
+#define DRAW_INDEX_TYPE GL_UNSIGNED_INT
+#else
+#define DRAW_INDEX_TYPE GL_UNSIGNED_SHORT
+#endif
+
 /* sign: is there any way to pass a user pointer to glfw? */
 static GLFWwindow *win;
 static int mouse_pos_x = 0;
@@ -355,7 +361,7 @@ device_draw(struct device *dev, struct zr_context *ctx, int width, int height,
             glScissor((GLint)cmd->clip_rect.x,
                 height - (GLint)(cmd->clip_rect.y + cmd->clip_rect.h),
                 (GLint)cmd->clip_rect.w, (GLint)cmd->clip_rect.h);
-            glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, GL_UNSIGNED_SHORT, offset);
+            glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, DRAW_INDEX_TYPE, offset);
             offset += cmd->elem_count;
         }
         zr_clear(ctx);
@@ -0,0 +1,399 @@
+/*
+    Copyright (c) 2016 Micha Mettke
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any damages
+    arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+
+    1.  The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software
+        in a product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+    2.  Altered source versions must be plainly marked as such, and must not be
+        misrepresented as being the original software.
+    3.  This notice may not be removed or altered from any source distribution.
+*/
+/*  Multi context stress test. Builds and converts a number of independent
+    contexts concurrently, one per thread. All contexts share one baked font
+    and its glyph table, which are only read after `zr_font_init`, while
+    every thread owns its context, scene state and vertex buffers. Each
+    context gets the same scripted input, so every thread has to produce
+    exactly the same vertex output each frame as the reference run of a
+    single context on the main thread. Run it built with -fsanitize=thread
+    to check the library for shared mutable state.
+
+    USAGE: contexts [threads] [frames] [ttf font]
+    Without a font a fixed pitch dummy font is used. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../../zahnrad.h"
+
+#define DEFAULT_THREADS 4
+#define DEFAULT_FRAMES 200
+#define MAX_THREADS 64
+#define FONT_HEIGHT 14
+#define UNUSED(a) ((void)(a))
+
+struct scene {
+    /* widget state of one context */
+    int check;
+    int option;
+    int property;
+    float slider;
+    zr_size progress;
+    int selected;
+    char text[64];
+    zr_size text_len;
+};
+
+struct worker {
+    pthread_t thread;
+    const struct zr_user_font *font;
+    struct zr_draw_null_texture null;
+    unsigned long frames;
+    unsigned long *checksums;
+    /* vertex and element hash of every frame */
+    double time;
+};
+
+static void
+die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputs("\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+static char*
+file_load(const char* path, size_t* siz)
+{
+    char *buf;
+    FILE *fd = fopen(path, "rb");
+    if (!fd) die("Failed to open file: %s\n", path);
+    fseek(fd, 0, SEEK_END);
+    *siz = (size_t)ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    buf = (char*)calloc(*siz, 1);
+    if (fread(buf, *siz, 1, fd) != 1)
+        die("Failed to read file: %s\n", path);
+    fclose(fd);
+    return buf;
+}
+
+static double
+timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void* mem_alloc(zr_handle unused, size_t size)
+{UNUSED(unused); return calloc(1, size);}
+static void mem_free(zr_handle unused, void *ptr)
+{UNUSED(unused); free(ptr);}
+
+static unsigned long
+checksum(const void *memory, zr_size size, unsigned long hash)
+{
+    const unsigned char *bytes = (const unsigned char*)memory;
+    zr_size i;
+    for (i = 0; i < size; ++i)
+        hash = (hash * 33u) ^ bytes[i];
+    return hash;
+}
+
+/* ==============================================================
+ *
+ *                          Font
+ *
+ * ===============================================================*/
+static zr_size
+dummy_text_width(zr_handle handle, float height, const char *text, zr_size len)
+{
+    UNUSED(handle);
+    UNUSED(height);
+    return zr_utf_len(text, len) * 7;
+}
+
+static void
+dummy_query_glyph(zr_handle handle, float height, struct zr_user_font_glyph *glyph,
+    zr_rune codepoint, zr_rune next_codepoint)
+{
+    UNUSED(handle);
+    UNUSED(codepoint);
+    UNUSED(next_codepoint);
+    glyph->uv[0] = zr_vec2(0, 0);
+    glyph->uv[1] = zr_vec2(1, 1);
+    glyph->offset = zr_vec2(1, 3);
+    glyph->width = 5;
+    glyph->height = height - 6;
+    glyph->xadvance = 7;
+}
+
+static void
+font_bake(struct zr_font *font, struct zr_font_glyph **glyphes,
+    struct zr_draw_null_texture *null, const char *path)
+{
+    int glyph_count;
+    int img_width, img_height;
+    struct zr_baked_font baked_font;
+    struct zr_recti custom;
+    struct zr_font_config config;
+    void *img, *tmp;
+    size_t ttf_size;
+    size_t tmp_size, img_size;
+    char *ttf_blob = file_load(path, &ttf_size);
+
+    memset(&baked_font, 0, sizeof(baked_font));
+    memset(&custom, 0, sizeof(custom));
+    memset(&config, 0, sizeof(config));
+    config.ttf_blob = ttf_blob;
+    config.ttf_size = ttf_size;
+    config.font = &baked_font;
+    config.coord_type = ZR_COORD_UV;
+    config.range = zr_font_default_glyph_ranges();
+    config.pixel_snap = zr_false;
+    config.size = (float)FONT_HEIGHT;
+    config.spacing = zr_vec2(0,0);
+    config.oversample_h = 1;
+    config.oversample_v = 1;
+
+    zr_font_bake_memory(&tmp_size, &glyph_count, &config, 1);
+    *glyphes = (struct zr_font_glyph*)calloc(sizeof(struct zr_font_glyph), (size_t)glyph_count);
+    tmp = calloc(1, tmp_size);
+    custom.w = 2; custom.h = 2;
+    if (!zr_font_bake_pack(&img_size, &img_width, &img_height, &custom, tmp, tmp_size, &config, 1))
+        die("[Font]: failed to load font!\n");
+    img = calloc(1, img_size);
+    zr_font_bake(img, img_width, img_height, tmp, tmp_size, *glyphes, glyph_count, &config, 1);
+    zr_font_bake_custom_data(img, img_width, img_height, custom, "....", 2, 2, '.', 'X');
+    free(ttf_blob);
+    free(tmp);
+    free(img);
+
+    null->texture = zr_handle_id(1);
+    null->uv = zr_vec2((custom.x + 0.5f)/(float)img_width,
+                        (custom.y + 0.5f)/(float)img_height);
+    zr_font_init(font, (float)FONT_HEIGHT, '?', *glyphes, &baked_font, null->texture);
+}
+
+/* ==============================================================
+ *
+ *                          Scene
+ *
+ * ===============================================================*/
+static void
+input_script(struct zr_context *ctx, unsigned long frame)
+{
+    /* sweeps the mouse over the widgets and clicks from time to time */
+    const int x = 20 + (int)((frame * 11) % 260);
+    const int y = 40 + (int)((frame * 17) % 400);
+
+    zr_input_begin(ctx);
+    zr_input_motion(ctx, x, y);
+    if ((frame % 12) == 0)
+        zr_input_button(ctx, ZR_BUTTON_LEFT, x, y, zr_true);
+    else if ((frame % 12) == 1)
+        zr_input_button(ctx, ZR_BUTTON_LEFT, x, y, zr_false);
+    if ((frame % 40) == 20)
+        zr_input_char(ctx, (char)('a' + (frame / 40) % 26));
+    zr_input_end(ctx);
+}
+
+static void
+scene(struct zr_context *ctx, struct scene *s, unsigned long frame)
+{
+    struct zr_layout layout;
+    static const char *const items[] = {"First", "Second", "Third", "Fourth"};
+
+    if (zr_begin(ctx, &layout, "Widgets", zr_rect(10, 10, 300, 460),
+        ZR_WINDOW_BORDER|ZR_WINDOW_MOVABLE|ZR_WINDOW_TITLE))
+    {
+        struct zr_layout combo;
+        char buffer[32];
+        int i;
+
+        zr_layout_row_dynamic(ctx, 25, 2);
+        zr_label(ctx, "frame:", ZR_TEXT_LEFT);
+        sprintf(buffer, "%lu", frame);
+        zr_label(ctx, buffer, ZR_TEXT_RIGHT);
+        zr_button_text(ctx, "button", ZR_BUTTON_DEFAULT);
+        zr_checkbox(ctx, "check", &s->check);
+        if (zr_option(ctx, "easy", s->option == 0)) s->option = 0;
+        if (zr_option(ctx, "hard", s->option == 1)) s->option = 1;
+
+        zr_layout_row_dynamic(ctx, 25, 1);
+        zr_slider_float(ctx, 0, &s->slider, 1.0f, 0.05f);
+        zr_progress(ctx, &s->progress, 100, zr_true);
+        zr_property_int(ctx, "Property:", 0, &s->property, 100, 5, 1);
+        zr_edit_string(ctx, ZR_EDIT_FIELD, s->text, &s->text_len,
+            sizeof(s->text), zr_filter_default);
+
+        if (zr_combo_begin_text(ctx, &combo, items[s->selected], 200)) {
+            zr_layout_row_dynamic(ctx, 25, 1);
+            for (i = 0; i < (int)(sizeof(items)/sizeof(items[0])); ++i) {
+                if (zr_combo_item(ctx, items[i], ZR_TEXT_LEFT))
+                    s->selected = i;
+            }
+            zr_combo_end(ctx);
+        }
+
+        if (zr_layout_push(ctx, ZR_LAYOUT_NODE, "Chart", ZR_MAXIMIZED)) {
+            zr_layout_row_dynamic(ctx, 80, 1);
+            zr_chart_begin(ctx, ZR_CHART_LINES, 32, -1.0f, 1.0f);
+            for (i = 0; i < 32; ++i)
+                zr_chart_push(ctx, (float)((i + (int)frame) % 16) / 8.0f - 1.0f);
+            zr_chart_end(ctx);
+            zr_layout_pop(ctx);
+        }
+    }
+    zr_end(ctx);
+
+    if (zr_begin(ctx, &layout, "Shapes", zr_rect(320, 10, 200, 200),
+        ZR_WINDOW_BORDER|ZR_WINDOW_TITLE|ZR_WINDOW_NO_SCROLLBAR))
+    {
+        struct zr_command_buffer *canvas = zr_window_get_canvas(ctx);
+        const float x = layout.bounds.x, y = layout.bounds.y;
+        zr_draw_circle(canvas, zr_rect(x + 10, y + 10, 60, 60), zr_rgb(200, 80, 80));
+        zr_draw_curve(canvas, x, y + 120, x + 40, y + 20,
+            x + 140, y + 220, x + 180, y + 120, zr_rgb(80, 200, 80));
+        zr_draw_arc(canvas, x + 130, y + 40, 30, 0.0f, (float)(frame % 60) / 10.0f,
+            zr_rgb(80, 80, 200));
+    }
+    zr_end(ctx);
+}
+
+static void
+run(struct worker *w)
+{
+    unsigned long frame;
+    struct scene s;
+    struct zr_context ctx;
+    struct zr_allocator alloc;
+    struct zr_buffer cmds, vertexes, elements;
+    struct zr_convert_config config;
+    double begin;
+
+    memset(&s, 0, sizeof(s));
+    s.slider = 0.5f;
+    s.property = 20;
+    s.progress = 40;
+    alloc.userdata.ptr = NULL;
+    alloc.alloc = mem_alloc;
+    alloc.free = mem_free;
+    zr_buffer_init(&cmds, &alloc, 1024);
+    zr_buffer_init(&vertexes, &alloc, 64 * 1024);
+    zr_buffer_init(&elements, &alloc, 16 * 1024);
+    zr_init(&ctx, &alloc, w->font);
+
+    memset(&config, 0, sizeof(config));
+    config.shape_AA = ZR_ANTI_ALIASING_ON;
+    config.line_AA = ZR_ANTI_ALIASING_ON;
+    config.circle_segment_count = 22;
+    config.line_thickness = 1.0f;
+    config.null = w->null;
+
+    begin = timestamp();
+    for (frame = 0; frame < w->frames; ++frame) {
+        unsigned long hash;
+        input_script(&ctx, frame);
+        scene(&ctx, &s, frame);
+        zr_convert(&ctx, &cmds, &vertexes, &elements, &config);
+        hash = checksum(zr_buffer_memory(&vertexes), vertexes.allocated, 5381);
+        hash = checksum(zr_buffer_memory(&elements), elements.allocated, hash);
+        w->checksums[frame] = hash;
+        zr_clear(&ctx);
+    }
+    w->time = timestamp() - begin;
+
+    zr_free(&ctx);
+    zr_buffer_free(&cmds);
+    zr_buffer_free(&vertexes);
+    zr_buffer_free(&elements);
+}
+
+static void*
+worker_main(void *arg)
+{
+    run((struct worker*)arg);
+    return NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i, threads = DEFAULT_THREADS;
+    unsigned long frame, frames = DEFAULT_FRAMES;
+    struct zr_font font;
+    struct zr_font_glyph *glyphes = 0;
+    struct zr_user_font usrfnt;
+    struct zr_draw_null_texture null;
+    struct worker reference;
+    struct worker workers[MAX_THREADS];
+    double begin, total;
+
+    if (argc > 1) threads = atoi(argv[1]);
+    if (argc > 2) frames = strtoul(argv[2], NULL, 10);
+    threads = (threads < 1) ? 1 : (threads > MAX_THREADS) ? MAX_THREADS : threads;
+    if (!frames) frames = 1;
+
+    /* the one font shared read-only by all contexts */
+    memset(&usrfnt, 0, sizeof(usrfnt));
+    memset(&null, 0, sizeof(null));
+    if (argc > 3) {
+        font_bake(&font, &glyphes, &null, argv[3]);
+        usrfnt = zr_font_ref(&font);
+    } else {
+        usrfnt.height = FONT_HEIGHT;
+        usrfnt.width = dummy_text_width;
+        usrfnt.query = dummy_query_glyph;
+    }
+
+    memset(&reference, 0, sizeof(reference));
+    reference.font = &usrfnt;
+    reference.null = null;
+    reference.frames = frames;
+    reference.checksums = (unsigned long*)calloc(frames, sizeof(unsigned long));
+    run(&reference);
+
+    begin = timestamp();
+    for (i = 0; i < threads; ++i) {
+        workers[i] = reference;
+        workers[i].checksums = (unsigned long*)calloc(frames, sizeof(unsigned long));
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]))
+            die("[contexts]: failed to create thread");
+    }
+    for (i = 0; i < threads; ++i)
+        pthread_join(workers[i].thread, NULL);
+    total = timestamp() - begin;
+
+    for (i = 0; i < threads; ++i) {
+        for (frame = 0; frame < frames; ++frame) {
+            if (workers[i].checksums[frame] != reference.checksums[frame])
+                die("[contexts]: context %d differs from the reference in frame %lu", i, frame);
+        }
+        free(workers[i].checksums);
+    }
+
+    fprintf(stdout, "contexts: %d  frames: %lu  font: %s\n", threads, frames,
+        (argc > 3) ? "baked" : "dummy");
+    fprintf(stdout, "%-12s %10.3f ms/frame\n", "single", reference.time / ((double)frames * 1e6));
+    fprintf(stdout, "%-12s %10.3f ms/frame\n", "concurrent", total / ((double)frames * 1e6));
+    fprintf(stdout, "all contexts match the reference output\n");
+    free(reference.checksums);
+    free(glyphes);
+    return 0;
+}
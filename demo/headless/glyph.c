@@ -0,0 +1,768 @@
+/*
+    Copyright (c) 2016 Micha Mettke
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any damages
+    arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+
+    1.  The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software
+        in a product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+    2.  Altered source versions must be plainly marked as such, and must not be
+        misrepresented as being the original software.
+    3.  This notice may not be removed or altered from any source distribution.
+*/
+/*  Glyph lookup benchmark. Bakes a font with the chinese and korean glyph
+    ranges and measures text width calculation over CJK text
+    once with the font glyph lookup table and once with the table cleared,
+    which forces `zr_font_find_glyph` back to searching all glyph ranges.
+    Afterwards the same font is loaded from a memory mapped font cache file
+    and set up with `zr_font_init_dynamic` to compare startup time and atlas
+    memory against baking all ranges up front. Text widths of both are
+    checked to match the baked font. Finally a dynamic font with a small atlas
+    cycles through more glyphs than fit into it like a renderer would: glyphs
+    drawn in a frame have to keep their image until the frame is finished and
+    a texture only updated by the dirty rectangles has to match the atlas.
+    With a thread count every font is
+    additionally baked with `zr_font_bake_dispatch` on a small pthread pool
+    and checked to produce the same image and glyphs as the serial baker,
+    and a context with a static style font which pushes the dynamic font
+    for one window is converted with a dispatch callback, which has to fall
+    back to the serial conversion as long as the dynamic font is drawn.
+
+    USAGE: glyph <ttf font> [iterations] [threads] */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include "../../zahnrad.h"
+
+#define FONT_HEIGHT 14
+#define TEXT_GLYPHS 4096
+#define DEFAULT_ITERATIONS 200
+#define ATLAS_WIDTH 512
+#define ATLAS_HEIGHT 512
+#define MAX_THREADS 64
+#define EVICT_WIDTH 128
+#define EVICT_HEIGHT 96
+#define EVICT_FRAMES 200
+#define EVICT_GLYPHS 32
+#define EVICT_STEP 16
+#define EVICT_CODEPOINTS 512
+#define DISPATCH_FRAMES 20
+#define DISPATCH_WINDOWS 4
+
+struct pool {
+    pthread_t threads[MAX_THREADS];
+    int thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    /* current batch of jobs */
+    zr_convert_job_f job;
+    void *data;
+    unsigned int next;
+    unsigned int count;
+    unsigned int finished;
+    unsigned long generation;
+    int quit;
+};
+
+static void
+die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputs("\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+static char*
+file_load(const char* path, size_t* siz)
+{
+    char *buf;
+    FILE *fd = fopen(path, "rb");
+    if (!fd) die("Failed to open file: %s\n", path);
+    fseek(fd, 0, SEEK_END);
+    *siz = (size_t)ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    buf = (char*)calloc(*siz, 1);
+    if (fread(buf, *siz, 1, fd) != 1)
+        die("Failed to read file: %s\n", path);
+    fclose(fd);
+    return buf;
+}
+
+/* ==============================================================
+ *
+ *                      Thread pool
+ *
+ * ===============================================================*/
+static void*
+pool_worker(void *arg)
+{
+    struct pool *pool = (struct pool*)arg;
+    unsigned long generation = 0;
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        while (!pool->quit && pool->generation == generation)
+            pthread_cond_wait(&pool->work, &pool->mutex);
+        if (pool->quit) break;
+        generation = pool->generation;
+        while (pool->next < pool->count) {
+            unsigned int index = pool->next++;
+            pthread_mutex_unlock(&pool->mutex);
+            pool->job(pool->data, index);
+            pthread_mutex_lock(&pool->mutex);
+            if (++pool->finished == pool->count)
+                pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+static void
+pool_dispatch(zr_handle handle, zr_convert_job_f job, void *data, unsigned int count)
+{
+    struct pool *pool = (struct pool*)handle.ptr;
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->data = data;
+    pool->next = 0;
+    pool->count = count;
+    pool->finished = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    while (pool->finished < pool->count)
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void
+pool_init(struct pool *pool, int thread_count)
+{
+    int i;
+    memset(pool, 0, sizeof(*pool));
+    pool->thread_count = thread_count;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i = 0; i < thread_count; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool))
+            die("[pool]: failed to create thread");
+    }
+}
+
+static void
+pool_free(struct pool *pool)
+{
+    int i;
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+    for (i = 0; i < pool->thread_count; ++i)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+}
+
+/* ==============================================================
+ *
+ *                      Font
+ *
+ * ===============================================================*/
+static double
+timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void
+font_config(struct zr_font_config *config, struct zr_baked_font *baked_font,
+    void *ttf_blob, size_t ttf_size, const zr_rune *range)
+{
+    memset(baked_font, 0, sizeof(*baked_font));
+    memset(config, 0, sizeof(*config));
+    config->ttf_blob = ttf_blob;
+    config->ttf_size = ttf_size;
+    config->font = baked_font;
+    config->coord_type = ZR_COORD_UV;
+    config->range = range;
+    config->size = (float)FONT_HEIGHT;
+    config->oversample_h = 1;
+    config->oversample_v = 1;
+}
+
+static FILE*
+cache_write(void *img, int img_width, int img_height, size_t img_size,
+    struct zr_font_glyph *glyphes, int glyph_count, struct zr_baked_font *baked_font,
+    const struct zr_font_config *config)
+{
+    FILE *file;
+    void *memory;
+    size_t size;
+    struct zr_font_cache cache;
+
+    memset(&cache, 0, sizeof(cache));
+    cache.image = img;
+    cache.image_width = img_width;
+    cache.image_height = img_height;
+    cache.image_size = img_size;
+    cache.glyphs = glyphes;
+    cache.glyph_count = glyph_count;
+    cache.fonts = baked_font;
+    cache.font_count = 1;
+    cache.identity = zr_font_cache_identity(config, 1);
+
+    size = zr_font_cache_size(&cache);
+    memory = calloc(1, size);
+    if (!zr_font_cache_store(memory, size, &cache))
+        die("[Font]: failed to store font cache!\n");
+    file = tmpfile();
+    if (!file || fwrite(memory, size, 1, file) != 1 || fflush(file))
+        die("[Font]: failed to write font cache!\n");
+    free(memory);
+    return file;
+}
+
+static void*
+cache_load(struct zr_font *font, FILE *file, size_t *size, void *ttf_blob,
+    size_t ttf_size, const zr_rune *range)
+{
+    void *memory;
+    zr_uint identity;
+    struct zr_font_cache cache;
+    struct zr_font_config config;
+    struct zr_baked_font baked_font;
+
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    memory = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (memory == MAP_FAILED)
+        die("[Font]: failed to map font cache!\n");
+    font_config(&config, &baked_font, ttf_blob, ttf_size, range);
+    identity = zr_font_cache_identity(&config, 1);
+    if (!zr_font_cache_load(&cache, &baked_font, 1, identity, memory, *size))
+        die("[Font]: invalid font cache!\n");
+    zr_font_init(font, (float)FONT_HEIGHT, '?', cache.glyphs, &baked_font, zr_handle_id(0));
+    return memory;
+}
+
+static void*
+font_bake_image(struct zr_font_config *config, struct zr_font_glyph *glyphes,
+    int glyph_count, size_t tmp_size, struct pool *pool, size_t *img_size,
+    int *img_width, int *img_height)
+{
+    void *img, *tmp;
+    tmp = calloc(1, tmp_size);
+    if (!zr_font_bake_pack(img_size, img_width, img_height, 0, tmp, tmp_size, config, 1))
+        die("[Font]: failed to load font!\n");
+    img = calloc(1, *img_size);
+    if (pool) {
+        zr_font_bake_dispatch(img, *img_width, *img_height, tmp, tmp_size, glyphes,
+            glyph_count, config, 1, pool_dispatch, zr_handle_ptr(pool));
+    } else {
+        zr_font_bake(img, *img_width, *img_height, tmp, tmp_size, glyphes,
+            glyph_count, config, 1);
+    }
+    free(tmp);
+    return img;
+}
+
+static void
+font_pack(struct zr_font_pack_report *report, struct zr_font_config *config,
+    size_t tmp_size, int tight)
+{
+    void *tmp;
+    size_t img_size;
+    int img_width, img_height;
+    tmp = calloc(1, tmp_size);
+    if (!(tight ? zr_font_bake_pack_tight: zr_font_bake_pack)(&img_size,
+        &img_width, &img_height, 0, tmp, tmp_size, config, 1))
+        die("[Font]: failed to load font!\n");
+    zr_font_bake_report(report, 0, tmp, 1);
+    free(tmp);
+}
+
+static struct zr_font_glyph*
+font_bake(struct zr_font *font, void *ttf_blob, size_t ttf_size,
+    const zr_rune *range, size_t *memory, FILE **cache, struct pool *pool,
+    double *parallel_time, struct zr_font_pack_report *packed)
+{
+    int glyph_count;
+    int img_width, img_height;
+    struct zr_font_glyph *glyphes;
+    struct zr_baked_font baked_font;
+    struct zr_font_config config;
+    size_t tmp_size, img_size;
+    void *img;
+
+    font_config(&config, &baked_font, ttf_blob, ttf_size, range);
+    zr_font_bake_memory(&tmp_size, &glyph_count, &config, 1);
+    font_pack(&packed[0], &config, tmp_size, 0);
+    font_pack(&packed[1], &config, tmp_size, 1);
+    glyphes = (struct zr_font_glyph*)calloc(sizeof(struct zr_font_glyph), (size_t)glyph_count);
+    img = font_bake_image(&config, glyphes, glyph_count, tmp_size, 0,
+        &img_size, &img_width, &img_height);
+    *cache = cache_write(img, img_width, img_height, img_size, glyphes, glyph_count,
+        &baked_font, &config);
+
+    if (pool) {
+        /* bake again on the thread pool and compare against the serial bake */
+        double begin;
+        void *parallel_img;
+        struct zr_font_glyph *parallel_glyphes;
+        struct zr_baked_font parallel_font;
+        font_config(&config, &parallel_font, ttf_blob, ttf_size, range);
+        parallel_glyphes = (struct zr_font_glyph*)calloc(sizeof(struct zr_font_glyph), (size_t)glyph_count);
+        begin = timestamp();
+        parallel_img = font_bake_image(&config, parallel_glyphes, glyph_count,
+            tmp_size, pool, &img_size, &img_width, &img_height);
+        *parallel_time = timestamp() - begin;
+        if (memcmp(img, parallel_img, img_size) ||
+            memcmp(glyphes, parallel_glyphes, (size_t)glyph_count * sizeof(*glyphes)))
+            die("[Font]: parallel bake does not match serial bake!\n");
+        free(parallel_glyphes);
+        free(parallel_img);
+    }
+    free(img);
+
+    zr_font_init(font, (float)FONT_HEIGHT, '?', glyphes, &baked_font, zr_handle_id(0));
+    *memory = img_size + (size_t)glyph_count * sizeof(struct zr_font_glyph);
+    return glyphes;
+}
+
+static void*
+font_dynamic(struct zr_font *font, void *ttf_blob, size_t ttf_size,
+    const zr_rune *range, size_t *memory)
+{
+    void *atlas;
+    struct zr_baked_font baked_font;
+    struct zr_font_config config;
+
+    font_config(&config, &baked_font, ttf_blob, ttf_size, range);
+    zr_font_dynamic_memory(memory, ATLAS_WIDTH, ATLAS_HEIGHT, &config);
+    atlas = calloc(1, *memory);
+    if (!zr_font_init_dynamic(font, (float)FONT_HEIGHT, '?', 0, atlas, *memory,
+        ATLAS_WIDTH, ATLAS_HEIGHT, &config, zr_handle_id(0)))
+        die("[Font]: failed to setup dynamic font!\n");
+    return atlas;
+}
+
+static zr_size
+text_generate(char *buffer, zr_size size, const zr_rune *range)
+{
+    /* spreads codepoints over all ranges of the font while mixing in ascii */
+    zr_size len = 0;
+    int count = 0, i;
+    while (range[count*2] && range[count*2+1]) count++;
+    for (i = 0; i < TEXT_GLYPHS; ++i) {
+        zr_rune unicode;
+        const zr_rune *r = &range[((i * 7) % count) * 2];
+        if ((i % 5) == 0) unicode = (zr_rune)('a' + (i % 26));
+        else unicode = r[0] + (zr_rune)((i * 131) % (int)(r[1] - r[0] + 1));
+        len += zr_utf_encode(unicode, buffer + len, size - len);
+    }
+    return len;
+}
+
+static double
+run(const struct zr_user_font *font, const char *text, zr_size len,
+    int iterations, zr_size *width)
+{
+    int i;
+    double begin, end;
+    begin = timestamp();
+    for (i = 0; i < iterations; ++i)
+        *width = font->width(font->userdata, font->height, text, len);
+    end = timestamp();
+    return (end - begin) / ((double)iterations * TEXT_GLYPHS);
+}
+
+static void
+bench(const char *name, void *ttf_blob, size_t ttf_size, const zr_rune *range,
+    int iterations, struct pool *pool)
+{
+    static char text[TEXT_GLYPHS * ZR_UTF_SIZE];
+    struct zr_font font;
+    struct zr_user_font user;
+    struct zr_font_glyph *glyphes;
+    zr_size len, table_width, search_width, dynamic_width, cache_width;
+    double table, search, first, dynamic, begin, bake_time, init_time, load_time;
+    double parallel_time = 0;
+    struct zr_font_pack_report packed[2];
+    int i;
+    size_t bake_memory, init_memory, cache_size;
+    struct zr_recti dirty;
+    void *atlas, *mapped;
+    FILE *cache;
+
+    begin = timestamp();
+    glyphes = font_bake(&font, ttf_blob, ttf_size, range, &bake_memory, &cache,
+        pool, &parallel_time, packed);
+    bake_time = timestamp() - begin - parallel_time;
+    user = zr_font_ref(&font);
+    len = text_generate(text, sizeof(text), range);
+
+    table = run(&user, text, len, iterations, &table_width);
+    memset(font.pages, 0, sizeof(font.pages));
+    search = run(&user, text, len, iterations, &search_width);
+    if (table_width != search_width)
+        die("[%s]: width mismatch %lu != %lu\n", name,
+            (unsigned long)table_width, (unsigned long)search_width);
+
+    fprintf(stdout, "%-10s glyphs: %6lu  search: %8.2f ns/glyph  table: %8.2f ns/glyph  speedup: %.2fx\n",
+        name, (unsigned long)font.glyph_count, search, table, search / table);
+    free(glyphes);
+
+    /* glyphs of the cached font are used straight from the mapped file */
+    begin = timestamp();
+    mapped = cache_load(&font, cache, &cache_size, ttf_blob, ttf_size, range);
+    load_time = timestamp() - begin;
+    {
+        /* the same cache must not be loaded for a font baked at another size */
+        struct zr_font_cache other;
+        struct zr_baked_font other_font;
+        struct zr_font_config config;
+        font_config(&config, &other_font, ttf_blob, ttf_size, range);
+        config.size += 1.0f;
+        if (zr_font_cache_load(&other, &other_font, 1, zr_font_cache_identity(&config, 1),
+            mapped, cache_size))
+            die("[%s]: font cache loaded for another font size\n", name);
+    }
+    user = zr_font_ref(&font);
+    run(&user, text, len, 1, &cache_width);
+    if (cache_width != table_width)
+        die("[%s]: cache width mismatch %lu != %lu\n", name,
+            (unsigned long)cache_width, (unsigned long)table_width);
+    munmap(mapped, cache_size);
+    fclose(cache);
+
+    /* only glyphs inside the text are rasterized by the dynamic font */
+    begin = timestamp();
+    atlas = font_dynamic(&font, ttf_blob, ttf_size, range, &init_memory);
+    init_time = timestamp() - begin;
+    user = zr_font_ref(&font);
+    first = run(&user, text, len, 1, &dynamic_width);
+    zr_font_dynamic_update(&font, &dirty);
+    dynamic = run(&user, text, len, iterations, &dynamic_width);
+    if (dynamic_width != table_width)
+        die("[%s]: dynamic width mismatch %lu != %lu\n", name,
+            (unsigned long)dynamic_width, (unsigned long)table_width);
+
+    fprintf(stdout, "%-10s bake: %8.2f ms %8lu KB  cache: %6.2f ms  dynamic: %6.2f ms %6lu KB  first: %8.2f ns/glyph  cached: %6.2f ns/glyph\n",
+        "", bake_time / 1e6, (unsigned long)(bake_memory / 1024), load_time / 1e6,
+        init_time / 1e6, (unsigned long)(init_memory / 1024), first, dynamic);
+    if (pool) {
+        fprintf(stdout, "%-10s parallel bake: %8.2f ms  threads: %d  speedup: %.2fx\n",
+            "", parallel_time / 1e6, pool->thread_count, bake_time / parallel_time);
+    }
+    for (i = 0; i < 2; ++i) {
+        fprintf(stdout, "%-10s %s pack: %5dx%-5d  fill: %5.1f%%  wasted: %6lu KB  packed: %d/%d\n",
+            "", (i) ? "tight  ": "default", packed[i].width, packed[i].height,
+            packed[i].fill * 100.0f, (unsigned long)(packed[i].wasted / 1024),
+            packed[i].total.packed_count, packed[i].total.glyph_count);
+    }
+    free(atlas);
+}
+
+static zr_uint
+glyph_hash(const unsigned char *image, int width, const struct zr_font_glyph *g)
+{
+    /* FNV-1a hash of the atlas pixels covered by the glyph image */
+    int x, y;
+    zr_uint hash = 2166136261u;
+    const int x0 = (int)(g->u0 * EVICT_WIDTH + 0.5f);
+    const int y0 = (int)(g->v0 * EVICT_HEIGHT + 0.5f);
+    const int x1 = (int)(g->u1 * EVICT_WIDTH + 0.5f);
+    const int y1 = (int)(g->v1 * EVICT_HEIGHT + 0.5f);
+    for (y = y0; y < y1; ++y) {
+        for (x = x0; x < x1; ++x)
+            hash = (hash ^ image[x + y * width]) * 16777619u;
+    }
+    return hash;
+}
+
+static void
+evict(void *ttf_blob, size_t ttf_size)
+{
+    /* draws a window of glyphs sliding over more codepoints than fit into a
+     * small atlas, so pages are cleared and refilled all the time */
+    static zr_rune codepoints[EVICT_CODEPOINTS];
+    struct zr_font_glyph drawn[EVICT_GLYPHS];
+    zr_uint hashes[EVICT_GLYPHS];
+    struct zr_font_glyph last[EVICT_GLYPHS];
+    zr_uint last_hashes[EVICT_GLYPHS];
+    int i, frame, count = 0, last_count = 0;
+    int reused = 0, dropped = 0, uploads = 0;
+    const zr_rune *range = zr_font_cyrillic_glyph_ranges();
+    struct zr_baked_font baked_font;
+    struct zr_font_config config;
+    struct zr_font font;
+    struct zr_recti dirty;
+    unsigned char *image, *texture;
+    size_t memory;
+    void *atlas;
+    int w, h;
+
+    for (i = 0; range[i*2] && count < EVICT_CODEPOINTS; ++i) {
+        zr_rune unicode = (range[i*2] < 0x21) ? 0x21: range[i*2];
+        for (; unicode <= range[i*2+1] && count < EVICT_CODEPOINTS; ++unicode)
+            codepoints[count++] = unicode;
+    }
+
+    font_config(&config, &baked_font, ttf_blob, ttf_size, range);
+    zr_font_dynamic_memory(&memory, EVICT_WIDTH, EVICT_HEIGHT, &config);
+    atlas = calloc(1, memory);
+    if (!zr_font_init_dynamic(&font, (float)FONT_HEIGHT, '?', 0, atlas, memory,
+        EVICT_WIDTH, EVICT_HEIGHT, &config, zr_handle_id(0)))
+        die("[Font]: failed to setup dynamic font!\n");
+    image = (unsigned char*)zr_font_dynamic_image(&font, &w, &h);
+    texture = (unsigned char*)calloc(1, (size_t)(w * h));
+
+    for (frame = 0; frame < EVICT_FRAMES; ++frame) {
+        for (i = 0; i < EVICT_GLYPHS; ++i) {
+            const zr_rune unicode = codepoints[(frame * EVICT_STEP + i) % count];
+            drawn[i] = *zr_font_find_glyph(&font, unicode);
+            if (drawn[i].x1 <= drawn[i].x0 || drawn[i].y1 <= drawn[i].y0)
+                dropped++;
+            hashes[i] = glyph_hash(image, w, &drawn[i]);
+        }
+        /* later lookups of the frame must not clear pages drawn from */
+        for (i = 0; i < EVICT_GLYPHS; ++i) {
+            if (glyph_hash(image, w, &drawn[i]) != hashes[i])
+                die("[evict]: glyph %x changed in the frame it was drawn in\n",
+                    drawn[i].codepoint);
+        }
+        /* glyph images of the last frame replaced by new ones */
+        for (i = 0; i < last_count; ++i)
+            reused += (glyph_hash(image, w, &last[i]) != last_hashes[i]);
+
+        /* upload only the dirty rectangle into the texture */
+        if (zr_font_dynamic_update(&font, &dirty)) {
+            int y;
+            if (dirty.x < 0 || dirty.y < 0 || dirty.x + dirty.w > w || dirty.y + dirty.h > h)
+                die("[evict]: dirty rectangle outside of the atlas\n");
+            for (y = dirty.y; y < dirty.y + dirty.h; ++y)
+                memcpy(texture + y * w + dirty.x, image + y * w + dirty.x, (size_t)dirty.w);
+            uploads++;
+        }
+        if (memcmp(texture, image, (size_t)(w * h)))
+            die("[evict]: dirty rectangle missed changed atlas pixels in frame %d\n", frame);
+        memcpy(last, drawn, sizeof(drawn));
+        memcpy(last_hashes, hashes, sizeof(hashes));
+        last_count = EVICT_GLYPHS;
+    }
+    if (!reused)
+        die("[evict]: atlas pages were never cleared\n");
+
+    fprintf(stdout, "%-10s atlas: %dx%d  glyphs: %d  frames: %d  uploads: %d  replaced: %d  without image: %d\n",
+        "evict", w, h, count, EVICT_FRAMES, uploads, reused, dropped);
+    free(texture);
+    free(atlas);
+}
+
+/* ==============================================================
+ *
+ *                      Dispatch
+ *
+ * ===============================================================*/
+static unsigned int dispatch_calls;
+
+static void
+counting_dispatch(zr_handle handle, zr_convert_job_f job, void *data, unsigned int count)
+{
+    dispatch_calls++;
+    pool_dispatch(handle, job, data, count);
+}
+
+static void* mem_alloc(zr_handle unused, zr_size size)
+{(void)unused; return calloc(1, size);}
+static void mem_free(zr_handle unused, void *ptr)
+{(void)unused; free(ptr);}
+
+static zr_size
+fixed_text_width(zr_handle handle, float height, const char *text, zr_size len)
+{
+    (void)handle; (void)height;
+    return zr_utf_len(text, len) * 7;
+}
+
+static void
+fixed_query_glyph(zr_handle handle, float height, struct zr_user_font_glyph *glyph,
+    zr_rune codepoint, zr_rune next_codepoint)
+{
+    (void)handle; (void)codepoint; (void)next_codepoint;
+    memset(glyph, 0, sizeof(*glyph));
+    glyph->width = 7;
+    glyph->height = height;
+    glyph->xadvance = 7;
+}
+
+static void
+dispatch_frame(struct zr_context *ctx, struct zr_user_font *pushed, int frame)
+{
+    /* windows drawn with the static style font and one which pushes the
+     * dynamic font, which parallel conversion jobs must never look up */
+    int i;
+    char buffer[32];
+    struct zr_layout layout;
+
+    zr_input_begin(ctx);
+    zr_input_end(ctx);
+    for (i = 0; i < DISPATCH_WINDOWS; ++i) {
+        sprintf(buffer, "Window %d", i);
+        if (zr_begin(ctx, &layout, buffer, zr_rect((float)i * 110, 0, 100, 200), 0)) {
+            zr_layout_row_dynamic(ctx, 20, 1);
+            if (pushed && i == DISPATCH_WINDOWS-1)
+                zr_push_font(ctx, *pushed);
+            sprintf(buffer, "frame %d", frame);
+            zr_label(ctx, buffer, ZR_TEXT_LEFT);
+            zr_label(ctx, "Lorem ipsum dolor", ZR_TEXT_LEFT);
+            if (pushed && i == DISPATCH_WINDOWS-1)
+                zr_pop_font(ctx);
+        }
+        zr_end(ctx);
+    }
+}
+
+static void
+dispatch(void *ttf_blob, size_t ttf_size, struct pool *pool)
+{
+    /* `zr_convert` must fall back to converting on the calling thread as
+     * soon as any text of the frame uses a dynamic font, even if the style
+     * font of the context is static */
+    struct zr_baked_font baked_font;
+    struct zr_font_config config;
+    struct zr_font font;
+    struct zr_user_font style, dynamic;
+    struct zr_allocator alloc;
+    struct zr_context ctx, serial_ctx;
+    struct zr_convert_config convert;
+    struct zr_buffer cmds, vertexes, elements;
+    unsigned int pushed_calls, plain_calls;
+    size_t memory;
+    void *atlas, *serial;
+    int frame;
+
+    font_config(&config, &baked_font, ttf_blob, ttf_size, zr_font_default_glyph_ranges());
+    zr_font_dynamic_memory(&memory, ATLAS_WIDTH, ATLAS_HEIGHT, &config);
+    atlas = calloc(1, memory);
+    if (!zr_font_init_dynamic(&font, (float)FONT_HEIGHT, '?', 0, atlas, memory,
+        ATLAS_WIDTH, ATLAS_HEIGHT, &config, zr_handle_id(0)))
+        die("[Font]: failed to setup dynamic font!\n");
+    dynamic = zr_font_ref(&font);
+
+    memset(&style, 0, sizeof(style));
+    style.height = FONT_HEIGHT;
+    style.width = fixed_text_width;
+    style.query = fixed_query_glyph;
+    alloc.userdata.ptr = NULL;
+    alloc.alloc = mem_alloc;
+    alloc.free = mem_free;
+    zr_init(&ctx, &alloc, &style);
+    zr_init(&serial_ctx, &alloc, &style);
+    zr_buffer_init(&cmds, &alloc, 4096);
+    zr_buffer_init(&vertexes, &alloc, 4096);
+    zr_buffer_init(&elements, &alloc, 4096);
+
+    memset(&convert, 0, sizeof(convert));
+    convert.shape_AA = ZR_ANTI_ALIASING_ON;
+    convert.line_AA = ZR_ANTI_ALIASING_ON;
+    convert.circle_segment_count = 22;
+    convert.line_thickness = 1.0f;
+    convert.userdata = zr_handle_ptr(pool);
+
+    /* frames with the pushed dynamic font have to produce the same output
+     * as a second context converted without dispatch callback */
+    dispatch_calls = 0;
+    for (frame = 0; frame < DISPATCH_FRAMES; ++frame) {
+        dispatch_frame(&serial_ctx, &dynamic, frame);
+        convert.dispatch = 0;
+        zr_convert(&serial_ctx, &cmds, &vertexes, &elements, &convert);
+        memory = vertexes.allocated;
+        serial = malloc(memory);
+        memcpy(serial, vertexes.memory.ptr, memory);
+        zr_clear(&serial_ctx);
+
+        dispatch_frame(&ctx, &dynamic, frame);
+        convert.dispatch = counting_dispatch;
+        zr_convert(&ctx, &cmds, &vertexes, &elements, &convert);
+        if (memory != vertexes.allocated || memcmp(serial, vertexes.memory.ptr, memory))
+            die("[dispatch]: output differs from the serial conversion in frame %d\n", frame);
+        free(serial);
+        zr_clear(&ctx);
+    }
+    pushed_calls = dispatch_calls;
+
+    /* without the pushed font the windows are converted in parallel again */
+    dispatch_calls = 0;
+    for (frame = 0; frame < DISPATCH_FRAMES; ++frame) {
+        dispatch_frame(&ctx, 0, frame);
+        zr_convert(&ctx, &cmds, &vertexes, &elements, &convert);
+        zr_clear(&ctx);
+    }
+    plain_calls = dispatch_calls;
+    if (pushed_calls)
+        die("[dispatch]: text in a pushed dynamic font was converted in parallel\n");
+    if (plain_calls != DISPATCH_FRAMES)
+        die("[dispatch]: frames without dynamic font were not dispatched\n");
+
+    fprintf(stdout, "%-10s frames: %d  dispatched with pushed dynamic font: %u  without: %u\n",
+        "dispatch", DISPATCH_FRAMES, pushed_calls, plain_calls);
+    zr_buffer_free(&cmds);
+    zr_buffer_free(&vertexes);
+    zr_buffer_free(&elements);
+    zr_free(&ctx);
+    zr_free(&serial_ctx);
+    free(atlas);
+}
+
+int
+main(int argc, char *argv[])
+{
+    size_t ttf_size;
+    char *ttf_blob;
+    int iterations = DEFAULT_ITERATIONS;
+    int threads = 0;
+    struct pool pool;
+
+    if (argc < 2)
+        die("Missing TTF Font file argument!");
+    if (argc > 2) iterations = atoi(argv[2]);
+    if (argc > 3) threads = atoi(argv[3]);
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    ttf_blob = file_load(argv[1], &ttf_size);
+    if (threads > 0)
+        pool_init(&pool, threads);
+
+    bench("chinese", ttf_blob, ttf_size, zr_font_chinese_glyph_ranges(),
+        iterations, (threads > 0) ? &pool: 0);
+    bench("korean", ttf_blob, ttf_size, zr_font_korean_glyph_ranges(),
+        iterations, (threads > 0) ? &pool: 0);
+    bench("cyrillic", ttf_blob, ttf_size, zr_font_cyrillic_glyph_ranges(),
+        iterations, (threads > 0) ? &pool: 0);
+    evict(ttf_blob, ttf_size);
+    if (threads > 0) {
+        dispatch(ttf_blob, ttf_size, &pool);
+        pool_free(&pool);
+    }
+    free(ttf_blob);
+    return 0;
+}
@@ -0,0 +1,811 @@
+/*
+    Copyright (c) 2016 Micha Mettke
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any damages
+    arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+
+    1.  The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software
+        in a product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+    2.  Altered source versions must be plainly marked as such, and must not be
+        misrepresented as being the original software.
+    3.  This notice may not be removed or altered from any source distribution.
+*/
+/*  Headless frame benchmark. Runs `demo/demo.c` without any window system
+    by feeding a scripted input stream into the context, walking the command
+    queue and converting it into vertexes. Each frame is split into three
+    timed phases:
+        - ui-build: input + all `zr_begin`/`zr_end` calls inside `run_demo`
+        - cmd-walk: iterating the command queue with `zr_foreach`
+        - convert:  vertex buffer conversion with `zr_convert`
+    The input script only depends on the frame index, so two runs with the
+    same frame count and font produce the same output and can be compared.
+    Before the benchmark a small context checks that a `ZR_WINDOW_CACHED`
+    window keeps its commands over `zr_clear` and is rebuilt after
+    `zr_window_invalidate` and after input inside of it, a window opened
+    after a few frames has to fit into command memory reserved with
+    `zr_reserve`, and a text heavy
+    window is converted once without and once with `text_cache_size` for a
+    user font with an artificially costly glyph query, which has to produce
+    the same vertexes and shows the win of the cached glyph runs.
+
+    USAGE: headless [frames] [ttf font]
+    Without a font a fixed pitch dummy font is used, which makes the run
+    independent from font baking and the files on disk. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+/* macros */
+#define DEFAULT_FRAMES 1000
+#define FONT_HEIGHT 14
+#define DUMMY_GLYPH_WIDTH 7
+#define MAX_DAMAGE 16
+#define RESERVE_FRAMES 20
+#define RESERVE_OPEN_FRAME 10
+#define RESERVE_LINES 500
+#define TEXT_CACHE_FRAMES 200
+#define TEXT_CACHE_LINES 40
+#define TEXT_CACHE_SIZE (64 * 1024)
+#define QUERY_COST 64
+
+#include "../../zahnrad.h"
+#include "../demo.c"
+
+struct phase {
+    const char *name;
+    double total;
+    double min;
+    double max;
+};
+
+enum phase_type {
+    PHASE_BUILD,
+    PHASE_WALK,
+    PHASE_CHANGED,
+    PHASE_DAMAGE,
+    PHASE_CONVERT,
+    PHASE_MAX
+};
+
+enum memory_type {
+    MEMORY_COMMANDS,
+    MEMORY_DRAW_LIST,
+    MEMORY_VERTEXES,
+    MEMORY_ELEMENTS,
+    MEMORY_MAX
+};
+
+struct stats {
+    struct phase phases[PHASE_MAX];
+    struct zr_memory_status memory[MEMORY_MAX];
+    /* peak buffer usage over all frames */
+    unsigned long commands[ZR_COMMAND_IMAGE+1];
+    unsigned long command_count;
+    unsigned long command_max;
+    unsigned long draw_count;
+    unsigned long unchanged;
+    unsigned long width_hits;
+    unsigned long width_misses;
+    unsigned long damage_count;
+    double damage_area;
+    unsigned long vertex_count;
+    unsigned long vertex_max;
+    unsigned long element_count;
+    unsigned long element_max;
+    unsigned long overflows;
+    unsigned long frames;
+};
+
+struct device {
+    struct zr_buffer cmds;
+    struct zr_buffer vertexes;
+    struct zr_buffer elements;
+    struct zr_draw_null_texture null;
+    struct zr_font font;
+    struct zr_font_glyph *glyphes;
+};
+
+/* ==============================================================
+ *
+ *                      Utility
+ *
+ * ===============================================================*/
+static void
+die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputs("\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+static char*
+file_load(const char* path, size_t* siz)
+{
+    char *buf;
+    FILE *fd = fopen(path, "rb");
+    if (!fd) die("Failed to open file: %s\n", path);
+    fseek(fd, 0, SEEK_END);
+    *siz = (size_t)ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    buf = (char*)calloc(*siz, 1);
+    if (fread(buf, *siz, 1, fd) != 1)
+        die("Failed to read file: %s\n", path);
+    fclose(fd);
+    return buf;
+}
+
+static double
+timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void* mem_alloc(zr_handle unused, size_t size)
+{UNUSED(unused); return calloc(1, size);}
+static void mem_free(zr_handle unused, void *ptr)
+{UNUSED(unused); free(ptr);}
+
+/* ==============================================================
+ *
+ *                      Font
+ *
+ * ===============================================================*/
+static zr_size
+dummy_text_width(zr_handle handle, float height, const char *text, zr_size len)
+{
+    UNUSED(handle);
+    UNUSED(height);
+    return zr_utf_len(text, len) * DUMMY_GLYPH_WIDTH;
+}
+
+static void
+dummy_query_glyph(zr_handle handle, float height, struct zr_user_font_glyph *glyph,
+    zr_rune codepoint, zr_rune next_codepoint)
+{
+    UNUSED(handle);
+    UNUSED(codepoint);
+    UNUSED(next_codepoint);
+    glyph->uv[0] = zr_vec2(0, 0);
+    glyph->uv[1] = zr_vec2(0, 0);
+    glyph->offset = zr_vec2(0, 0);
+    glyph->width = DUMMY_GLYPH_WIDTH;
+    glyph->height = height;
+    glyph->xadvance = DUMMY_GLYPH_WIDTH;
+}
+
+static struct zr_user_font
+font_dummy(struct device *dev)
+{
+    struct zr_user_font user_font;
+    memset(&user_font, 0, sizeof(user_font));
+    user_font.height = FONT_HEIGHT;
+    user_font.width = dummy_text_width;
+    user_font.query = dummy_query_glyph;
+    user_font.texture = dev->null.texture;
+    return user_font;
+}
+
+static struct zr_user_font
+font_bake(struct device *dev, const char *path)
+{
+    int glyph_count;
+    int img_width, img_height;
+    struct zr_baked_font baked_font;
+    struct zr_recti custom;
+    struct zr_font_config config;
+    void *img, *tmp;
+    size_t ttf_size;
+    size_t tmp_size, img_size;
+    char *ttf_blob = file_load(path, &ttf_size);
+
+    memset(&baked_font, 0, sizeof(baked_font));
+    memset(&custom, 0, sizeof(custom));
+    memset(&config, 0, sizeof(config));
+    config.ttf_blob = ttf_blob;
+    config.ttf_size = ttf_size;
+    config.font = &baked_font;
+    config.coord_type = ZR_COORD_UV;
+    config.range = zr_font_default_glyph_ranges();
+    config.pixel_snap = zr_false;
+    config.size = (float)FONT_HEIGHT;
+    config.spacing = zr_vec2(0,0);
+    config.oversample_h = 1;
+    config.oversample_v = 1;
+
+    /* bake font into an image which is only kept as long as needed */
+    zr_font_bake_memory(&tmp_size, &glyph_count, &config, 1);
+    dev->glyphes = (struct zr_font_glyph*)calloc(sizeof(struct zr_font_glyph), (size_t)glyph_count);
+    tmp = calloc(1, tmp_size);
+    custom.w = 2; custom.h = 2;
+    if (!zr_font_bake_pack(&img_size, &img_width, &img_height, &custom, tmp, tmp_size, &config, 1))
+        die("[Font]: failed to load font!\n");
+    img = calloc(1, img_size);
+    zr_font_bake(img, img_width, img_height, tmp, tmp_size, dev->glyphes, glyph_count, &config, 1);
+    zr_font_bake_custom_data(img, img_width, img_height, custom, "....", 2, 2, '.', 'X');
+    free(ttf_blob);
+    free(tmp);
+    free(img);
+
+    dev->null.uv = zr_vec2((custom.x + 0.5f)/(float)img_width,
+                            (custom.y + 0.5f)/(float)img_height);
+    zr_font_init(&dev->font, (float)FONT_HEIGHT, '?', dev->glyphes,
+                &baked_font, dev->null.texture);
+    return zr_font_ref(&dev->font);
+}
+
+/* ==============================================================
+ *
+ *                      Input script
+ *
+ * ===============================================================*/
+static void
+input_script(struct zr_context *ctx, unsigned long frame)
+{
+    /* the mouse sweeps over the right part of the demo window which is not
+     * covered by the "Show" window and clicks, scrolls and types from time
+     * to time so tree nodes, popups and edit fields change their state */
+    const int x = 230 + (int)((frame * 7) % 190);
+    const int y = 110 + (int)((frame * 13) % 500);
+
+    zr_input_begin(ctx);
+    zr_input_motion(ctx, x, y);
+    if ((frame % 30) == 0)
+        zr_input_button(ctx, ZR_BUTTON_LEFT, x, y, zr_true);
+    else if ((frame % 30) == 1)
+        zr_input_button(ctx, ZR_BUTTON_LEFT, x, y, zr_false);
+    if ((frame % 50) == 25)
+        zr_input_scroll(ctx, ((frame / 50) & 1) ? 1.0f : -1.0f);
+    if ((frame % 4) == 0)
+        zr_input_char(ctx, (char)('a' + (char)(frame % 26)));
+    zr_input_end(ctx);
+}
+
+/* ==============================================================
+ *
+ *                      Benchmark
+ *
+ * ===============================================================*/
+static void
+phase_add(struct phase *p, double ns)
+{
+    p->total += ns;
+    if (ns < p->min || p->min == 0) p->min = ns;
+    if (ns > p->max) p->max = ns;
+}
+
+static void
+memory_add(struct zr_memory_status *peak, struct zr_buffer *buffer)
+{
+    struct zr_memory_status status;
+    zr_buffer_info(&status, buffer);
+    peak->size = MAX(peak->size, status.size);
+    peak->allocated = MAX(peak->allocated, status.allocated);
+    peak->needed = MAX(peak->needed, status.needed);
+    peak->calls = MAX(peak->calls, status.calls);
+}
+
+static int
+frame(struct device *dev, struct demo *gui, struct stats *s)
+{
+    int running;
+    double begin, end;
+    unsigned long cmd_count = 0;
+    struct zr_context *ctx = &gui->ctx;
+
+    /* UI build */
+    begin = timestamp();
+    input_script(ctx, s->frames);
+    running = run_demo(gui);
+    end = timestamp();
+    phase_add(&s->phases[PHASE_BUILD], end - begin);
+
+    /* command walk */
+    begin = timestamp();
+    {
+        const struct zr_command *cmd;
+        zr_foreach(cmd, ctx) {
+            s->commands[cmd->type]++;
+            cmd_count++;
+        }
+    }
+    end = timestamp();
+    phase_add(&s->phases[PHASE_WALK], end - begin);
+    s->command_count += cmd_count;
+    s->command_max = MAX(s->command_max, cmd_count);
+
+    /* frame change check */
+    begin = timestamp();
+    if (!zr_frame_changed(ctx))
+        s->unchanged++;
+    end = timestamp();
+    phase_add(&s->phases[PHASE_CHANGED], end - begin);
+
+    /* damage */
+    begin = timestamp();
+    {
+        int i, count;
+        struct zr_rect damage[MAX_DAMAGE];
+        count = zr_damage(ctx, damage, MAX_DAMAGE);
+        end = timestamp();
+        for (i = 0; i < count; ++i)
+            s->damage_area += (double)(damage[i].w * damage[i].h);
+        s->damage_count += (unsigned long)count;
+    }
+    phase_add(&s->phases[PHASE_DAMAGE], end - begin);
+
+    /* convert */
+    begin = timestamp();
+    {
+        struct zr_convert_config config;
+        memset(&config, 0, sizeof(config));
+        config.shape_AA = ZR_ANTI_ALIASING_ON;
+        config.line_AA = ZR_ANTI_ALIASING_ON;
+        config.circle_segment_count = 22;
+        config.line_thickness = 1.0f;
+        config.null = dev->null;
+        zr_convert(ctx, &dev->cmds, &dev->vertexes, &dev->elements, &config);
+    }
+    end = timestamp();
+    phase_add(&s->phases[PHASE_CONVERT], end - begin);
+
+    {
+        const struct zr_draw_command *cmd;
+        zr_draw_foreach(cmd, ctx, &dev->cmds)
+            s->draw_count++;
+    }
+    s->vertex_count += ctx->canvas.vertex_count;
+    s->vertex_max = MAX(s->vertex_max, ctx->canvas.vertex_count);
+    s->element_count += ctx->canvas.element_count;
+    s->element_max = MAX(s->element_max, ctx->canvas.element_count);
+    if (ctx->canvas.overflow)
+        s->overflows++;
+    memory_add(&s->memory[MEMORY_COMMANDS], &ctx->memory);
+    memory_add(&s->memory[MEMORY_DRAW_LIST], &dev->cmds);
+    memory_add(&s->memory[MEMORY_VERTEXES], &dev->vertexes);
+    memory_add(&s->memory[MEMORY_ELEMENTS], &dev->elements);
+    s->frames++;
+    zr_clear(ctx);
+    return running;
+}
+
+static void
+print_stats(struct stats *s)
+{
+    int i;
+    double total = 0;
+    const double n = (double)MAX(s->frames, 1);
+    static const char *command_names[] = {
+        "nop", "scissor", "line", "curve", "rect",
+        "circle", "arc", "triangle", "text", "image"
+    };
+    static const char *memory_names[] = {
+        "commands", "draw list", "vertexes", "elements"
+    };
+
+    fprintf(stdout, "frames: %lu\n\n", s->frames);
+    fprintf(stdout, "%-10s %14s %14s %14s\n", "phase", "ns/frame", "min", "max");
+    for (i = 0; i < PHASE_MAX; ++i) {
+        const struct phase *p = &s->phases[i];
+        fprintf(stdout, "%-10s %14.0f %14.0f %14.0f\n", p->name,
+            p->total / n, p->min, p->max);
+        total += p->total;
+    }
+    fprintf(stdout, "%-10s %14.0f\n\n", "total", total / n);
+
+    fprintf(stdout, "commands/frame: %.1f (max %lu)\n", (double)s->command_count/n, s->command_max);
+    for (i = 0; i < (int)LEN(command_names); ++i) {
+        if (!s->commands[i]) continue;
+        fprintf(stdout, "    %-10s %10.1f\n", command_names[i], (double)s->commands[i]/n);
+    }
+    fprintf(stdout, "unchanged frames: %lu\n", s->unchanged);
+    fprintf(stdout, "text widths/frame: %.1f cached, %.1f measured\n",
+        (double)s->width_hits/n, (double)s->width_misses/n);
+    fprintf(stdout, "damaged rects/frame: %.1f (%.1f%% of the screen)\n",
+        (double)s->damage_count/n, 100.0 * s->damage_area / (n * WINDOW_WIDTH * WINDOW_HEIGHT));
+    fprintf(stdout, "draw commands/frame: %.1f\n", (double)s->draw_count/n);
+    fprintf(stdout, "vertexes/frame: %.1f (max %lu)\n", (double)s->vertex_count/n, s->vertex_max);
+    fprintf(stdout, "elements/frame: %.1f (max %lu)\n", (double)s->element_count/n, s->element_max);
+    fprintf(stdout, "frames with dropped shapes: %lu\n\n", s->overflows);
+
+    fprintf(stdout, "%-10s %10s %10s %10s %8s\n", "memory(peak)",
+        "size", "allocated", "needed", "calls");
+    for (i = 0; i < MEMORY_MAX; ++i) {
+        const struct zr_memory_status *m = &s->memory[i];
+        fprintf(stdout, "%-12s %10lu %10lu %10lu %8lu\n", memory_names[i],
+            (unsigned long)m->size, (unsigned long)m->allocated,
+            (unsigned long)m->needed, (unsigned long)m->calls);
+    }
+}
+
+/* ==============================================================
+ *
+ *                      Cached window check
+ *
+ * ===============================================================*/
+struct snapshot {
+    void *vertexes;
+    size_t vertex_size;
+    void *elements;
+    size_t element_size;
+};
+
+static int
+cached_frame(struct zr_context *ctx, int value, int mouse_x)
+{
+    /* one normal window in front of a cached window, so the cached commands
+     * do not start at the beginning of the command buffer and have to be
+     * moved to the front by `zr_clear` */
+    int built;
+    char buffer[32];
+    struct zr_layout layout;
+
+    zr_input_begin(ctx);
+    zr_input_motion(ctx, mouse_x, 10);
+    zr_input_end(ctx);
+
+    if (zr_begin(ctx, &layout, "Plain", zr_rect(0, 0, 200, 100), ZR_WINDOW_BORDER)) {
+        zr_layout_row_dynamic(ctx, 20, 1);
+        zr_label(ctx, "plain", ZR_TEXT_LEFT);
+    }
+    zr_end(ctx);
+
+    built = zr_begin(ctx, &layout, "Cached", zr_rect(220, 0, 200, 200),
+        ZR_WINDOW_BORDER|ZR_WINDOW_TITLE|ZR_WINDOW_CACHED);
+    if (built) {
+        sprintf(buffer, "value: %d", value);
+        zr_layout_row_dynamic(ctx, 20, 1);
+        zr_label(ctx, buffer, ZR_TEXT_LEFT);
+        zr_button_text(ctx, "button", ZR_BUTTON_DEFAULT);
+    }
+    zr_end(ctx);
+    return built;
+}
+
+static void
+cached_convert(struct device *dev, struct zr_context *ctx, struct snapshot *snap)
+{
+    struct zr_convert_config config;
+    memset(&config, 0, sizeof(config));
+    config.shape_AA = ZR_ANTI_ALIASING_ON;
+    config.line_AA = ZR_ANTI_ALIASING_ON;
+    config.circle_segment_count = 22;
+    config.line_thickness = 1.0f;
+    config.null = dev->null;
+    zr_convert(ctx, &dev->cmds, &dev->vertexes, &dev->elements, &config);
+
+    free(snap->vertexes);
+    free(snap->elements);
+    snap->vertex_size = dev->vertexes.allocated;
+    snap->element_size = dev->elements.allocated;
+    snap->vertexes = malloc(snap->vertex_size);
+    snap->elements = malloc(snap->element_size);
+    memcpy(snap->vertexes, dev->vertexes.memory.ptr, snap->vertex_size);
+    memcpy(snap->elements, dev->elements.memory.ptr, snap->element_size);
+    zr_clear(ctx);
+}
+
+static int
+snapshot_equal(const struct snapshot *a, const struct snapshot *b)
+{
+    return a->vertex_size == b->vertex_size && a->element_size == b->element_size &&
+        !memcmp(a->vertexes, b->vertexes, a->vertex_size) &&
+        !memcmp(a->elements, b->elements, a->element_size);
+}
+
+static void
+cached_check(struct device *dev, struct zr_allocator *alloc, struct zr_user_font *font)
+{
+    /* a cached window has to keep its commands over `zr_clear` as long as
+     * nothing changed and has to be rebuilt after `zr_window_invalidate` or
+     * an input change inside the window */
+    int i, built = 1;
+    struct zr_context ctx;
+    struct snapshot last, current;
+
+    memset(&last, 0, sizeof(last));
+    memset(&current, 0, sizeof(current));
+    zr_init(&ctx, alloc, font);
+
+    /* the first frames build the window until its state settled */
+    for (i = 0; i < 4 && built; ++i) {
+        last = current;
+        current.vertexes = current.elements = 0;
+        built = cached_frame(&ctx, 0, 500);
+        cached_convert(dev, &ctx, &current);
+        free(last.vertexes);
+        free(last.elements);
+        last.vertexes = last.elements = 0;
+    }
+    if (built) die("[cached]: window is never retained");
+    last = current;
+    current.vertexes = current.elements = 0;
+
+    /* retained commands have to produce the same output as the built ones */
+    if (cached_frame(&ctx, 0, 500))
+        die("[cached]: unchanged window was rebuilt");
+    cached_convert(dev, &ctx, &current);
+    if (!snapshot_equal(&last, &current))
+        die("[cached]: retained commands changed over zr_clear");
+
+    /* data changes are only picked up after invalidation */
+    if (cached_frame(&ctx, 100, 500))
+        die("[cached]: window was rebuilt without invalidation");
+    cached_convert(dev, &ctx, &current);
+    zr_window_invalidate(&ctx, "Cached");
+    if (!cached_frame(&ctx, 100, 500))
+        die("[cached]: invalidated window was not rebuilt");
+    cached_convert(dev, &ctx, &current);
+    if (snapshot_equal(&last, &current))
+        die("[cached]: invalidated window did not change");
+
+    /* mouse input inside the window rebuilds it until the mouse delta of
+     * the motion is gone */
+    if (!cached_frame(&ctx, 100, 300))
+        die("[cached]: window was not rebuilt after input");
+    cached_convert(dev, &ctx, &current);
+    for (i = 0, built = 1; i < 2 && built; ++i) {
+        built = cached_frame(&ctx, 100, 300);
+        cached_convert(dev, &ctx, &current);
+    }
+    if (built) die("[cached]: window was rebuilt without new input");
+    fprintf(stdout, "\ncached window: retained, invalidated and rebuilt as expected\n");
+
+    free(last.vertexes);
+    free(last.elements);
+    free(current.vertexes);
+    free(current.elements);
+    zr_free(&ctx);
+}
+
+static int
+reserve_frame(struct zr_context *ctx, unsigned long frame, zr_size *peak)
+{
+    /* a small window which is joined by a large log window in one frame.
+     * Returns if the command memory had to grow while building the frame */
+    int i;
+    char buffer[32];
+    int grown;
+    struct zr_layout layout;
+    const void *memory = ctx->memory.memory.ptr;
+    struct zr_memory_status status;
+
+    zr_input_begin(ctx);
+    zr_input_end(ctx);
+    if (zr_begin(ctx, &layout, "Status", zr_rect(0, 0, 200, 100), ZR_WINDOW_BORDER)) {
+        zr_layout_row_dynamic(ctx, 20, 1);
+        zr_label(ctx, "ready", ZR_TEXT_LEFT);
+    }
+    zr_end(ctx);
+    if (frame >= RESERVE_OPEN_FRAME) {
+        if (zr_begin(ctx, &layout, "Log", zr_rect(220, 0, 400, 20000), ZR_WINDOW_BORDER)) {
+            zr_layout_row_dynamic(ctx, 14, 1);
+            for (i = 0; i < RESERVE_LINES; ++i) {
+                sprintf(buffer, "log line %d", i);
+                zr_label(ctx, buffer, ZR_TEXT_LEFT);
+            }
+        }
+        zr_end(ctx);
+    }
+    zr_buffer_info(&status, &ctx->memory);
+    *peak = MAX(*peak, status.needed);
+    grown = ctx->memory.memory.ptr != memory;
+    zr_clear(ctx);
+    return grown;
+}
+
+static void
+reserve_check(struct zr_allocator *alloc, struct zr_user_font *font)
+{
+    /* growing the command memory in `zr_clear` cannot help a frame whose
+     * commands appear all at once, only reserving the memory up front can */
+    unsigned long i;
+    unsigned long grown = 0, reserved_grown = 0;
+    zr_size peak = 0, unused = 0;
+    struct zr_context ctx;
+
+    zr_init(&ctx, alloc, font);
+    for (i = 0; i < RESERVE_FRAMES; ++i)
+        grown += (unsigned long)reserve_frame(&ctx, i, &peak);
+    zr_free(&ctx);
+
+    zr_init(&ctx, alloc, font);
+    zr_reserve(&ctx, peak);
+    for (i = 0; i < RESERVE_FRAMES; ++i)
+        reserved_grown += (unsigned long)reserve_frame(&ctx, i, &unused);
+    zr_free(&ctx);
+
+    if (!grown) die("[reserve]: opening the log window did not grow the command memory");
+    if (reserved_grown) die("[reserve]: reserved command memory still had to grow");
+    fprintf(stdout, "command memory: grew while building %lu of %d frames, "
+        "none after zr_reserve(%lu)\n", grown, RESERVE_FRAMES, (unsigned long)peak);
+}
+
+/* ==============================================================
+ *
+ *                      Text cache
+ *
+ * ===============================================================*/
+static zr_query_font_glyph_f costly_inner;
+
+static void
+costly_query_glyph(zr_handle handle, float height, struct zr_user_font_glyph *glyph,
+    zr_rune codepoint, zr_rune next_codepoint)
+{
+    /* stands in for a user font which has to ask a font library like
+     * freetype for each glyph and kerning pair */
+    volatile unsigned int hash = codepoint;
+    int i;
+    for (i = 0; i < QUERY_COST; ++i)
+        hash = (hash ^ next_codepoint) * 16777619u;
+    costly_inner(handle, height, glyph, codepoint, next_codepoint);
+}
+
+static void
+text_cache_frame(struct zr_context *ctx, unsigned long frame)
+{
+    /* a property list where most lines keep their text between frames and
+     * one line changes each frame */
+    int i;
+    char buffer[64];
+    struct zr_layout layout;
+
+    zr_input_begin(ctx);
+    zr_input_motion(ctx, 500, 700);
+    zr_input_end(ctx);
+    if (zr_begin(ctx, &layout, "Properties", zr_rect(0, 0, 400, 700),
+        ZR_WINDOW_BORDER|ZR_WINDOW_TITLE)) {
+        zr_layout_row_dynamic(ctx, 14, 2);
+        for (i = 0; i < TEXT_CACHE_LINES; ++i) {
+            unsigned long value = ((unsigned long)i == frame % TEXT_CACHE_LINES) ?
+                frame : (unsigned long)i * 37;
+            sprintf(buffer, "property %d", i);
+            zr_label(ctx, buffer, ZR_TEXT_LEFT);
+            sprintf(buffer, "%lu units", value);
+            zr_label(ctx, buffer, ZR_TEXT_RIGHT);
+        }
+    }
+    zr_end(ctx);
+}
+
+static double
+text_cache_run(struct device *dev, struct zr_allocator *alloc, struct zr_user_font *font,
+    zr_size cache_size, unsigned long *hashes, unsigned int *hits, unsigned int *misses)
+{
+    unsigned long i;
+    double total = 0;
+    struct zr_context ctx;
+    struct zr_convert_config config;
+
+    memset(&config, 0, sizeof(config));
+    config.shape_AA = ZR_ANTI_ALIASING_ON;
+    config.line_AA = ZR_ANTI_ALIASING_ON;
+    config.circle_segment_count = 22;
+    config.line_thickness = 1.0f;
+    config.null = dev->null;
+    config.text_cache_size = cache_size;
+
+    zr_init(&ctx, alloc, font);
+    for (i = 0; i < TEXT_CACHE_FRAMES; ++i) {
+        double begin;
+        const unsigned char *p;
+        unsigned long hash = 2166136261lu;
+        zr_size n;
+
+        text_cache_frame(&ctx, i);
+        begin = timestamp();
+        zr_convert(&ctx, &dev->cmds, &dev->vertexes, &dev->elements, &config);
+        total += timestamp() - begin;
+
+        /* the cached runs have to produce exactly the same vertexes */
+        p = (const unsigned char*)dev->vertexes.memory.ptr;
+        for (n = 0; n < dev->vertexes.allocated; ++n)
+            hash = ((hash ^ p[n]) * 16777619lu) & 0xFFFFFFFFlu;
+        p = (const unsigned char*)dev->elements.memory.ptr;
+        for (n = 0; n < dev->elements.allocated; ++n)
+            hash = ((hash ^ p[n]) * 16777619lu) & 0xFFFFFFFFlu;
+        hashes[i] = hash;
+        zr_clear(&ctx);
+    }
+    *hits = ctx.canvas.text_cache.hits;
+    *misses = ctx.canvas.text_cache.misses;
+    zr_free(&ctx);
+    return total / TEXT_CACHE_FRAMES;
+}
+
+static void
+text_cache_check(struct device *dev, struct zr_allocator *alloc, const struct zr_user_font *font)
+{
+    /* converts the same frames with and without `text_cache_size` for a user
+     * font with a costly glyph query */
+    unsigned long *off_hashes, *on_hashes;
+    unsigned int hits, misses;
+    double off, on;
+    struct zr_user_font costly = *font;
+
+    costly_inner = font->query;
+    costly.query = costly_query_glyph;
+    off_hashes = (unsigned long*)calloc(TEXT_CACHE_FRAMES, sizeof(unsigned long));
+    on_hashes = (unsigned long*)calloc(TEXT_CACHE_FRAMES, sizeof(unsigned long));
+
+    off = text_cache_run(dev, alloc, &costly, 0, off_hashes, &hits, &misses);
+    if (hits || misses) die("[text cache]: disabled cache was used");
+    on = text_cache_run(dev, alloc, &costly, TEXT_CACHE_SIZE, on_hashes, &hits, &misses);
+    if (memcmp(off_hashes, on_hashes, TEXT_CACHE_FRAMES * sizeof(unsigned long)))
+        die("[text cache]: cached glyph runs changed the vertex output");
+
+    fprintf(stdout, "text run cache (%d KB, query cost %d): off %.1f us/convert  "
+        "on %.1f us/convert  speedup %.2fx  hits %.1f%%  vertexes match\n",
+        TEXT_CACHE_SIZE / 1024, QUERY_COST, off / 1000.0, on / 1000.0, off / on,
+        100.0 * (double)hits / (double)MAX(hits + misses, 1));
+    free(off_hashes);
+    free(on_hashes);
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned long frames = DEFAULT_FRAMES;
+    struct device device;
+    struct stats stats;
+    struct demo gui;
+
+    if (argc > 1) frames = strtoul(argv[1], NULL, 10);
+    memset(&device, 0, sizeof(device));
+    memset(&stats, 0, sizeof(stats));
+    memset(&gui, 0, sizeof(gui));
+    stats.phases[PHASE_BUILD].name = "ui-build";
+    stats.phases[PHASE_WALK].name = "cmd-walk";
+    stats.phases[PHASE_CHANGED].name = "changed";
+    stats.phases[PHASE_DAMAGE].name = "damage";
+    stats.phases[PHASE_CONVERT].name = "convert";
+
+    {
+        /* GUI */
+        struct zr_user_font usrfnt;
+        struct zr_allocator alloc;
+        alloc.userdata.ptr = NULL;
+        alloc.alloc = mem_alloc;
+        alloc.free = mem_free;
+        zr_buffer_init(&device.cmds, &alloc, 1024);
+        zr_buffer_init(&device.vertexes, &alloc, 64 * 1024);
+        zr_buffer_init(&device.elements, &alloc, 16 * 1024);
+        device.null.texture.id = 0;
+        if (argc > 2)
+            usrfnt = font_bake(&device, argv[2]);
+        else usrfnt = font_dummy(&device);
+        zr_init(&gui.ctx, &alloc, &usrfnt);
+        cached_check(&device, &alloc, &usrfnt);
+        reserve_check(&alloc, &usrfnt);
+        text_cache_check(&device, &alloc, &usrfnt);
+    }
+
+    while (stats.frames < frames) {
+        if (!frame(&device, &gui, &stats))
+            break;
+    }
+    stats.width_hits = gui.ctx.widths.hits;
+    stats.width_misses = gui.ctx.widths.misses;
+    print_stats(&stats);
+
+    free(device.glyphes);
+    zr_free(&gui.ctx);
+    zr_buffer_free(&device.cmds);
+    zr_buffer_free(&device.vertexes);
+    zr_buffer_free(&device.elements);
+    return 0;
+}
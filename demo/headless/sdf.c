@@ -0,0 +1,249 @@
+/*
+    Copyright (c) 2016 Micha Mettke
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any damages
+    arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+
+    1.  The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software
+        in a product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+    2.  Altered source versions must be plainly marked as such, and must not be
+        misrepresented as being the original software.
+    3.  This notice may not be removed or altered from any source distribution.
+*/
+/*  Signed distance field font benchmark. Bakes the default glyph range of a
+    font once with coverage glyphs for every tested height, like demos using
+    more than one font size do, and once as a single signed distance field.
+    Afterwards ASCII glyphs are drawn at every height by sampling the
+    atlas, either by scaling the coverage glyphs of the smallest bake like
+    `zr_push_font_height` does or by thresholding the distance field, and are
+    compared against stb_truetype rasterizing the glyph directly at that height.
+
+    USAGE: sdf <ttf font> */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../zahnrad.h"
+
+/* reference rasterizer */
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeclaration-after-statement"
+#endif
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "../../stb_truetype.h"
+#if defined(__GNUC__) || defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#define HEIGHT_COUNT 6
+#define SDF_HEIGHT 32
+#define SDF_SPREAD 4.0f
+
+static const int heights[HEIGHT_COUNT] = {12, 16, 24, 32, 48, 64};
+
+struct bake {
+    struct zr_baked_font font;
+    struct zr_font_glyph *glyphes;
+    unsigned char *image;
+    int width, height;
+    size_t memory;
+    double time;
+};
+
+static void
+die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputs("\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+static char*
+file_load(const char* path, size_t* siz)
+{
+    char *buf;
+    FILE *fd = fopen(path, "rb");
+    if (!fd) die("Failed to open file: %s\n", path);
+    fseek(fd, 0, SEEK_END);
+    *siz = (size_t)ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    buf = (char*)calloc(*siz, 1);
+    if (fread(buf, *siz, 1, fd) != 1)
+        die("Failed to read file: %s\n", path);
+    fclose(fd);
+    return buf;
+}
+
+static double
+timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void
+bake(struct bake *out, void *ttf_blob, size_t ttf_size, int height, float spread)
+{
+    int glyph_count;
+    size_t tmp_size, img_size;
+    struct zr_font_config config;
+    void *tmp;
+    double begin;
+
+    memset(out, 0, sizeof(*out));
+    memset(&config, 0, sizeof(config));
+    config.ttf_blob = ttf_blob;
+    config.ttf_size = ttf_size;
+    config.font = &out->font;
+    config.coord_type = ZR_COORD_PIXEL;
+    config.range = zr_font_default_glyph_ranges();
+    config.size = (float)height;
+    config.oversample_h = 1;
+    config.oversample_v = 1;
+    config.sdf_spread = spread;
+
+    begin = timestamp();
+    zr_font_bake_memory(&tmp_size, &glyph_count, &config, 1);
+    out->glyphes = (struct zr_font_glyph*)calloc(sizeof(struct zr_font_glyph), (size_t)glyph_count);
+    tmp = calloc(1, tmp_size);
+    if (!zr_font_bake_pack(&img_size, &out->width, &out->height, 0, tmp, tmp_size, &config, 1))
+        die("[Font]: failed to load font!\n");
+    out->image = (unsigned char*)calloc(1, img_size);
+    zr_font_bake(out->image, out->width, out->height, tmp, tmp_size, out->glyphes,
+        glyph_count, &config, 1);
+    out->time = timestamp() - begin;
+    out->memory = img_size + (size_t)glyph_count * sizeof(struct zr_font_glyph);
+    free(tmp);
+}
+
+static float
+sample(const struct bake *b, float u, float v)
+{
+    /* bilinear filtered alpha lookup with texel centers at +0.5 */
+    int x, y, i, j;
+    float fx, fy, result = 0;
+    u -= 0.5f; v -= 0.5f;
+    x = (int)(u + 1.0f) - 1;
+    y = (int)(v + 1.0f) - 1;
+    fx = u - (float)x;
+    fy = v - (float)y;
+    for (j = 0; j < 2; ++j) {
+        for (i = 0; i < 2; ++i) {
+            int tx = x + i, ty = y + j;
+            float w = (i ? fx: 1.0f - fx) * (j ? fy: 1.0f - fy);
+            if (tx < 0 || ty < 0 || tx >= b->width || ty >= b->height) continue;
+            result += w * (float)b->image[tx + ty * b->width];
+        }
+    }
+    return result / 255.0f;
+}
+
+static float
+smoothstep(float e0, float e1, float x)
+{
+    float t = (x - e0) / (e1 - e0);
+    t = (t < 0) ? 0: (t > 1) ? 1: t;
+    return t * t * (3.0f - 2.0f * t);
+}
+
+static double
+compare(const struct bake *b, const stbtt_fontinfo *info, int height)
+{
+    /* average absolute difference per pixel in [0,255] between the glyphs
+     * drawn from the baked atlas and rasterized directly */
+    int codepoint;
+    double error = 0;
+    long pixels = 0;
+    const float size = b->font.height;
+    const float ratio = size / (float)height;
+    const float scale = stbtt_ScaleForPixelHeight(info, (float)height);
+
+    for (codepoint = 33; codepoint < 127; ++codepoint) {
+        int w, h, x0, y0, x, y;
+        const struct zr_font_glyph *g = &b->glyphes[codepoint - 0x20];
+        unsigned char *ref = stbtt_GetCodepointBitmap(info, scale, scale,
+            codepoint, &w, &h, &x0, &y0);
+        if (!ref) continue;
+        for (y = 0; y < h; ++y) {
+            for (x = 0; x < w; ++x) {
+                float alpha = 0;
+                float gx = ((float)(x0 + x) + 0.5f) * ratio;
+                float gy = ((float)(y0 + y) + 0.5f) * ratio + b->font.ascent + 0.5f;
+                if (gx >= g->x0 && gx <= g->x1 && gy >= g->y0 && gy <= g->y1) {
+                    alpha = sample(b, g->u0 + (gx - g->x0), g->v0 + (gy - g->y0));
+                    if (b->font.sdf_spread > 0) {
+                        const float edge = 0.5f * ratio / (2.0f * b->font.sdf_spread);
+                        alpha = smoothstep(0.5f - edge, 0.5f + edge, alpha);
+                    }
+                }
+                error += (alpha * 255.0f > ref[x + y * w]) ?
+                    alpha * 255.0f - ref[x + y * w]: ref[x + y * w] - alpha * 255.0f;
+                pixels++;
+            }
+        }
+        stbtt_FreeBitmap(ref, NULL);
+    }
+    return error / (double)pixels;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i;
+    size_t ttf_size;
+    char *ttf_blob;
+    stbtt_fontinfo info;
+    struct bake coverage[HEIGHT_COUNT];
+    struct bake sdf;
+    size_t coverage_memory = 0;
+    double coverage_time = 0;
+
+    if (argc < 2)
+        die("Missing TTF Font file argument!");
+    ttf_blob = file_load(argv[1], &ttf_size);
+    if (!stbtt_InitFont(&info, (const unsigned char*)ttf_blob, 0))
+        die("[Font]: failed to load font!\n");
+
+    for (i = 0; i < HEIGHT_COUNT; ++i) {
+        bake(&coverage[i], ttf_blob, ttf_size, heights[i], 0);
+        coverage_memory += coverage[i].memory;
+        coverage_time += coverage[i].time;
+    }
+    bake(&sdf, ttf_blob, ttf_size, SDF_HEIGHT, SDF_SPREAD);
+    fprintf(stdout, "coverage bakes: %d  memory: %6lu KB  time: %6.2f ms\n",
+        HEIGHT_COUNT, (unsigned long)(coverage_memory / 1024), coverage_time / 1e6);
+    fprintf(stdout, "sdf bake:       1  memory: %6lu KB  time: %6.2f ms\n",
+        (unsigned long)(sdf.memory / 1024), sdf.time / 1e6);
+
+    for (i = 0; i < HEIGHT_COUNT; ++i) {
+        double exact = compare(&coverage[i], &info, heights[i]);
+        double scaled = compare(&coverage[0], &info, heights[i]);
+        double field = compare(&sdf, &info, heights[i]);
+        fprintf(stdout, "height %2d  error exact bake: %5.2f  scaled %dpx bake: %5.2f  sdf: %5.2f\n",
+            heights[i], exact, heights[0], scaled, field);
+    }
+
+    for (i = 0; i < HEIGHT_COUNT; ++i) {
+        free(coverage[i].glyphes);
+        free(coverage[i].image);
+    }
+    free(sdf.glyphes);
+    free(sdf.image);
+    free(ttf_blob);
+    return 0;
+}
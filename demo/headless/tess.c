@@ -0,0 +1,474 @@
+/*
+    Copyright (c) 2016 Micha Mettke
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any damages
+    arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+
+    1.  The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software
+        in a product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+    2.  Altered source versions must be plainly marked as such, and must not be
+        misrepresented as being the original software.
+    3.  This notice may not be removed or altered from any source distribution.
+*/
+/*  Tessellation benchmark. Fills a grid of windows with anti-aliased curves,
+    circles, arcs and rounded rectangles and measures how long `zr_convert`
+    takes to turn them into vertexes. Each scene is converted with thin and
+    thick lines since both take different paths through the line tessellation.
+    With a thread count each scene is additionally converted with a
+    `zr_convert_config.dispatch` callback running the windows on a small
+    pthread pool. Its output is checked to match the serial conversion.
+    Afterwards one scene is converted into a custom vertex layout with half
+    float positions and texture coordinates and 8-bit colors and compared
+    against the default vertex layout.
+
+    USAGE: tess [iterations] [threads] */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "../../zahnrad.h"
+
+#define DEFAULT_ITERATIONS 500
+#define MAX_THREADS 64
+#define WINDOW_COUNT 24
+#define SHAPE_COUNT 4
+#define WINDOW_WIDTH 200
+#define WINDOW_HEIGHT 450
+#define UNUSED(a) ((void)(a))
+
+struct device {
+    struct zr_buffer cmds;
+    struct zr_buffer vertexes;
+    struct zr_buffer elements;
+    struct zr_draw_null_texture null;
+};
+
+struct pool {
+    pthread_t threads[MAX_THREADS];
+    int thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    /* current batch of jobs */
+    zr_convert_job_f job;
+    void *data;
+    unsigned int next;
+    unsigned int count;
+    unsigned int finished;
+    unsigned long generation;
+    int quit;
+};
+
+static void
+die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputs("\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+static double
+timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void* mem_alloc(zr_handle unused, size_t size)
+{UNUSED(unused); return calloc(1, size);}
+static void mem_free(zr_handle unused, void *ptr)
+{UNUSED(unused); free(ptr);}
+
+/* ==============================================================
+ *
+ *                      Thread pool
+ *
+ * ===============================================================*/
+static void*
+pool_worker(void *arg)
+{
+    struct pool *pool = (struct pool*)arg;
+    unsigned long generation = 0;
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        while (!pool->quit && pool->generation == generation)
+            pthread_cond_wait(&pool->work, &pool->mutex);
+        if (pool->quit) break;
+        generation = pool->generation;
+        while (pool->next < pool->count) {
+            unsigned int index = pool->next++;
+            pthread_mutex_unlock(&pool->mutex);
+            pool->job(pool->data, index);
+            pthread_mutex_lock(&pool->mutex);
+            if (++pool->finished == pool->count)
+                pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+static void
+pool_dispatch(zr_handle handle, zr_convert_job_f job, void *data, unsigned int count)
+{
+    struct pool *pool = (struct pool*)handle.ptr;
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->data = data;
+    pool->next = 0;
+    pool->count = count;
+    pool->finished = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    while (pool->finished < pool->count)
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void
+pool_init(struct pool *pool, int thread_count)
+{
+    int i;
+    memset(pool, 0, sizeof(*pool));
+    pool->thread_count = thread_count;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i = 0; i < thread_count; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool))
+            die("[pool]: failed to create thread");
+    }
+}
+
+static void
+pool_free(struct pool *pool)
+{
+    int i;
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+    for (i = 0; i < pool->thread_count; ++i)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+}
+
+/* ==============================================================
+ *
+ *                      Scene
+ *
+ * ===============================================================*/
+static zr_size
+text_width(zr_handle handle, float height, const char *text, zr_size len)
+{
+    UNUSED(handle);
+    UNUSED(height);
+    return zr_utf_len(text, len) * 7;
+}
+
+static void
+scene(struct zr_context *ctx)
+{
+    int w;
+    for (w = 0; w < WINDOW_COUNT; ++w) {
+        char title[32];
+        struct zr_layout layout;
+        const struct zr_rect bounds = zr_rect((float)((w % 6) * WINDOW_WIDTH),
+            (float)((w / 6) * WINDOW_HEIGHT), WINDOW_WIDTH, WINDOW_HEIGHT);
+        sprintf(title, "tess%d", w);
+        if (zr_begin(ctx, &layout, title, bounds, ZR_WINDOW_NO_SCROLLBAR)) {
+            int i;
+            struct zr_command_buffer *canvas = zr_window_get_canvas(ctx);
+            for (i = 0; i < SHAPE_COUNT; ++i) {
+                const float x = bounds.x;
+                const float y = bounds.y + (float)(i * 110);
+                const struct zr_color color = zr_rgb(50 + w * 8, 120, 200 - i * 20);
+                zr_draw_curve(canvas, x, y + 100, x + 40, y - 40,
+                    x + 140, y + 240, x + 180, y + 100, color);
+                zr_draw_curve(canvas, x, y + 50, x + 60, y + 180,
+                    x + 120, y - 80, x + 180, y + 150, color);
+                zr_draw_circle(canvas, zr_rect(x + 10, y + 10, 60, 60), color);
+                zr_draw_arc(canvas, x + 130, y + 40, 30, 0.0f, 4.0f, color);
+                zr_draw_rect(canvas, zr_rect(x + 10, y + 70, 160, 30), 12.0f, color);
+            }
+        }
+        zr_end(ctx);
+    }
+}
+
+struct half_vertex {
+    unsigned short position[2];
+    unsigned short uv[2];
+    unsigned char col[4];
+};
+
+static const struct zr_draw_vertex_layout_element half_layout[] = {
+    {ZR_VERTEX_POSITION, ZR_FORMAT_HALF, offsetof(struct half_vertex, position)},
+    {ZR_VERTEX_TEXCOORD, ZR_FORMAT_HALF, offsetof(struct half_vertex, uv)},
+    {ZR_VERTEX_COLOR, ZR_FORMAT_R8G8B8A8, offsetof(struct half_vertex, col)},
+    ZR_VERTEX_LAYOUT_END
+};
+
+struct result {
+    double time;
+    /* average conversion time in nanoseconds */
+    unsigned long vertexes;
+    unsigned long elements;
+    zr_size vertex_size;
+    zr_size element_size;
+    unsigned long checksum;
+    /* hash over the converted vertexes, elements and draw commands */
+};
+
+static unsigned long
+checksum(const void *memory, zr_size size, unsigned long hash)
+{
+    const unsigned char *bytes = (const unsigned char*)memory;
+    zr_size i;
+    for (i = 0; i < size; ++i)
+        hash = (hash * 33u) ^ bytes[i];
+    return hash;
+}
+
+static struct result
+run(struct device *dev, struct zr_context *ctx, float thickness,
+    struct pool *pool, int iterations)
+{
+    int i;
+    double total = 0;
+    struct result res;
+    struct zr_convert_config config;
+    memset(&res, 0, sizeof(res));
+    memset(&config, 0, sizeof(config));
+    config.shape_AA = ZR_ANTI_ALIASING_ON;
+    config.line_AA = ZR_ANTI_ALIASING_ON;
+    config.circle_segment_count = 22;
+    config.line_thickness = thickness;
+    config.null = dev->null;
+    if (pool) {
+        config.dispatch = pool_dispatch;
+        config.userdata = zr_handle_ptr(pool);
+    }
+
+    for (i = 0; i < iterations; ++i) {
+        double begin, end;
+        const struct zr_draw_command *cmd;
+        scene(ctx);
+        begin = timestamp();
+        zr_convert(ctx, &dev->cmds, &dev->vertexes, &dev->elements, &config);
+        end = timestamp();
+        total += end - begin;
+
+        res.vertexes = ctx->canvas.vertex_count;
+        res.elements = ctx->canvas.element_count;
+        res.vertex_size = dev->vertexes.allocated;
+        res.element_size = dev->elements.allocated;
+        res.checksum = checksum(zr_buffer_memory(&dev->vertexes), res.vertex_size, 5381);
+        res.checksum = checksum(zr_buffer_memory(&dev->elements), res.element_size, res.checksum);
+        zr_draw_foreach(cmd, ctx, &dev->cmds)
+            res.checksum = checksum(cmd, sizeof(*cmd), res.checksum);
+        if (!res.vertexes) die("[tess]: no vertexes converted");
+        zr_clear(ctx);
+    }
+    res.time = total / (double)iterations;
+    return res;
+}
+
+static float
+half_to_float(unsigned short half)
+{
+    /* only normal numbers and zero are produced by the scene */
+    const int exponent = (half >> 10) & 0x1F;
+    const float mantissa = (float)(half & 0x3FF) / 1024.0f;
+    float value = (exponent) ? (float)ldexp(1.0f + mantissa, exponent - 15): 0.0f;
+    return (half & 0x8000) ? -value: value;
+}
+
+static void
+convert(struct device *dev, struct zr_context *ctx, float thickness,
+    const struct zr_draw_vertex_layout_element *layout, zr_size vertex_size,
+    zr_size vertex_alignment, struct pool *pool, void **vertexes, void **elements,
+    unsigned int *vertex_count, unsigned int *element_count)
+{
+    struct zr_convert_config config;
+    memset(&config, 0, sizeof(config));
+    config.shape_AA = ZR_ANTI_ALIASING_ON;
+    config.line_AA = ZR_ANTI_ALIASING_ON;
+    config.circle_segment_count = 22;
+    config.line_thickness = thickness;
+    config.null = dev->null;
+    config.vertex_layout = layout;
+    config.vertex_size = vertex_size;
+    config.vertex_alignment = vertex_alignment;
+    if (pool) {
+        config.dispatch = pool_dispatch;
+        config.userdata = zr_handle_ptr(pool);
+    }
+
+    scene(ctx);
+    zr_convert(ctx, &dev->cmds, &dev->vertexes, &dev->elements, &config);
+    if (ctx->canvas.overflow)
+        die("[layout]: scene does not fit into the vertex buffer");
+    if (dev->vertexes.allocated != ctx->canvas.vertex_count * vertex_size)
+        die("[layout]: vertexes are not tightly packed");
+    *vertex_count = ctx->canvas.vertex_count;
+    *element_count = ctx->canvas.element_count;
+    *vertexes = malloc(dev->vertexes.allocated);
+    *elements = malloc(dev->elements.allocated);
+    memcpy(*vertexes, zr_buffer_memory(&dev->vertexes), dev->vertexes.allocated);
+    memcpy(*elements, zr_buffer_memory(&dev->elements), dev->elements.allocated);
+    zr_clear(ctx);
+}
+
+static void
+layout_check(struct device *dev, struct zr_context *ctx, struct pool *pool)
+{
+    /* every vertex of the custom layout has to describe the same vertex as
+     * the default layout up to half float precision */
+    unsigned int i, count, element_count, half_count, half_element_count;
+    float max_error = 0;
+    size_t element_size;
+    void *vertexes, *elements, *half_vertexes, *half_elements;
+    const struct zr_draw_vertex *vtx;
+    const struct half_vertex *half;
+
+    convert(dev, ctx, 1.0f, 0, sizeof(struct zr_draw_vertex), 0, 0,
+        &vertexes, &elements, &count, &element_count);
+    element_size = element_count * sizeof(zr_draw_index);
+    convert(dev, ctx, 1.0f, half_layout, sizeof(struct half_vertex), sizeof(unsigned short),
+        0, &half_vertexes, &half_elements, &half_count, &half_element_count);
+    if (half_count != count || half_element_count != element_count)
+        die("[layout]: vertex count does not match the default layout");
+    if (memcmp(elements, half_elements, element_size))
+        die("[layout]: elements do not match the default layout");
+
+    vtx = (const struct zr_draw_vertex*)vertexes;
+    half = (const struct half_vertex*)half_vertexes;
+    for (i = 0; i < count; ++i) {
+        int j;
+        float values[4];
+        unsigned short halfs[4];
+        values[0] = vtx[i].position.x; values[1] = vtx[i].position.y;
+        values[2] = vtx[i].uv.x; values[3] = vtx[i].uv.y;
+        halfs[0] = half[i].position[0]; halfs[1] = half[i].position[1];
+        halfs[2] = half[i].uv[0]; halfs[3] = half[i].uv[1];
+        for (j = 0; j < 4; ++j) {
+            /* half floats keep 11 significant bits */
+            float error = (float)fabs(half_to_float(halfs[j]) - values[j]);
+            if (error > (float)fabs(values[j]) / 1024.0f + 0.0001f)
+                die("[layout]: vertex %u differs from the default layout", i);
+            max_error = (error > max_error) ? error: max_error;
+        }
+        for (j = 0; j < 4; ++j) {
+            if (half[i].col[j] != ((vtx[i].col >> (j * 8)) & 0xFF))
+                die("[layout]: color of vertex %u differs from the default layout", i);
+        }
+    }
+
+    if (pool) {
+        /* windows converted on their own are copied into the output in one
+         * block, so the vertexes have to be packed without padding */
+        void *parallel_vertexes, *parallel_elements;
+        convert(dev, ctx, 1.0f, half_layout, sizeof(struct half_vertex), sizeof(unsigned short),
+            pool, &parallel_vertexes, &parallel_elements, &half_count, &half_element_count);
+        if (memcmp(half_vertexes, parallel_vertexes, count * sizeof(struct half_vertex)) ||
+            memcmp(half_elements, parallel_elements, element_size))
+            die("[layout]: parallel output does not match serial output");
+        free(parallel_vertexes);
+        free(parallel_elements);
+    }
+
+    fprintf(stdout, "%-16s vertexes: %6u  bytes: %7lu instead of %7lu  max error: %.4f\n",
+        "half layout", count, (unsigned long)(count * sizeof(struct half_vertex)),
+        (unsigned long)(count * sizeof(struct zr_draw_vertex)), max_error);
+    free(vertexes);
+    free(elements);
+    free(half_vertexes);
+    free(half_elements);
+}
+
+static void
+print(const char *name, const struct result *res)
+{
+    fprintf(stdout, "%-16s vertexes: %6lu  convert: %10.0f ns  %6.2f ns/vertex\n",
+        name, res->vertexes, res->time, res->time / (double)res->vertexes);
+}
+
+static void
+bench(struct device *dev, struct zr_context *ctx, const char *name,
+    float thickness, struct pool *pool, int iterations)
+{
+    char label[64];
+    struct result serial = run(dev, ctx, thickness, 0, iterations);
+    print(name, &serial);
+    if (pool) {
+        struct result parallel = run(dev, ctx, thickness, pool, iterations);
+        if (parallel.vertex_size != serial.vertex_size ||
+            parallel.element_size != serial.element_size ||
+            parallel.checksum != serial.checksum)
+            die("[%s]: parallel output does not match serial output", name);
+        sprintf(label, "%s %dx", name, pool->thread_count);
+        print(label, &parallel);
+        fprintf(stdout, "%-16s %.2fx\n", "speedup", serial.time / parallel.time);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct device device;
+    struct zr_context ctx;
+    struct zr_user_font usrfnt;
+    struct zr_allocator alloc;
+    struct pool pool;
+    int iterations = DEFAULT_ITERATIONS;
+    int threads = 0;
+
+    if (argc > 1) iterations = atoi(argv[1]);
+    if (argc > 2) threads = atoi(argv[2]);
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    memset(&device, 0, sizeof(device));
+    memset(&usrfnt, 0, sizeof(usrfnt));
+    alloc.userdata.ptr = NULL;
+    alloc.alloc = mem_alloc;
+    alloc.free = mem_free;
+    zr_buffer_init(&device.cmds, &alloc, 1024);
+    zr_buffer_init(&device.vertexes, &alloc, 64 * 1024);
+    zr_buffer_init(&device.elements, &alloc, 16 * 1024);
+    usrfnt.height = 14;
+    usrfnt.width = text_width;
+    zr_init(&ctx, &alloc, &usrfnt);
+    if (threads > 0)
+        pool_init(&pool, threads);
+
+    fprintf(stdout, "windows: %d\n", WINDOW_COUNT);
+    bench(&device, &ctx, "thin", 1.0f, (threads > 0) ? &pool: 0, iterations);
+    bench(&device, &ctx, "thick", 3.0f, (threads > 0) ? &pool: 0, iterations);
+    layout_check(&device, &ctx, (threads > 0) ? &pool: 0);
+
+    if (threads > 0)
+        pool_free(&pool);
+    zr_free(&ctx);
+    zr_buffer_free(&device.cmds);
+    zr_buffer_free(&device.vertexes);
+    zr_buffer_free(&device.elements);
+    return 0;
+}
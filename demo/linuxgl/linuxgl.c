@@ -43,6 +43,12 @@
 #include "../../zahnrad.h"
 #include "../demo.c"
 
+#if ZR_COMPILE_WITH_32BIT_DRAW_INDEX
+#define DRAW_INDEX_TYPE GL_UNSIGNED_INT
+#else
+#define DRAW_INDEX_TYPE GL_UNSIGNED_SHORT
+#endif
+
 /* prefered OpenGL version */
 #define OGL_MAJOR_VERSION 3
 #define OGL_MINOR_VERSION 0
@@ -522,7 +528,7 @@ device_draw(struct device *dev, struct zr_context *ctx, int width, int height,
             glScissor((GLint)cmd->clip_rect.x,
                 height - (GLint)(cmd->clip_rect.y + cmd->clip_rect.h),
                 (GLint)cmd->clip_rect.w, (GLint)cmd->clip_rect.h);
-            glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, GL_UNSIGNED_SHORT, offset);
+            glDrawElements(GL_TRIANGLES, (GLsizei)cmd->elem_count, DRAW_INDEX_TYPE, offset);
             offset += cmd->elem_count;
         }
         zr_clear(ctx);
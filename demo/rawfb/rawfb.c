@@ -0,0 +1,1531 @@
+/*
+    Copyright (c) 2016 Micha Mettke
+
+    This software is provided 'as-is', without any express or implied
+    warranty.  In no event will the authors be held liable for any damages
+    arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+
+    1.  The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software
+        in a product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+    2.  Altered source versions must be plainly marked as such, and must not be
+        misrepresented as being the original software.
+    3.  This notice may not be removed or altered from any source distribution.
+*/
+/*  Software rasterizer backend. Renders `demo/demo.c` into a 32-bit RGBA
+    memory framebuffer without any window system or GPU. The draw commands,
+    vertexes and elements from `zr_convert` are binned into screen tiles
+    which are then filled independently on a small pthread pool. Triangles
+    are scanned row by row and alpha blended with the texel of the baked font
+    image, while rows with constant color and texel, which covers most of the
+    rectangles, are blended four pixels at a time with SSE2 or NEON.
+    Every frame is rendered single threaded and on the thread pool and both
+    framebuffers have to be equal, so the output can be used as deterministic
+    reference for screenshot tests and for comparing tessellation changes.
+    The last frame is written as binary PPM image.
+    Additionally the command queue is drawn directly without `zr_convert`,
+    which only turns lines, curves, arcs and triangles into triangles and
+    fills rectangles, circles and glyphs straight into the framebuffer.
+    Finally the demo keeps running with the direct drawing moved onto a
+    render thread. The context is double buffered by `zr_init_buffered`, so
+    the render thread draws the `zr_frame_get` handle of the last frame while
+    the UI thread already builds the next one. Text commands of the handle
+    carry their own copy of the user font, so only the baked font itself is
+    shared between both threads and it is never written after baking.
+
+    USAGE: rawfb [frames] [threads] [ttf font] [screenshot.ppm] [direct.ppm]
+    Without a font a fixed pitch dummy font is used, which draws every
+    glyph as a filled rectangle. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAWFB_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RAWFB_NEON
+#include <arm_neon.h>
+#endif
+
+/* macros */
+#define DEFAULT_FRAMES 60
+#define FONT_HEIGHT 14
+#define DUMMY_GLYPH_WIDTH 7
+#define MAX_THREADS 64
+#define TILE_SIZE 64
+#define CLEAR_COLOR 0xFF1E1E1Eu
+
+#include "../../zahnrad.h"
+#include "../demo.c"
+
+struct rawfb_image {
+    const zr_uint *pixels;
+    /* RGBA8 pixels packed like `zr_color32` */
+    int w, h;
+};
+
+struct rawfb_clip {
+    int x0, y0, x1, y1;
+};
+
+struct rawfb_bounds {
+    short x0, y0, x1, y1;
+    /* covered tiles of a triangle, empty if x1 < x0 */
+};
+
+struct rawfb {
+    zr_uint *pixels;
+    int width, height;
+    int tiles_x, tiles_y;
+    /* current frame */
+    const struct zr_draw_vertex *vertexes;
+    const zr_draw_index *elements;
+    const struct zr_draw_command **commands;
+    unsigned int command_count;
+    unsigned int command_capacity;
+    /* triangle to draw command mapping */
+    unsigned int *triangle_command;
+    struct rawfb_bounds *triangle_bounds;
+    unsigned int triangle_capacity;
+    /* tile bins with all triangle indexes in draw order */
+    unsigned int *bin_offsets;
+    unsigned int *bins;
+    unsigned int bin_capacity;
+    /* command queue for direct drawing without `zr_convert` */
+    const struct zr_command **queue;
+    struct rawfb_clip *queue_bounds;
+    unsigned int queue_count;
+    unsigned int queue_capacity;
+    unsigned int curve_segments;
+};
+
+struct pool {
+    pthread_t threads[MAX_THREADS];
+    int thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    /* current batch of jobs */
+    zr_convert_job_f job;
+    void *data;
+    unsigned int next;
+    unsigned int count;
+    unsigned int finished;
+    unsigned long generation;
+    int quit;
+};
+
+struct pipeline {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct rawfb *fb;
+    unsigned int curve_segments;
+    /* frame currently drawn by the render thread */
+    struct zr_frame frame;
+    int pending;
+    int quit;
+};
+
+struct device {
+    struct zr_buffer cmds;
+    struct zr_buffer vertexes;
+    struct zr_buffer elements;
+    struct zr_draw_null_texture null;
+    struct zr_font font;
+    struct zr_font_glyph *glyphes;
+    struct rawfb_image font_image;
+};
+
+/* ==============================================================
+ *
+ *                      Utility
+ *
+ * ===============================================================*/
+static void
+die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputs("\n", stderr);
+    exit(EXIT_FAILURE);
+}
+
+static char*
+file_load(const char* path, size_t* siz)
+{
+    char *buf;
+    FILE *fd = fopen(path, "rb");
+    if (!fd) die("Failed to open file: %s\n", path);
+    fseek(fd, 0, SEEK_END);
+    *siz = (size_t)ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+    buf = (char*)calloc(*siz, 1);
+    if (fread(buf, *siz, 1, fd) != 1)
+        die("Failed to read file: %s\n", path);
+    fclose(fd);
+    return buf;
+}
+
+static double
+timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void*
+grow(void *memory, unsigned int *capacity, unsigned int needed, size_t size)
+{
+    if (needed <= *capacity) return memory;
+    while (*capacity < needed)
+        *capacity = (*capacity) ? *capacity * 2 : 1024;
+    memory = realloc(memory, *capacity * size);
+    if (!memory) die("[rawfb]: out of memory");
+    return memory;
+}
+
+static void* mem_alloc(zr_handle unused, size_t size)
+{UNUSED(unused); return calloc(1, size);}
+static void mem_free(zr_handle unused, void *ptr)
+{UNUSED(unused); free(ptr);}
+
+/* ==============================================================
+ *
+ *                      Thread pool
+ *
+ * ===============================================================*/
+static void*
+pool_worker(void *arg)
+{
+    struct pool *pool = (struct pool*)arg;
+    unsigned long generation = 0;
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        while (!pool->quit && pool->generation == generation)
+            pthread_cond_wait(&pool->work, &pool->mutex);
+        if (pool->quit) break;
+        generation = pool->generation;
+        while (pool->next < pool->count) {
+            unsigned int index = pool->next++;
+            pthread_mutex_unlock(&pool->mutex);
+            pool->job(pool->data, index);
+            pthread_mutex_lock(&pool->mutex);
+            if (++pool->finished == pool->count)
+                pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+static void
+pool_dispatch(zr_handle handle, zr_convert_job_f job, void *data, unsigned int count)
+{
+    struct pool *pool = (struct pool*)handle.ptr;
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->data = data;
+    pool->next = 0;
+    pool->count = count;
+    pool->finished = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    while (pool->finished < pool->count)
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void
+pool_init(struct pool *pool, int thread_count)
+{
+    int i;
+    memset(pool, 0, sizeof(*pool));
+    pool->thread_count = thread_count;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i = 0; i < thread_count; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, pool_worker, pool))
+            die("[pool]: failed to create thread");
+    }
+}
+
+static void
+pool_free(struct pool *pool)
+{
+    int i;
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+    for (i = 0; i < pool->thread_count; ++i)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+}
+
+/* ==============================================================
+ *
+ *                      Rasterizer
+ *
+ * ===============================================================*/
+static const zr_uint rawfb_white = 0xFFFFFFFFu;
+
+static int
+rawfb_blend_channel(int src, int dst, int alpha)
+{
+    /* exact rounded (src * alpha + dst * (255 - alpha)) / 255 */
+    const int t = src * alpha + dst * (255 - alpha) + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static zr_uint
+rawfb_blend(zr_uint dst, int r, int g, int b, int a)
+{
+    zr_uint out;
+    out = (zr_uint)rawfb_blend_channel(r, (int)(dst & 0xFF), a);
+    out |= (zr_uint)rawfb_blend_channel(g, (int)((dst >> 8) & 0xFF), a) << 8;
+    out |= (zr_uint)rawfb_blend_channel(b, (int)((dst >> 16) & 0xFF), a) << 16;
+    out |= (zr_uint)rawfb_blend_channel(255, (int)((dst >> 24) & 0xFF), a) << 24;
+    return out;
+}
+
+static void
+rawfb_fill_span(zr_uint *dst, int count, int r, int g, int b, int a)
+{
+    int i = 0;
+    if (a <= 0) return;
+    if (a >= 255) {
+        const zr_uint color = (zr_uint)r|((zr_uint)g << 8)|((zr_uint)b << 16)|0xFF000000u;
+#if defined(RAWFB_SSE2)
+        const __m128i c = _mm_set1_epi32((int)color);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_si128((__m128i*)(void*)(dst + i), c);
+#elif defined(RAWFB_NEON)
+        const uint32x4_t c = vdupq_n_u32(color);
+        for (; i + 4 <= count; i += 4)
+            vst1q_u32((uint32_t*)(dst + i), c);
+#endif
+        for (; i < count; ++i)
+            dst[i] = color;
+        return;
+    }
+#if defined(RAWFB_SSE2)
+    {
+        /* blends four pixels at a time with 16-bit lanes per channel */
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(128);
+        const __m128i inv = _mm_set1_epi16((short)(255 - a));
+        const __m128i src = _mm_add_epi16(bias, _mm_mullo_epi16(_mm_set1_epi16((short)a),
+            _mm_set_epi16(255, (short)b, (short)g, (short)r, 255, (short)b, (short)g, (short)r)));
+        for (; i + 4 <= count; i += 4) {
+            __m128i d = _mm_loadu_si128((const __m128i*)(void*)(dst + i));
+            __m128i lo = _mm_unpacklo_epi8(d, zero);
+            __m128i hi = _mm_unpackhi_epi8(d, zero);
+            lo = _mm_add_epi16(src, _mm_mullo_epi16(lo, inv));
+            hi = _mm_add_epi16(src, _mm_mullo_epi16(hi, inv));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            _mm_storeu_si128((__m128i*)(void*)(dst + i), _mm_packus_epi16(lo, hi));
+        }
+    }
+#elif defined(RAWFB_NEON)
+    {
+        /* blends four pixels at a time with 16-bit lanes per channel */
+        uint16_t color[8];
+        uint16x8_t src;
+        const uint16x8_t inv = vdupq_n_u16((uint16_t)(255 - a));
+        color[0] = color[4] = (uint16_t)(r * a + 128);
+        color[1] = color[5] = (uint16_t)(g * a + 128);
+        color[2] = color[6] = (uint16_t)(b * a + 128);
+        color[3] = color[7] = (uint16_t)(255 * a + 128);
+        src = vld1q_u16(color);
+        for (; i + 4 <= count; i += 4) {
+            uint8x16_t d = vld1q_u8((const uint8_t*)(dst + i));
+            uint16x8_t lo = vmlaq_u16(src, vmovl_u8(vget_low_u8(d)), inv);
+            uint16x8_t hi = vmlaq_u16(src, vmovl_u8(vget_high_u8(d)), inv);
+            lo = vshrq_n_u16(vaddq_u16(lo, vshrq_n_u16(lo, 8)), 8);
+            hi = vshrq_n_u16(vaddq_u16(hi, vshrq_n_u16(hi, 8)), 8);
+            vst1q_u8((uint8_t*)(dst + i), vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+        }
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = rawfb_blend(dst[i], r, g, b, a);
+}
+
+static void
+rawfb_texel(const struct rawfb_image *img, int x, int y, float *out)
+{
+    zr_uint p;
+    x = CLAMP(0, x, img->w - 1);
+    y = CLAMP(0, y, img->h - 1);
+    p = img->pixels[y * img->w + x];
+    out[0] = (float)(p & 0xFF);
+    out[1] = (float)((p >> 8) & 0xFF);
+    out[2] = (float)((p >> 16) & 0xFF);
+    out[3] = (float)((p >> 24) & 0xFF);
+}
+
+static void
+rawfb_sample(const struct rawfb_image *img, float u, float v, float *out)
+{
+    /* bilinear filtered texture lookup with clamped edges */
+    int i, x, y;
+    float fx, fy;
+    float t00[4], t10[4], t01[4], t11[4];
+    u = u * (float)img->w - 0.5f;
+    v = v * (float)img->h - 0.5f;
+    x = (int)floor(u);
+    y = (int)floor(v);
+    fx = u - (float)x;
+    fy = v - (float)y;
+    rawfb_texel(img, x, y, t00);
+    rawfb_texel(img, x+1, y, t10);
+    rawfb_texel(img, x, y+1, t01);
+    rawfb_texel(img, x+1, y+1, t11);
+    for (i = 0; i < 4; ++i) {
+        const float top = t00[i] + (t10[i] - t00[i]) * fx;
+        const float bottom = t01[i] + (t11[i] - t01[i]) * fx;
+        out[i] = top + (bottom - top) * fy;
+    }
+}
+
+static void
+rawfb_unpack(zr_draw_vertex_color col, float *out)
+{
+    out[0] = (float)(col & 0xFF);
+    out[1] = (float)((col >> 8) & 0xFF);
+    out[2] = (float)((col >> 16) & 0xFF);
+    out[3] = (float)((col >> 24) & 0xFF);
+}
+
+static int
+rawfb_channel(float color, float texel)
+{
+    const int c = (int)(color * texel / 255.0f + 0.5f);
+    return CLAMP(0, c, 255);
+}
+
+static void
+rawfb_triangle(struct rawfb *fb, const struct rawfb_image *img,
+    const struct zr_draw_vertex *v0, const struct zr_draw_vertex *v1,
+    const struct zr_draw_vertex *v2, int x0, int y0, int x1, int y1)
+{
+    /* Scans all pixel rows inside the clipping rectangle. A pixel is drawn
+     * if its center is inside all three edges, inclusive on left edges and
+     * exclusive on right edges so shared triangle edges are only drawn once.
+     * Spans only depend on the triangle and the row, which makes the output
+     * independent from the tile size and thread count. */
+    int i, y, ymin, ymax;
+    float area, inv_area;
+    float edge[3][3];
+    float col[3][4];
+    const struct zr_draw_vertex *v[3];
+    int flat, flat_uv;
+    float texel[4];
+
+    area = (v1->position.x - v0->position.x) * (v2->position.y - v0->position.y) -
+           (v1->position.y - v0->position.y) * (v2->position.x - v0->position.x);
+    if (area == 0) return;
+    v[0] = v0;
+    v[1] = (area > 0) ? v1 : v2;
+    v[2] = (area > 0) ? v2 : v1;
+    area = (float)fabs(area);
+    inv_area = 1.0f / area;
+
+    /* edge i is opposite of vertex i: A * x + B * y + C >= 0 inside */
+    for (i = 0; i < 3; ++i) {
+        const struct zr_vec2 a = v[(i+1)%3]->position;
+        const struct zr_vec2 b = v[(i+2)%3]->position;
+        edge[i][0] = a.y - b.y;
+        edge[i][1] = b.x - a.x;
+        edge[i][2] = a.x * b.y - a.y * b.x;
+        rawfb_unpack(v[i]->col, col[i]);
+    }
+
+    flat_uv = v[0]->uv.x == v[1]->uv.x && v[0]->uv.x == v[2]->uv.x &&
+              v[0]->uv.y == v[1]->uv.y && v[0]->uv.y == v[2]->uv.y;
+    flat = flat_uv && v[0]->col == v[1]->col && v[0]->col == v[2]->col;
+    if (flat_uv) rawfb_sample(img, v[0]->uv.x, v[0]->uv.y, texel);
+
+    {
+        float miny = MIN(v[0]->position.y, MIN(v[1]->position.y, v[2]->position.y));
+        float maxy = MAX(v[0]->position.y, MAX(v[1]->position.y, v[2]->position.y));
+        miny = MAX(miny, (float)y0);
+        maxy = MIN(maxy, (float)y1);
+        ymin = (int)ceil(miny - 0.5f);
+        ymax = (int)ceil(maxy - 0.5f);
+        ymin = MAX(ymin, y0);
+        ymax = MIN(ymax, y1);
+    }
+
+    for (y = ymin; y < ymax; ++y) {
+        int x, px0, px1;
+        float k[3];
+        float xl = (float)x0, xr = (float)x1;
+        const float yc = (float)y + 0.5f;
+        zr_uint *row = fb->pixels + y * fb->width;
+
+        for (i = 0; i < 3; ++i) {
+            k[i] = edge[i][1] * yc + edge[i][2];
+            if (edge[i][0] > 0) xl = MAX(xl, -k[i] / edge[i][0]);
+            else if (edge[i][0] < 0) xr = MIN(xr, -k[i] / edge[i][0]);
+            else if (k[i] < 0) break;
+        }
+        if (i < 3 || xl >= xr) continue;
+        px0 = MAX((int)ceil(xl - 0.5f), x0);
+        px1 = MIN((int)ceil(xr - 0.5f), x1);
+        if (px0 >= px1) continue;
+
+        if (flat) {
+            rawfb_fill_span(row + px0, px1 - px0,
+                rawfb_channel(col[0][0], texel[0]), rawfb_channel(col[0][1], texel[1]),
+                rawfb_channel(col[0][2], texel[2]), rawfb_channel(col[0][3], texel[3]));
+            continue;
+        }
+        for (x = px0; x < px1; ++x) {
+            float w[3], c[4], t[4];
+            const float xc = (float)x + 0.5f;
+            w[0] = (edge[0][0] * xc + k[0]) * inv_area;
+            w[1] = (edge[1][0] * xc + k[1]) * inv_area;
+            w[2] = 1.0f - w[0] - w[1];
+            for (i = 0; i < 4; ++i)
+                c[i] = col[0][i] * w[0] + col[1][i] * w[1] + col[2][i] * w[2];
+            if (!flat_uv) {
+                const float u = v[0]->uv.x * w[0] + v[1]->uv.x * w[1] + v[2]->uv.x * w[2];
+                const float s = v[0]->uv.y * w[0] + v[1]->uv.y * w[1] + v[2]->uv.y * w[2];
+                rawfb_sample(img, u, s, t);
+            } else memcpy(t, texel, sizeof(t));
+            row[x] = rawfb_blend(row[x], rawfb_channel(c[0], t[0]),
+                rawfb_channel(c[1], t[1]), rawfb_channel(c[2], t[2]),
+                rawfb_channel(c[3], t[3]));
+        }
+    }
+}
+
+static void
+rawfb_clip(const struct zr_draw_command *cmd, int *x0, int *y0, int *x1, int *y1)
+{
+    /* integer scissor rectangle like `glScissor` in the OpenGL demos */
+    const int w = (int)cmd->clip_rect.w;
+    const int h = (int)cmd->clip_rect.h;
+    *x0 = (int)cmd->clip_rect.x;
+    *y1 = (int)(cmd->clip_rect.y + cmd->clip_rect.h);
+    *x1 = *x0 + w;
+    *y0 = *y1 - h;
+}
+
+static void
+rawfb_render_tile(void *data, unsigned int tile)
+{
+    unsigned int i;
+    struct rawfb *fb = (struct rawfb*)data;
+    const int tx0 = (int)(tile % (unsigned int)fb->tiles_x) * TILE_SIZE;
+    const int ty0 = (int)(tile / (unsigned int)fb->tiles_x) * TILE_SIZE;
+    const int tx1 = MIN(tx0 + TILE_SIZE, fb->width);
+    const int ty1 = MIN(ty0 + TILE_SIZE, fb->height);
+
+    for (i = fb->bin_offsets[tile]; i < fb->bin_offsets[tile+1]; ++i) {
+        struct rawfb_image white;
+        const struct rawfb_image *img;
+        int x0, y0, x1, y1;
+        const unsigned int tri = fb->bins[i];
+        const struct zr_draw_command *cmd = fb->commands[fb->triangle_command[tri]];
+        const zr_draw_index *idx = fb->elements + tri * 3;
+
+        img = (const struct rawfb_image*)cmd->texture.ptr;
+        if (!img) {
+            white.pixels = &rawfb_white;
+            white.w = white.h = 1;
+            img = &white;
+        }
+        rawfb_clip(cmd, &x0, &y0, &x1, &y1);
+        x0 = MAX(x0, tx0); y0 = MAX(y0, ty0);
+        x1 = MIN(x1, tx1); y1 = MIN(y1, ty1);
+        if (x0 >= x1 || y0 >= y1) continue;
+        rawfb_triangle(fb, img, &fb->vertexes[idx[0]], &fb->vertexes[idx[1]],
+            &fb->vertexes[idx[2]], x0, y0, x1, y1);
+    }
+}
+
+static void
+rawfb_bin(struct rawfb *fb)
+{
+    /* sorts all triangles into the tiles overlapped by their bounds */
+    unsigned int c, t, i;
+    unsigned int tri = 0;
+    const unsigned int tile_count = (unsigned int)(fb->tiles_x * fb->tiles_y);
+
+    memset(fb->bin_offsets, 0, (tile_count + 1) * sizeof(unsigned int));
+    for (c = 0; c < fb->command_count; ++c) {
+        int x0, y0, x1, y1;
+        const struct zr_draw_command *cmd = fb->commands[c];
+        const unsigned int count = cmd->elem_count / 3;
+        if (tri + count > fb->triangle_capacity) {
+            fb->triangle_command = (unsigned int*)grow(fb->triangle_command,
+                &fb->triangle_capacity, tri + count, sizeof(unsigned int));
+            fb->triangle_bounds = (struct rawfb_bounds*)realloc(fb->triangle_bounds,
+                fb->triangle_capacity * sizeof(struct rawfb_bounds));
+            if (!fb->triangle_bounds) die("[rawfb]: out of memory");
+        }
+
+        rawfb_clip(cmd, &x0, &y0, &x1, &y1);
+        x0 = MAX(x0, 0); y0 = MAX(y0, 0);
+        x1 = MIN(x1, fb->width); y1 = MIN(y1, fb->height);
+        for (t = 0; t < count; ++t, ++tri) {
+            float minx, miny, maxx, maxy;
+            struct rawfb_bounds *b = &fb->triangle_bounds[tri];
+            const zr_draw_index *idx = fb->elements + tri * 3;
+            const struct zr_vec2 p0 = fb->vertexes[idx[0]].position;
+            const struct zr_vec2 p1 = fb->vertexes[idx[1]].position;
+            const struct zr_vec2 p2 = fb->vertexes[idx[2]].position;
+
+            fb->triangle_command[tri] = c;
+            minx = MAX(MIN(p0.x, MIN(p1.x, p2.x)), (float)x0);
+            miny = MAX(MIN(p0.y, MIN(p1.y, p2.y)), (float)y0);
+            maxx = MIN(MAX(p0.x, MAX(p1.x, p2.x)), (float)x1);
+            maxy = MIN(MAX(p0.y, MAX(p1.y, p2.y)), (float)y1);
+            if (minx >= maxx || miny >= maxy) {
+                b->x0 = 0; b->x1 = -1;
+                continue;
+            }
+            b->x0 = (short)((int)minx / TILE_SIZE);
+            b->y0 = (short)((int)miny / TILE_SIZE);
+            b->x1 = (short)MIN((int)maxx / TILE_SIZE, fb->tiles_x - 1);
+            b->y1 = (short)MIN((int)maxy / TILE_SIZE, fb->tiles_y - 1);
+            {
+                int x, y;
+                for (y = b->y0; y <= b->y1; ++y)
+                for (x = b->x0; x <= b->x1; ++x)
+                    fb->bin_offsets[y * fb->tiles_x + x + 1]++;
+            }
+        }
+    }
+
+    /* prefix sum over the tile counts and fill in triangles in draw order */
+    for (i = 1; i <= tile_count; ++i)
+        fb->bin_offsets[i] += fb->bin_offsets[i-1];
+    fb->bins = (unsigned int*)grow(fb->bins, &fb->bin_capacity,
+        fb->bin_offsets[tile_count], sizeof(unsigned int));
+    for (i = 0; i < tri; ++i) {
+        int x, y;
+        const struct rawfb_bounds *b = &fb->triangle_bounds[i];
+        for (y = b->y0; y <= b->y1; ++y)
+        for (x = b->x0; x <= b->x1; ++x)
+            fb->bins[fb->bin_offsets[y * fb->tiles_x + x]++] = i;
+    }
+
+    /* filling moved every offset to the beginning of the next tile */
+    for (i = tile_count; i > 0; --i)
+        fb->bin_offsets[i] = fb->bin_offsets[i-1];
+    fb->bin_offsets[0] = 0;
+}
+
+static void
+rawfb_init(struct rawfb *fb, int width, int height)
+{
+    memset(fb, 0, sizeof(*fb));
+    fb->width = width;
+    fb->height = height;
+    fb->tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    fb->tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    fb->pixels = (zr_uint*)calloc((size_t)(width * height), sizeof(zr_uint));
+    fb->bin_offsets = (unsigned int*)calloc((size_t)(fb->tiles_x * fb->tiles_y + 1),
+                        sizeof(unsigned int));
+    if (!fb->pixels || !fb->bin_offsets)
+        die("[rawfb]: out of memory");
+}
+
+static void
+rawfb_free(struct rawfb *fb)
+{
+    free(fb->pixels);
+    free(fb->commands);
+    free(fb->triangle_command);
+    free(fb->triangle_bounds);
+    free(fb->bin_offsets);
+    free(fb->bins);
+    free(fb->queue);
+    free(fb->queue_bounds);
+}
+
+static void
+rawfb_render(struct rawfb *fb, struct zr_context *ctx, struct device *dev,
+    struct pool *pool)
+{
+    const struct zr_draw_command *cmd;
+    const unsigned int tile_count = (unsigned int)(fb->tiles_x * fb->tiles_y);
+
+    rawfb_fill_span(fb->pixels, fb->width * fb->height, CLEAR_COLOR & 0xFF,
+        (CLEAR_COLOR >> 8) & 0xFF, (CLEAR_COLOR >> 16) & 0xFF, 0xFF);
+
+    fb->vertexes = (const struct zr_draw_vertex*)zr_buffer_memory(&dev->vertexes);
+    fb->elements = (const zr_draw_index*)zr_buffer_memory(&dev->elements);
+    fb->command_count = 0;
+    zr_draw_foreach(cmd, ctx, &dev->cmds) {
+        fb->commands = (const struct zr_draw_command**)grow((void*)fb->commands,
+            &fb->command_capacity, fb->command_count + 1, sizeof(cmd));
+        fb->commands[fb->command_count++] = cmd;
+    }
+    rawfb_bin(fb);
+
+    if (pool) pool_dispatch(zr_handle_ptr(pool), rawfb_render_tile, fb, tile_count);
+    else {
+        unsigned int t;
+        for (t = 0; t < tile_count; ++t)
+            rawfb_render_tile(fb, t);
+    }
+}
+
+/* ==============================================================
+ *
+ *                      Direct rasterizer
+ *
+ * ===============================================================*/
+/*  Draws the command queue without converting it into vertexes first.
+    Rectangles, rounded rectangles and circles are scanned row by row with
+    coverage only calculated for the corner pixels, so every row apart from
+    the corners is filled with `rawfb_fill_span`. Text is copied glyph by
+    glyph out of the font image. Only lines, curves, arcs and triangles
+    are turned into triangles. */
+static int
+rawfb_intersect(struct rawfb_clip *out, const struct rawfb_clip *a,
+    int x0, int y0, int x1, int y1)
+{
+    out->x0 = MAX(a->x0, x0); out->y0 = MAX(a->y0, y0);
+    out->x1 = MIN(a->x1, x1); out->y1 = MIN(a->y1, y1);
+    return out->x0 < out->x1 && out->y0 < out->y1;
+}
+
+static void
+rawfb_blend_coverage(zr_uint *dst, struct zr_color c, float coverage)
+{
+    const int a = (int)((float)c.a * coverage + 0.5f);
+    if (a > 0) *dst = rawfb_blend(*dst, c.r, c.g, c.b, a);
+}
+
+static void
+rawfb_fill_rect(struct rawfb *fb, const struct rawfb_clip *clip,
+    int x, int y, int w, int h, float r, struct zr_color c)
+{
+    int py, ri;
+    struct rawfb_clip b;
+    if (!rawfb_intersect(&b, clip, x, y, x + w, y + h)) return;
+    r = MIN(r, (float)MIN(w, h) / 2.0f);
+    ri = (int)ceil(r);
+
+    for (py = b.y0; py < b.y1; ++py) {
+        int px, mx0, mx1;
+        float dy = 0;
+        zr_uint *row = fb->pixels + py * fb->width;
+        const float yc = (float)py + 0.5f;
+
+        /* distance into the top or bottom corner band */
+        if (yc < (float)y + r) dy = (float)y + r - yc;
+        else if (yc > (float)(y + h) - r) dy = yc - ((float)(y + h) - r);
+        if (dy <= 0) {
+            rawfb_fill_span(row + b.x0, b.x1 - b.x0, c.r, c.g, c.b, c.a);
+            continue;
+        }
+
+        mx0 = MAX(x + ri, b.x0);
+        mx1 = MIN(x + w - ri, b.x1);
+        for (px = b.x0; px < MIN(mx0, b.x1); ++px) {
+            const float dx = (float)x + r - ((float)px + 0.5f);
+            const float d = (float)sqrt(MAX(dx, 0) * MAX(dx, 0) + dy * dy);
+            rawfb_blend_coverage(&row[px], c, CLAMP(0.0f, r - d + 0.5f, 1.0f));
+        }
+        if (mx0 < mx1)
+            rawfb_fill_span(row + mx0, mx1 - mx0, c.r, c.g, c.b, c.a);
+        for (px = MAX(mx1, mx0); px < b.x1; ++px) {
+            const float dx = ((float)px + 0.5f) - ((float)(x + w) - r);
+            const float d = (float)sqrt(MAX(dx, 0) * MAX(dx, 0) + dy * dy);
+            rawfb_blend_coverage(&row[px], c, CLAMP(0.0f, r - d + 0.5f, 1.0f));
+        }
+    }
+}
+
+static void
+rawfb_fill_triangle(struct rawfb *fb, const struct rawfb_clip *clip,
+    struct zr_vec2 a, struct zr_vec2 b, struct zr_vec2 c, struct zr_color color)
+{
+    struct zr_draw_vertex v[3];
+    struct rawfb_image white;
+    white.pixels = &rawfb_white;
+    white.w = white.h = 1;
+    v[0].position = a; v[1].position = b; v[2].position = c;
+    v[0].uv = v[1].uv = v[2].uv = zr_vec2(0, 0);
+    v[0].col = v[1].col = v[2].col = zr_color32(color);
+    rawfb_triangle(fb, &white, &v[0], &v[1], &v[2], clip->x0, clip->y0, clip->x1, clip->y1);
+}
+
+static void
+rawfb_stroke_line(struct rawfb *fb, const struct rawfb_clip *clip,
+    struct zr_vec2 a, struct zr_vec2 b, struct zr_color color)
+{
+    /* one pixel wide line as quad along the pixel centers */
+    float len;
+    struct zr_vec2 n;
+    a.x += 0.5f; a.y += 0.5f;
+    b.x += 0.5f; b.y += 0.5f;
+    n = zr_vec2(a.y - b.y, b.x - a.x);
+    len = (float)sqrt(n.x * n.x + n.y * n.y);
+    if (len == 0) return;
+    n.x *= 0.5f / len; n.y *= 0.5f / len;
+    rawfb_fill_triangle(fb, clip, zr_vec2(a.x + n.x, a.y + n.y),
+        zr_vec2(b.x + n.x, b.y + n.y), zr_vec2(b.x - n.x, b.y - n.y), color);
+    rawfb_fill_triangle(fb, clip, zr_vec2(a.x + n.x, a.y + n.y),
+        zr_vec2(b.x - n.x, b.y - n.y), zr_vec2(a.x - n.x, a.y - n.y), color);
+}
+
+static void
+rawfb_draw_curve(struct rawfb *fb, const struct rawfb_clip *clip,
+    const struct zr_command_curve *q)
+{
+    unsigned int i;
+    struct zr_vec2 last;
+    const float t_step = 1.0f / (float)fb->curve_segments;
+    last = zr_vec2(q->begin.x, q->begin.y);
+    for (i = 1; i <= fb->curve_segments; ++i) {
+        struct zr_vec2 p;
+        const float t = t_step * (float)i;
+        const float u = 1.0f - t;
+        const float w1 = u * u * u;
+        const float w2 = 3 * u * u * t;
+        const float w3 = 3 * u * t * t;
+        const float w4 = t * t * t;
+        p.x = w1 * q->begin.x + w2 * q->ctrl[0].x + w3 * q->ctrl[1].x + w4 * q->end.x;
+        p.y = w1 * q->begin.y + w2 * q->ctrl[0].y + w3 * q->ctrl[1].y + w4 * q->end.y;
+        rawfb_stroke_line(fb, clip, last, p, q->color);
+        last = p;
+    }
+}
+
+static void
+rawfb_draw_arc(struct rawfb *fb, const struct rawfb_clip *clip,
+    const struct zr_command_arc *c)
+{
+    unsigned int i;
+    struct zr_vec2 center, last;
+    const float delta = (c->a[1] - c->a[0]) / (float)fb->curve_segments;
+    center = zr_vec2(c->cx, c->cy);
+    last = zr_vec2(center.x + (float)cos(c->a[0]) * c->r,
+                   center.y + (float)sin(c->a[0]) * c->r);
+    for (i = 1; i <= fb->curve_segments; ++i) {
+        const float a = c->a[0] + delta * (float)i;
+        const struct zr_vec2 p = zr_vec2(center.x + (float)cos(a) * c->r,
+                                         center.y + (float)sin(a) * c->r);
+        rawfb_fill_triangle(fb, clip, center, last, p, c->color);
+        last = p;
+    }
+}
+
+static void
+rawfb_draw_text(struct rawfb *fb, const struct rawfb_clip *clip,
+    const struct zr_command_text *t)
+{
+    float x, scale;
+    zr_size text_len;
+    zr_rune unicode, next;
+    zr_size glyph_len, next_glyph_len;
+    struct zr_user_font_glyph g;
+    const struct zr_user_font *font = &t->font;
+    const struct rawfb_image *img = (const struct rawfb_image*)font->texture.ptr;
+
+    scale = t->height / font->height;
+    x = (float)t->x;
+    glyph_len = text_len = zr_utf_decode(t->string, &unicode, t->length);
+    while (text_len <= t->length && glyph_len) {
+        int px, py;
+        float gx, gy, gw, gh;
+        struct rawfb_clip b;
+        if (unicode == ZR_UTF_INVALID) break;
+
+        next_glyph_len = zr_utf_decode(t->string + text_len, &next, t->length - text_len);
+        font->query(font->userdata, font->height, &g, unicode,
+                    (next == ZR_UTF_INVALID) ? '\0' : next);
+        gx = x + g.offset.x * scale;
+        gy = (float)t->y + ((float)t->h/2) - (font->height/2) + g.offset.y * scale;
+        gw = g.width * scale; gh = g.height * scale;
+
+        if (gw > 0 && gh > 0 && rawfb_intersect(&b, clip, (int)ceil(gx - 0.5f),
+            (int)ceil(gy - 0.5f), (int)ceil(gx + gw - 0.5f), (int)ceil(gy + gh - 0.5f))) {
+            if (!img) {
+                for (py = b.y0; py < b.y1; ++py)
+                    rawfb_fill_span(fb->pixels + py * fb->width + b.x0, b.x1 - b.x0,
+                        t->foreground.r, t->foreground.g, t->foreground.b, t->foreground.a);
+            } else {
+                /* nearest texel of the glyph image for every pixel center */
+                const float du = (g.uv[1].x - g.uv[0].x) * (float)img->w / gw;
+                const float dv = (g.uv[1].y - g.uv[0].y) * (float)img->h / gh;
+                for (py = b.y0; py < b.y1; ++py) {
+                    zr_uint *row = fb->pixels + py * fb->width;
+                    int ty = (int)(g.uv[0].y * (float)img->h + ((float)py + 0.5f - gy) * dv);
+                    const zr_uint *src;
+                    ty = CLAMP(0, ty, img->h - 1);
+                    src = img->pixels + ty * img->w;
+                    for (px = b.x0; px < b.x1; ++px) {
+                        int tx = (int)(g.uv[0].x * (float)img->w + ((float)px + 0.5f - gx) * du);
+                        int a;
+                        tx = CLAMP(0, tx, img->w - 1);
+                        a = rawfb_channel((float)t->foreground.a, (float)(src[tx] >> 24));
+                        if (a) row[px] = rawfb_blend(row[px], t->foreground.r,
+                                    t->foreground.g, t->foreground.b, a);
+                    }
+                }
+            }
+        }
+        text_len += glyph_len;
+        x += g.xadvance * scale;
+        glyph_len = next_glyph_len;
+        unicode = next;
+    }
+}
+
+static void
+rawfb_draw_image(struct rawfb *fb, const struct rawfb_clip *clip,
+    const struct zr_command_image *i)
+{
+    int px, py;
+    float u0 = 0, v0 = 0, uw, vh;
+    struct rawfb_clip b;
+    const struct rawfb_image *img = (const struct rawfb_image*)i->img.handle.ptr;
+    if (!img || !i->w || !i->h) return;
+    if (!rawfb_intersect(&b, clip, i->x, i->y, i->x + i->w, i->y + i->h)) return;
+
+    uw = (float)img->w; vh = (float)img->h;
+    if (i->img.w && i->img.h && (i->img.region[2] || i->img.region[3])) {
+        u0 = (float)i->img.region[0] * (float)img->w / (float)i->img.w;
+        v0 = (float)i->img.region[1] * (float)img->h / (float)i->img.h;
+        uw = (float)i->img.region[2] * (float)img->w / (float)i->img.w;
+        vh = (float)i->img.region[3] * (float)img->h / (float)i->img.h;
+    }
+    for (py = b.y0; py < b.y1; ++py) {
+        zr_uint *row = fb->pixels + py * fb->width;
+        int ty = (int)(v0 + ((float)(py - i->y) + 0.5f) * vh / (float)i->h);
+        ty = CLAMP(0, ty, img->h - 1);
+        for (px = b.x0; px < b.x1; ++px) {
+            zr_uint p;
+            int tx = (int)(u0 + ((float)(px - i->x) + 0.5f) * uw / (float)i->w);
+            tx = CLAMP(0, tx, img->w - 1);
+            p = img->pixels[ty * img->w + tx];
+            row[px] = rawfb_blend(row[px], (int)(p & 0xFF), (int)((p >> 8) & 0xFF),
+                (int)((p >> 16) & 0xFF), (int)(p >> 24));
+        }
+    }
+}
+
+static struct rawfb_clip
+rawfb_command_bounds(const struct zr_command *cmd)
+{
+    /* conservative pixel bounds of everything a command can touch */
+    struct rawfb_clip b;
+    b.x0 = b.y0 = -32768;
+    b.x1 = b.y1 = 32767;
+    switch (cmd->type) {
+    case ZR_COMMAND_LINE: {
+        const struct zr_command_line *l = zr_command(line, cmd);
+        b.x0 = MIN(l->begin.x, l->end.x); b.x1 = MAX(l->begin.x, l->end.x);
+        b.y0 = MIN(l->begin.y, l->end.y); b.y1 = MAX(l->begin.y, l->end.y);
+    } break;
+    case ZR_COMMAND_CURVE: {
+        const struct zr_command_curve *q = zr_command(curve, cmd);
+        b.x0 = MIN(MIN(q->begin.x, q->end.x), MIN(q->ctrl[0].x, q->ctrl[1].x));
+        b.x1 = MAX(MAX(q->begin.x, q->end.x), MAX(q->ctrl[0].x, q->ctrl[1].x));
+        b.y0 = MIN(MIN(q->begin.y, q->end.y), MIN(q->ctrl[0].y, q->ctrl[1].y));
+        b.y1 = MAX(MAX(q->begin.y, q->end.y), MAX(q->ctrl[0].y, q->ctrl[1].y));
+    } break;
+    case ZR_COMMAND_RECT: {
+        const struct zr_command_rect *r = zr_command(rect, cmd);
+        b.x0 = r->x; b.y0 = r->y; b.x1 = r->x + r->w; b.y1 = r->y + r->h;
+    } break;
+    case ZR_COMMAND_CIRCLE: {
+        const struct zr_command_circle *c = zr_command(circle, cmd);
+        b.x0 = c->x; b.y0 = c->y; b.x1 = c->x + c->w; b.y1 = c->y + c->h;
+    } break;
+    case ZR_COMMAND_ARC: {
+        const struct zr_command_arc *c = zr_command(arc, cmd);
+        b.x0 = c->cx - c->r; b.y0 = c->cy - c->r;
+        b.x1 = c->cx + c->r; b.y1 = c->cy + c->r;
+    } break;
+    case ZR_COMMAND_TRIANGLE: {
+        const struct zr_command_triangle *t = zr_command(triangle, cmd);
+        b.x0 = MIN(t->a.x, MIN(t->b.x, t->c.x)); b.x1 = MAX(t->a.x, MAX(t->b.x, t->c.x));
+        b.y0 = MIN(t->a.y, MIN(t->b.y, t->c.y)); b.y1 = MAX(t->a.y, MAX(t->b.y, t->c.y));
+    } break;
+    case ZR_COMMAND_TEXT: {
+        /* glyphs are centered on the text height and can reach past it */
+        const struct zr_command_text *t = zr_command(text, cmd);
+        const int h = (int)MAX(t->height, (float)t->h);
+        b.x0 = t->x; b.x1 = t->x + t->w;
+        b.y0 = t->y + t->h/2 - h; b.y1 = t->y + t->h/2 + h;
+    } break;
+    case ZR_COMMAND_IMAGE: {
+        const struct zr_command_image *i = zr_command(image, cmd);
+        b.x0 = i->x; b.y0 = i->y; b.x1 = i->x + i->w; b.y1 = i->y + i->h;
+    } break;
+    default: return b;
+    }
+    b.x0 -= 2; b.y0 -= 2;
+    b.x1 += 2; b.y1 += 2;
+    return b;
+}
+
+static void
+rawfb_draw_tile(void *data, unsigned int tile)
+{
+    int y;
+    unsigned int i;
+    struct rawfb_clip tile_clip, clip;
+    struct rawfb *fb = (struct rawfb*)data;
+
+    tile_clip.x0 = (int)(tile % (unsigned int)fb->tiles_x) * TILE_SIZE;
+    tile_clip.y0 = (int)(tile / (unsigned int)fb->tiles_x) * TILE_SIZE;
+    tile_clip.x1 = MIN(tile_clip.x0 + TILE_SIZE, fb->width);
+    tile_clip.y1 = MIN(tile_clip.y0 + TILE_SIZE, fb->height);
+    clip = tile_clip;
+    for (y = tile_clip.y0; y < tile_clip.y1; ++y) {
+        rawfb_fill_span(fb->pixels + y * fb->width + tile_clip.x0,
+            tile_clip.x1 - tile_clip.x0, CLEAR_COLOR & 0xFF,
+            (CLEAR_COLOR >> 8) & 0xFF, (CLEAR_COLOR >> 16) & 0xFF, 0xFF);
+    }
+
+    for (i = 0; i < fb->queue_count; ++i) {
+        const struct rawfb_clip *c = &clip;
+        const struct zr_command *cmd = fb->queue[i];
+        if (cmd->type == ZR_COMMAND_SCISSOR) {
+            const struct zr_command_scissor *s = zr_command(scissor, cmd);
+            if (!rawfb_intersect(&clip, &tile_clip, s->x, s->y, s->x + s->w, s->y + s->h))
+                clip.x1 = clip.x0;
+            continue;
+        }
+        if (clip.x0 >= clip.x1) continue;
+        {
+            const struct rawfb_clip *b = &fb->queue_bounds[i];
+            if (b->x1 <= clip.x0 || b->x0 >= clip.x1 ||
+                b->y1 <= clip.y0 || b->y0 >= clip.y1) continue;
+        }
+
+        switch (cmd->type) {
+        case ZR_COMMAND_LINE: {
+            const struct zr_command_line *l = zr_command(line, cmd);
+            rawfb_stroke_line(fb, c, zr_vec2(l->begin.x, l->begin.y),
+                zr_vec2(l->end.x, l->end.y), l->color);
+        } break;
+        case ZR_COMMAND_CURVE:
+            rawfb_draw_curve(fb, c, zr_command(curve, cmd));
+            break;
+        case ZR_COMMAND_RECT: {
+            const struct zr_command_rect *r = zr_command(rect, cmd);
+            rawfb_fill_rect(fb, c, r->x, r->y, r->w, r->h, (float)r->rounding, r->color);
+        } break;
+        case ZR_COMMAND_CIRCLE: {
+            const struct zr_command_circle *r = zr_command(circle, cmd);
+            rawfb_fill_rect(fb, c, r->x, r->y, r->w, r->h, (float)r->w/2, r->color);
+        } break;
+        case ZR_COMMAND_ARC:
+            rawfb_draw_arc(fb, c, zr_command(arc, cmd));
+            break;
+        case ZR_COMMAND_TRIANGLE: {
+            const struct zr_command_triangle *t = zr_command(triangle, cmd);
+            rawfb_fill_triangle(fb, c, zr_vec2(t->a.x, t->a.y),
+                zr_vec2(t->b.x, t->b.y), zr_vec2(t->c.x, t->c.y), t->color);
+        } break;
+        case ZR_COMMAND_TEXT:
+            rawfb_draw_text(fb, c, zr_command(text, cmd));
+            break;
+        case ZR_COMMAND_IMAGE:
+            rawfb_draw_image(fb, c, zr_command(image, cmd));
+            break;
+        default: break;
+        }
+    }
+}
+
+static void
+rawfb_draw(struct rawfb *fb, const struct zr_frame *frame,
+    unsigned int curve_segments, struct pool *pool)
+{
+    const struct zr_command *cmd;
+    const unsigned int tile_count = (unsigned int)(fb->tiles_x * fb->tiles_y);
+
+    /* the queue is collected once so tiles can skip commands by bounds */
+    fb->queue_count = 0;
+    fb->curve_segments = MAX(curve_segments, 1);
+    zr_frame_foreach(cmd, frame) {
+        if (cmd->type == ZR_COMMAND_NOP) continue;
+        if (fb->queue_count == fb->queue_capacity) {
+            fb->queue = (const struct zr_command**)grow((void*)fb->queue,
+                &fb->queue_capacity, fb->queue_count + 1, sizeof(cmd));
+            fb->queue_bounds = (struct rawfb_clip*)realloc(fb->queue_bounds,
+                fb->queue_capacity * sizeof(struct rawfb_clip));
+            if (!fb->queue_bounds) die("[rawfb]: out of memory");
+        }
+        fb->queue_bounds[fb->queue_count] = rawfb_command_bounds(cmd);
+        fb->queue[fb->queue_count++] = cmd;
+    }
+
+    if (pool) pool_dispatch(zr_handle_ptr(pool), rawfb_draw_tile, fb, tile_count);
+    else {
+        unsigned int t;
+        for (t = 0; t < tile_count; ++t)
+            rawfb_draw_tile(fb, t);
+    }
+}
+
+static void
+rawfb_write_ppm(const struct rawfb *fb, const char *path)
+{
+    int i;
+    FILE *fd = fopen(path, "wb");
+    if (!fd) die("Failed to open file: %s\n", path);
+    fprintf(fd, "P6\n%d %d\n255\n", fb->width, fb->height);
+    for (i = 0; i < fb->width * fb->height; ++i) {
+        const zr_uint p = fb->pixels[i];
+        fputc((int)(p & 0xFF), fd);
+        fputc((int)((p >> 8) & 0xFF), fd);
+        fputc((int)((p >> 16) & 0xFF), fd);
+    }
+    fclose(fd);
+}
+
+static unsigned long
+rawfb_checksum(const struct rawfb *fb)
+{
+    int i;
+    unsigned long hash = 5381;
+    for (i = 0; i < fb->width * fb->height; ++i)
+        hash = (hash * 33u) ^ fb->pixels[i];
+    return hash & 0xFFFFFFFFu;
+}
+
+/* ==============================================================
+ *
+ *                      Render thread
+ *
+ * ===============================================================*/
+static void*
+pipeline_render(void *arg)
+{
+    struct pipeline *p = (struct pipeline*)arg;
+    pthread_mutex_lock(&p->mutex);
+    while (1) {
+        while (!p->quit && !p->pending)
+            pthread_cond_wait(&p->cond, &p->mutex);
+        if (!p->pending) break;
+        pthread_mutex_unlock(&p->mutex);
+        rawfb_draw(p->fb, &p->frame, p->curve_segments, 0);
+        pthread_mutex_lock(&p->mutex);
+        p->pending = 0;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->mutex);
+    return NULL;
+}
+
+static void
+pipeline_wait(struct pipeline *p)
+{
+    pthread_mutex_lock(&p->mutex);
+    while (p->pending)
+        pthread_cond_wait(&p->cond, &p->mutex);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+static void
+pipeline_submit(struct pipeline *p, struct zr_context *ctx)
+{
+    /* waits for the previous frame so its command buffer can be reused by the
+     * following `zr_clear` and hands over the current frame */
+    pthread_mutex_lock(&p->mutex);
+    while (p->pending)
+        pthread_cond_wait(&p->cond, &p->mutex);
+    zr_frame_get(ctx, &p->frame);
+    p->pending = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+}
+
+static void
+pipeline_init(struct pipeline *p, struct rawfb *fb, unsigned int curve_segments)
+{
+    memset(p, 0, sizeof(*p));
+    p->fb = fb;
+    p->curve_segments = curve_segments;
+    pthread_mutex_init(&p->mutex, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    if (pthread_create(&p->thread, NULL, pipeline_render, p))
+        die("[pipeline]: failed to create thread");
+}
+
+static void
+pipeline_free(struct pipeline *p)
+{
+    pthread_mutex_lock(&p->mutex);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    pthread_join(p->thread, NULL);
+    pthread_mutex_destroy(&p->mutex);
+    pthread_cond_destroy(&p->cond);
+}
+
+/* ==============================================================
+ *
+ *                      Font
+ *
+ * ===============================================================*/
+static zr_size
+dummy_text_width(zr_handle handle, float height, const char *text, zr_size len)
+{
+    UNUSED(handle);
+    UNUSED(height);
+    return zr_utf_len(text, len) * DUMMY_GLYPH_WIDTH;
+}
+
+static void
+dummy_query_glyph(zr_handle handle, float height, struct zr_user_font_glyph *glyph,
+    zr_rune codepoint, zr_rune next_codepoint)
+{
+    UNUSED(handle);
+    UNUSED(codepoint);
+    UNUSED(next_codepoint);
+    glyph->uv[0] = zr_vec2(0, 0);
+    glyph->uv[1] = zr_vec2(0, 0);
+    glyph->offset = zr_vec2(1, 3);
+    glyph->width = DUMMY_GLYPH_WIDTH - 2;
+    glyph->height = height - 6;
+    glyph->xadvance = DUMMY_GLYPH_WIDTH;
+}
+
+static struct zr_user_font
+font_dummy(struct device *dev)
+{
+    struct zr_user_font user_font;
+    memset(&user_font, 0, sizeof(user_font));
+    user_font.height = FONT_HEIGHT;
+    user_font.width = dummy_text_width;
+    user_font.query = dummy_query_glyph;
+    user_font.texture = dev->null.texture;
+    return user_font;
+}
+
+static struct zr_user_font
+font_bake(struct device *dev, const char *path)
+{
+    int glyph_count;
+    int img_width, img_height;
+    struct zr_baked_font baked_font;
+    struct zr_recti custom;
+    struct zr_font_config config;
+    void *img, *tmp;
+    zr_uint *img_rgba;
+    size_t ttf_size;
+    size_t tmp_size, img_size;
+    char *ttf_blob = file_load(path, &ttf_size);
+
+    memset(&baked_font, 0, sizeof(baked_font));
+    memset(&custom, 0, sizeof(custom));
+    memset(&config, 0, sizeof(config));
+    config.ttf_blob = ttf_blob;
+    config.ttf_size = ttf_size;
+    config.font = &baked_font;
+    config.coord_type = ZR_COORD_UV;
+    config.range = zr_font_default_glyph_ranges();
+    config.pixel_snap = zr_false;
+    config.size = (float)FONT_HEIGHT;
+    config.spacing = zr_vec2(0,0);
+    config.oversample_h = 1;
+    config.oversample_v = 1;
+
+    /* bake font into an alpha image and convert it into the RGBA texture */
+    zr_font_bake_memory(&tmp_size, &glyph_count, &config, 1);
+    dev->glyphes = (struct zr_font_glyph*)calloc(sizeof(struct zr_font_glyph), (size_t)glyph_count);
+    tmp = calloc(1, tmp_size);
+    custom.w = 2; custom.h = 2;
+    if (!zr_font_bake_pack(&img_size, &img_width, &img_height, &custom, tmp, tmp_size, &config, 1))
+        die("[Font]: failed to load font!\n");
+    img = calloc(1, img_size);
+    zr_font_bake(img, img_width, img_height, tmp, tmp_size, dev->glyphes, glyph_count, &config, 1);
+    zr_font_bake_custom_data(img, img_width, img_height, custom, "....", 2, 2, '.', 'X');
+    img_rgba = (zr_uint*)calloc(sizeof(zr_uint), (size_t)(img_width * img_height));
+    zr_font_bake_convert(img_rgba, img_width, img_height, img);
+    free(ttf_blob);
+    free(tmp);
+    free(img);
+
+    dev->font_image.pixels = img_rgba;
+    dev->font_image.w = img_width;
+    dev->font_image.h = img_height;
+    dev->null.texture = zr_handle_ptr(&dev->font_image);
+    dev->null.uv = zr_vec2((custom.x + 0.5f)/(float)img_width,
+                            (custom.y + 0.5f)/(float)img_height);
+    zr_font_init(&dev->font, (float)FONT_HEIGHT, '?', dev->glyphes,
+                &baked_font, dev->null.texture);
+    return zr_font_ref(&dev->font);
+}
+
+/* ==============================================================
+ *
+ *                      Input script
+ *
+ * ===============================================================*/
+static void
+input_script(struct zr_context *ctx, unsigned long frame)
+{
+    /* the mouse sweeps over the right part of the demo window and clicks
+     * from time to time so tree nodes open and the screen content changes */
+    const int x = 230 + (int)((frame * 7) % 190);
+    const int y = 110 + (int)((frame * 13) % 500);
+
+    zr_input_begin(ctx);
+    zr_input_motion(ctx, x, y);
+    if ((frame % 30) == 0)
+        zr_input_button(ctx, ZR_BUTTON_LEFT, x, y, zr_true);
+    else if ((frame % 30) == 1)
+        zr_input_button(ctx, ZR_BUTTON_LEFT, x, y, zr_false);
+    zr_input_end(ctx);
+}
+
+/* ==============================================================
+ *
+ *                      Main
+ *
+ * ===============================================================*/
+enum timing {
+    TIME_BUILD,
+    TIME_CONVERT,
+    TIME_RASTER,
+    TIME_RASTER_THREADS,
+    TIME_DIRECT,
+    TIME_DIRECT_THREADS,
+    TIME_PIPELINE,
+    TIME_MAX
+};
+
+static void
+compare(const struct rawfb *a, const struct rawfb *b, const char *name,
+    unsigned long frame)
+{
+    if (memcmp(a->pixels, b->pixels, (size_t)(a->width * a->height) * sizeof(zr_uint)))
+        die("[%s]: frame %lu differs between serial and parallel rendering", name, frame);
+}
+
+static double
+difference(const struct rawfb *a, const struct rawfb *b)
+{
+    /* percentage of pixels with any channel off by more than a few steps */
+    int i, j, count = 0;
+    for (i = 0; i < a->width * a->height; ++i) {
+        for (j = 0; j < 32; j += 8) {
+            const int ca = (int)((a->pixels[i] >> j) & 0xFF);
+            const int cb = (int)((b->pixels[i] >> j) & 0xFF);
+            if (ca - cb > 16 || cb - ca > 16) {
+                count++;
+                break;
+            }
+        }
+    }
+    return 100.0 * (double)count / (double)(a->width * a->height);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int i;
+    int running = 1;
+    unsigned long frame;
+    unsigned long frames = DEFAULT_FRAMES;
+    unsigned long triangles = 0;
+    unsigned long commands = 0;
+    double times[TIME_MAX];
+    double diff = 0;
+    const char *screenshot = 0;
+    const char *direct_screenshot = 0;
+    int threads = 0;
+    struct device device;
+    struct rawfb raster, direct, parallel, pipelined;
+    struct demo gui;
+    struct pool pool;
+    static const char *time_names[] = {
+        "build", "convert", "raster", "raster mt", "direct", "direct mt", "pipelined"
+    };
+
+    if (argc > 1) frames = strtoul(argv[1], NULL, 10);
+    if (argc > 2) threads = atoi(argv[2]);
+    if (argc > 4) screenshot = argv[4];
+    if (argc > 5) direct_screenshot = argv[5];
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    memset(&device, 0, sizeof(device));
+    memset(&gui, 0, sizeof(gui));
+    memset(times, 0, sizeof(times));
+
+    {
+        /* GUI */
+        struct zr_user_font usrfnt;
+        struct zr_allocator alloc;
+        alloc.userdata.ptr = NULL;
+        alloc.alloc = mem_alloc;
+        alloc.free = mem_free;
+        zr_buffer_init(&device.cmds, &alloc, 1024);
+        zr_buffer_init(&device.vertexes, &alloc, 64 * 1024);
+        zr_buffer_init(&device.elements, &alloc, 16 * 1024);
+        device.null.texture.ptr = NULL;
+        if (argc > 3)
+            usrfnt = font_bake(&device, argv[3]);
+        else usrfnt = font_dummy(&device);
+        zr_init_buffered(&gui.ctx, &alloc, &usrfnt, 2);
+    }
+    rawfb_init(&raster, WINDOW_WIDTH, WINDOW_HEIGHT);
+    rawfb_init(&direct, WINDOW_WIDTH, WINDOW_HEIGHT);
+    rawfb_init(&parallel, WINDOW_WIDTH, WINDOW_HEIGHT);
+    rawfb_init(&pipelined, WINDOW_WIDTH, WINDOW_HEIGHT);
+    if (threads > 0)
+        pool_init(&pool, threads);
+
+    for (frame = 0; frame < frames; ++frame) {
+        double begin, end;
+        struct zr_frame handle;
+        struct zr_convert_config config;
+        struct zr_context *ctx = &gui.ctx;
+
+        begin = timestamp();
+        input_script(ctx, frame);
+        running = run_demo(&gui);
+        end = timestamp();
+        times[TIME_BUILD] += end - begin;
+
+        /* convert + raster */
+        memset(&config, 0, sizeof(config));
+        config.shape_AA = ZR_ANTI_ALIASING_ON;
+        config.line_AA = ZR_ANTI_ALIASING_ON;
+        config.circle_segment_count = 22;
+        config.line_thickness = 1.0f;
+        config.null = device.null;
+        if (threads > 0) {
+            config.dispatch = pool_dispatch;
+            config.userdata = zr_handle_ptr(&pool);
+        }
+        begin = timestamp();
+        zr_convert(ctx, &device.cmds, &device.vertexes, &device.elements, &config);
+        end = timestamp();
+        times[TIME_CONVERT] += end - begin;
+        triangles += ctx->canvas.element_count / 3;
+
+        begin = timestamp();
+        rawfb_render(&raster, ctx, &device, 0);
+        end = timestamp();
+        times[TIME_RASTER] += end - begin;
+        if (threads > 0) {
+            begin = timestamp();
+            rawfb_render(&parallel, ctx, &device, &pool);
+            end = timestamp();
+            times[TIME_RASTER_THREADS] += end - begin;
+            compare(&raster, &parallel, "raster", frame);
+        }
+
+        /* direct command drawing */
+        begin = timestamp();
+        zr_frame_get(ctx, &handle);
+        rawfb_draw(&direct, &handle, config.circle_segment_count, 0);
+        end = timestamp();
+        times[TIME_DIRECT] += end - begin;
+        commands += direct.queue_count;
+        if (threads > 0) {
+            begin = timestamp();
+            rawfb_draw(&parallel, &handle, config.circle_segment_count, &pool);
+            end = timestamp();
+            times[TIME_DIRECT_THREADS] += end - begin;
+            compare(&direct, &parallel, "direct", frame);
+        }
+        diff = difference(&raster, &direct);
+
+        zr_clear(ctx);
+        if (!running) {
+            frame++;
+            break;
+        }
+    }
+
+    if (frame && running) {
+        /* pipelined: the render thread draws the last frame while the UI
+         * thread builds the next one into the second command buffer */
+        struct pipeline pipe;
+        unsigned long count;
+        const double begin = timestamp();
+        pipeline_init(&pipe, &pipelined, 22);
+        for (count = 0; count < frame && running; ++count) {
+            input_script(&gui.ctx, frame + count);
+            running = run_demo(&gui);
+            pipeline_submit(&pipe, &gui.ctx);
+            zr_clear(&gui.ctx);
+        }
+        pipeline_wait(&pipe);
+        times[TIME_PIPELINE] = (timestamp() - begin) * (double)frame / (double)count;
+
+        /* the last frame is still valid after one clear and has to match */
+        rawfb_draw(&parallel, &pipe.frame, 22, 0);
+        compare(&parallel, &pipelined, "pipelined", frame + count - 1);
+        pipeline_free(&pipe);
+    }
+
+    if (frame) {
+        const double n = (double)frame;
+        fprintf(stdout, "frames: %lu  size: %dx%d  tiles: %d  threads: %d  simd: %s\n", frame,
+            raster.width, raster.height, raster.tiles_x * raster.tiles_y, threads,
+#if defined(RAWFB_SSE2)
+            "sse2"
+#elif defined(RAWFB_NEON)
+            "neon"
+#else
+            "off"
+#endif
+        );
+        fprintf(stdout, "triangles/frame: %.1f  commands/frame: %.1f\n\n",
+            (double)triangles / n, (double)commands / n);
+        for (i = 0; i < TIME_MAX; ++i) {
+            if (!times[i]) continue;
+            fprintf(stdout, "%-12s %10.3f ms/frame\n", time_names[i], times[i] / (n * 1e6));
+        }
+        fprintf(stdout, "\nconvert+raster / direct: %.2fx\n",
+            (times[TIME_CONVERT] + times[TIME_RASTER]) / times[TIME_DIRECT]);
+        if (times[TIME_PIPELINE])
+            fprintf(stdout, "build+direct / pipelined: %.2fx\n",
+                (times[TIME_BUILD] + times[TIME_DIRECT]) / times[TIME_PIPELINE]);
+        fprintf(stdout, "pixels differing between raster and direct: %.2f%%\n", diff);
+        fprintf(stdout, "checksum raster: %08lx  direct: %08lx\n",
+            rawfb_checksum(&raster), rawfb_checksum(&direct));
+        if (screenshot) rawfb_write_ppm(&raster, screenshot);
+        if (direct_screenshot) rawfb_write_ppm(&direct, direct_screenshot);
+    }
+
+    if (threads > 0)
+        pool_free(&pool);
+    rawfb_free(&raster);
+    rawfb_free(&direct);
+    rawfb_free(&parallel);
+    rawfb_free(&pipelined);
+    free(device.glyphes);
+    free((void*)device.font_image.pixels);
+    zr_free(&gui.ctx);
+    zr_buffer_free(&device.cmds);
+    zr_buffer_free(&device.vertexes);
+    zr_buffer_free(&device.elements);
+    return 0;
+}
@@ -34,6 +34,7 @@
 
 /* macros */
 #define DTIME       16
+#define MAX_DAMAGE  16
 #include "../../zahnrad.h"
 #include "../demo.c"
 
@@ -56,6 +57,8 @@ struct XSurface {
     Window root;
     Drawable drawable;
     unsigned int w, h;
+    XRectangle damage[MAX_DAMAGE];
+    int damage_count;
 };
 
 struct XWindow {
@@ -71,6 +74,7 @@ struct XWindow {
     int screen;
     unsigned int width;
     unsigned int height;
+    int redraw;
 };
 
 static void
@@ -206,15 +210,40 @@ surface_resize(XSurface *surf, unsigned int w, unsigned int h) {
         (unsigned int)DefaultDepth(surf->dpy, surf->screen));
 }
 
+static void
+surface_damage(XSurface *surf, const struct zr_rect *rects, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i) {
+        surf->damage[i].x = (short)(rects[i].x-1);
+        surf->damage[i].y = (short)(rects[i].y-1);
+        surf->damage[i].width = (unsigned short)(rects[i].w+2);
+        surf->damage[i].height = (unsigned short)(rects[i].h+2);
+    }
+    surf->damage_count = count;
+    XSetClipRectangles(surf->dpy, surf->gc, 0, 0, surf->damage, count, Unsorted);
+}
+
 static void
 surface_scissor(XSurface *surf, float x, float y, float w, float h)
 {
-    XRectangle clip_rect;
-    clip_rect.x = (short)(x-1);
-    clip_rect.y = (short)(y-1);
-    clip_rect.width = (unsigned short)(w+2);
-    clip_rect.height = (unsigned short)(h+2);
-    XSetClipRectangles(surf->dpy, surf->gc, 0, 0, &clip_rect, 1, Unsorted);
+    /* only draw inside the damaged parts of the clipping rectangle */
+    int i, n = 0;
+    XRectangle clip_rect[MAX_DAMAGE];
+    for (i = 0; i < surf->damage_count; ++i) {
+        const XRectangle *d = &surf->damage[i];
+        int x0 = MAX((int)(x-1), d->x);
+        int y0 = MAX((int)(y-1), d->y);
+        int x1 = MIN((int)(x+w+1), d->x + (int)d->width);
+        int y1 = MIN((int)(y+h+1), d->y + (int)d->height);
+        if (x1 <= x0 || y1 <= y0) continue;
+        clip_rect[n].x = (short)x0;
+        clip_rect[n].y = (short)y0;
+        clip_rect[n].width = (unsigned short)(x1 - x0);
+        clip_rect[n].height = (unsigned short)(y1 - y0);
+        n++;
+    }
+    XSetClipRectangles(surf->dpy, surf->gc, 0, 0, clip_rect, n, Unsorted);
 }
 
 static void
@@ -337,9 +366,15 @@ surface_clear(XSurface *surf, unsigned long color)
 }
 
 static void
-surface_blit(Drawable target, XSurface *surf, unsigned int width, unsigned int height)
+surface_blit(Drawable target, XSurface *surf)
 {
-    XCopyArea(surf->dpy, surf->drawable, target, surf->gc, 0, 0, width, height, 0, 0);
+    int i;
+    XSetClipMask(surf->dpy, surf->gc, None);
+    for (i = 0; i < surf->damage_count; ++i) {
+        const XRectangle *d = &surf->damage[i];
+        XCopyArea(surf->dpy, surf->drawable, target, surf->gc, d->x, d->y,
+            d->width, d->height, d->x, d->y);
+    }
 }
 
 static void
@@ -459,6 +494,7 @@ main(int argc, char *argv[])
     xw.height = (unsigned int)xw.attr.height;
     xw.surf = surface_create(xw.dpy, xw.screen, xw.win, xw.width, xw.height);
     xw.font = font_create(xw.dpy, "fixed");
+    xw.redraw = 1;
 
     /* GUI */
     font.userdata = zr_handle_ptr(xw.font);
@@ -485,8 +521,10 @@ main(int argc, char *argv[])
                 input_button(&gui.ctx, &evt, zr_false);
             else if (evt.type == MotionNotify)
                 input_motion(&gui.ctx, &evt);
-            else if (evt.type == Expose || evt.type == ConfigureNotify)
+            else if (evt.type == Expose || evt.type == ConfigureNotify) {
                 resize(&xw, xw.surf);
+                xw.redraw = 1;
+            }
             else if (evt.type == KeymapNotify)
                 XRefreshKeyboardMapping(&evt.xmapping);
         }
@@ -495,11 +533,20 @@ main(int argc, char *argv[])
         /* GUI */
         running = run_demo(&gui);
 
-        /* Draw */
-        XClearWindow(xw.dpy, xw.win);
-        surface_clear(xw.surf, 0x00303030);
+        /* Draw only the parts of the surface that changed */
         {
+            struct zr_rect damage[MAX_DAMAGE];
+            int count = zr_damage(&gui.ctx, damage, MAX_DAMAGE);
+            if (xw.redraw) {
+                damage[0] = zr_rect(0, 0, (float)xw.width, (float)xw.height);
+                count = 1;
+                xw.redraw = 0;
+            }
+            surface_damage(xw.surf, damage, count);
+        }
+        if (xw.surf->damage_count) {
             const struct zr_command *cmd;
+            surface_clear(xw.surf, 0x00303030);
             zr_foreach(cmd, &gui.ctx) {
                 switch (cmd->type) {
                 case ZR_COMMAND_NOP: break;
@@ -529,7 +576,7 @@ main(int argc, char *argv[])
                     const struct zr_command_text *t = zr_command(text, cmd);
                     surface_draw_text(xw.surf, t->x, t->y, t->w, t->h,
                         (const char*)t->string, t->length,
-                        (XFont*)t->font->userdata.ptr,
+                        (XFont*)t->font.userdata.ptr,
                         t->background, t->foreground);
                 } break;
                 case ZR_COMMAND_CURVE:
@@ -538,9 +585,9 @@ main(int argc, char *argv[])
                 default: break;
                 }
             }
-            zr_clear(&gui.ctx);
         }
-        surface_blit(xw.win, xw.surf, xw.width, xw.height);
+        zr_clear(&gui.ctx);
+        surface_blit(xw.win, xw.surf);
         XFlush(xw.dpy);
 
         /* Timing */
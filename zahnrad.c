@@ -27,6 +27,12 @@
 #define ZR_POOL_DEFAULT_CAPACITY 16
 #define ZR_VALUE_PAGE_CAPACITY 32
 #define ZR_DEFAULT_COMMAND_BUFFER_SIZE (4*1024)
+#define ZR_MAX_DRAW_VERTEXES 65536
+#define ZR_WINDOW_INDEX_MIN_SIZE 32
+#define ZR_VALUE_INDEX_MIN_SIZE 128
+#define ZR_TEXT_CACHE_PROBE 8
+#define ZR_TEXT_WIDTH_CACHE_SIZE 512
+#define ZR_TEXT_WIDTH_SIZE 48
 
 enum zr_heading {
     ZR_UP,
@@ -72,33 +78,38 @@ struct zr_edit_box {
 };
 
 enum zr_internal_window_flags {
-    ZR_WINDOW_PRIVATE       = ZR_FLAG(9),
+    ZR_WINDOW_PRIVATE       = ZR_FLAG(10),
     /* dummy flag which mark the beginning of the private window flag part */
-    ZR_WINDOW_ROM           = ZR_FLAG(10),
+    ZR_WINDOW_ROM           = ZR_FLAG(11),
     /* sets the window into a read only mode and does not allow input changes */
-    ZR_WINDOW_HIDDEN        = ZR_FLAG(11),
+    ZR_WINDOW_HIDDEN        = ZR_FLAG(12),
     /* Hiddes the window and stops any window interaction and drawing can be set
      * by user input or by closing the window */
-    ZR_WINDOW_MINIMIZED     = ZR_FLAG(12),
+    ZR_WINDOW_MINIMIZED     = ZR_FLAG(13),
     /* marks the window as minimized */
-    ZR_WINDOW_SUB           = ZR_FLAG(13),
+    ZR_WINDOW_SUB           = ZR_FLAG(14),
     /* Marks the window as subwindow of another window*/
-    ZR_WINDOW_GROUP         = ZR_FLAG(14),
+    ZR_WINDOW_GROUP         = ZR_FLAG(15),
     /* Marks the window as window widget group */
-    ZR_WINDOW_POPUP         = ZR_FLAG(15),
+    ZR_WINDOW_POPUP         = ZR_FLAG(16),
     /* Marks the window as a popup window */
-    ZR_WINDOW_NONBLOCK      = ZR_FLAG(16),
+    ZR_WINDOW_NONBLOCK      = ZR_FLAG(17),
     /* Marks the window as a nonblock popup window */
-    ZR_WINDOW_CONTEXTUAL    = ZR_FLAG(17),
+    ZR_WINDOW_CONTEXTUAL    = ZR_FLAG(18),
     /* Marks the window as a combo box or menu */
-    ZR_WINDOW_COMBO         = ZR_FLAG(18),
+    ZR_WINDOW_COMBO         = ZR_FLAG(19),
     /* Marks the window as a combo box */
-    ZR_WINDOW_MENU          = ZR_FLAG(19),
+    ZR_WINDOW_MENU          = ZR_FLAG(20),
     /* Marks the window as a menu */
-    ZR_WINDOW_TOOLTIP       = ZR_FLAG(20),
+    ZR_WINDOW_TOOLTIP       = ZR_FLAG(21),
     /* Marks the window as a menu */
-    ZR_WINDOW_REMOVE_ROM    = ZR_FLAG(21)
+    ZR_WINDOW_REMOVE_ROM    = ZR_FLAG(22),
     /* Removes the read only mode at the end of the window */
+    ZR_WINDOW_RETAINED      = ZR_FLAG(23),
+    /* Marks the commands of a cached window from the last frame as still
+     * being inside the command buffer */
+    ZR_WINDOW_DIRTY         = ZR_FLAG(24)
+    /* Forces a cached window to rebuild its commands in the next frame */
 };
 
 struct zr_popup {
@@ -140,6 +151,38 @@ struct zr_table {
     struct zr_table *next, *prev;
 };
 
+struct zr_value_slot {
+    zr_hash key;
+    unsigned int index;
+    /* position of the value inside its table */
+    struct zr_table *table;
+    /* table page holding the value or NULL for an empty slot */
+};
+
+struct zr_damage_region {
+    zr_hash hash;
+    /* hash over all commands inside the clip region */
+    struct zr_rect bounds;
+    /* screen area covered by all commands inside the clip region */
+};
+
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+struct zr_canvas_chunk {
+    struct zr_buffer cmds;
+    /* private draw commands and temporary path of one window */
+    struct zr_buffer vertexes;
+    /* private vertexes of one window */
+    struct zr_buffer elements;
+    /* private element indexes starting at vertex zero */
+    unsigned int vertex_count;
+    unsigned int element_count;
+    unsigned int cmd_count;
+    zr_size cmd_offset;
+    int overflow;
+    /* canvas state after the window has been converted */
+};
+#endif
+
 struct zr_window {
     zr_hash name;
     /* name of this window */
@@ -153,6 +196,18 @@ struct zr_window {
     /* scrollbar x- and y-offset */
     struct zr_command_buffer buffer;
     /* command buffer for queuing drawing calls */
+    zr_hash cache;
+    /* input hash of the frame the retained window commands were build in */
+    struct zr_damage_region damage[ZR_MAX_DAMAGE_REGIONS];
+    /* clip regions of the last damage query */
+    unsigned short damage_count;
+    /* number of clip regions of the last damage query */
+    unsigned short damage_order;
+    /* window stack position of the last damage query */
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+    struct zr_canvas_chunk chunk;
+    /* vertex output of the last parallel conversion */
+#endif
 
     /* frame window state */
     struct zr_layout *layout;
@@ -165,6 +220,12 @@ struct zr_window {
     struct zr_table *tables;
     unsigned short table_count;
     unsigned short table_size;
+    struct zr_value_slot *values;
+    /* open addressing index over all table values or NULL */
+    unsigned int value_size;
+    /* number of slots inside the value index */
+    unsigned int value_count;
+    /* number of values inside the value index */
 
     /* window list */
     struct zr_window *next;
@@ -1282,6 +1343,82 @@ zr_utf_at(const char *buffer, zr_size length, int index,
  *
  * ===============================================================
  */
+static float
+zr_user_font_glyph_width(const struct zr_user_font *font, const char *text,
+    zr_size prefix_len, zr_rune unicode, float prefix_width)
+{
+    /* returns the width of a string prefix including its last glyph either by
+     * adding the glyph advance to the previous width or by measuring the
+     * whole prefix if the font does not provide glyph advances */
+    if (font->advance)
+        return prefix_width + font->advance(font->userdata, font->height, unicode);
+    return (float)font->width(font->userdata, font->height, text, prefix_len);
+}
+
+struct zr_text_width {
+    zr_handle font;
+    zr_text_width_f width;
+    float height;
+    zr_hash hash;
+    unsigned int seq;
+    /* frame the string was last measured in */
+    zr_size len;
+    zr_size size;
+    /* cached result of the font width callback */
+    char text[ZR_TEXT_WIDTH_SIZE];
+};
+
+static zr_size
+zr_user_font_text_width(struct zr_text_width_cache *cache,
+    const struct zr_user_font *font, const char *text, zr_size len)
+{
+    /* Returns the width of a string and remembers it inside the context string
+     * width cache. Strings are keyed by font handle, width callback, height and
+     * content and placed into the first free or least recently measured slot of
+     * a short probe sequence. Strings measured in the current frame are never
+     * evicted and strings too long to be stored are always measured. */
+    zr_size i, n;
+    zr_hash hash;
+    struct zr_text_width *w;
+    struct zr_text_width *victim = 0;
+
+    if (!cache || !cache->slots || !len || len > ZR_TEXT_WIDTH_SIZE)
+        return font->width(font->userdata, font->height, text, len);
+
+    hash = zr_murmur_hash(text, (int)len, (zr_hash)len);
+    for (i = 0; i < ZR_TEXT_CACHE_PROBE; ++i) {
+        w = &cache->slots[(hash + i) & (ZR_TEXT_WIDTH_CACHE_SIZE-1)];
+        if (!w->width) {
+            victim = w;
+            break;
+        }
+        if (w->hash == hash && w->len == len && w->width == font->width &&
+            w->font.ptr == font->userdata.ptr && w->height == font->height) {
+            for (n = 0; n < len && w->text[n] == text[n]; ++n);
+            if (n == len) {
+                w->seq = cache->seq;
+                cache->hits++;
+                return w->size;
+            }
+        }
+        if (w->seq != cache->seq && (!victim ||
+            (cache->seq - w->seq) > (cache->seq - victim->seq)))
+            victim = w;
+    }
+
+    cache->misses++;
+    if (!victim) return font->width(font->userdata, font->height, text, len);
+    victim->font = font->userdata;
+    victim->width = font->width;
+    victim->height = font->height;
+    victim->hash = hash;
+    victim->seq = cache->seq;
+    victim->len = len;
+    victim->size = font->width(font->userdata, font->height, text, len);
+    zr_memcopy(victim->text, text, len);
+    return victim->size;
+}
+
 static zr_size
 zr_user_font_glyph_index_at_pos(const struct zr_user_font *font, const char *text,
     zr_size text_len, float xoff)
@@ -1289,8 +1426,10 @@ zr_user_font_glyph_index_at_pos(const struct zr_user_font *font, const char *tex
     zr_rune unicode;
     zr_size glyph_offset = 0;
     zr_size glyph_len = zr_utf_decode(text, &unicode, text_len);
-    zr_size text_width = font->width(font->userdata, font->height, text, glyph_len);
     zr_size src_len = glyph_len;
+    float text_width = 0;
+    if (!glyph_len) return glyph_offset;
+    text_width = zr_user_font_glyph_width(font, text, src_len, unicode, 0);
 
     while (text_len && glyph_len) {
         if (text_width >= xoff)
@@ -1299,8 +1438,9 @@ zr_user_font_glyph_index_at_pos(const struct zr_user_font *font, const char *tex
         glyph_offset++;
         text_len -= glyph_len;
         glyph_len = zr_utf_decode(text + src_len, &unicode, text_len);
+        if (!glyph_len) break;
         src_len += glyph_len;
-        text_width = font->width(font->userdata, font->height, text, src_len);
+        text_width = zr_user_font_glyph_width(font, text, src_len, unicode, text_width);
     }
     return glyph_offset;
 }
@@ -1318,12 +1458,9 @@ zr_use_font_glyph_clamp(const struct zr_user_font *font, const char *text,
 
     glyph_len = zr_utf_decode(text, &unicode, text_len);
     while (glyph_len && (width < space) && (len < text_len)) {
-        zr_size s;
         len += glyph_len;
-        s = font->width(font->userdata, font->height, text, len);
-
         last_width = width;
-        width = (float)s;
+        width = zr_user_font_glyph_width(font, text, len, unicode, width);
         glyph_len = zr_utf_decode(&text[len], &unicode, text_len - len);
         g++;
     }
@@ -1346,11 +1483,9 @@ zr_user_font_glyphs_fitting_in_space(const struct zr_user_font *font,
     zr_size offset = 0;
     zr_size g = 0;
     zr_size l = 0;
-    zr_size s;
 
     glyph_len = zr_utf_decode(text, &unicode, text_len);
-    s = font->width(font->userdata, font->height, text, glyph_len);
-    width = last_width = (float)s;
+    width = last_width = zr_user_font_glyph_width(font, text, glyph_len, unicode, 0);
 
     while ((width <= space) && text_len && glyph_len) {
         text_len -= glyph_len;
@@ -1372,8 +1507,7 @@ zr_user_font_glyphs_fitting_in_space(const struct zr_user_font *font,
 
         last_width = width;
         glyph_len = zr_utf_decode(&text[offset], &unicode, text_len);
-        s = font->width(font->userdata, font->height, &text[offset], glyph_len);
-        width += (float)s;
+        width += zr_user_font_glyph_width(font, &text[offset], glyph_len, unicode, 0);
     }
 
     *glyphs = g;
@@ -1447,8 +1581,12 @@ zr_buffer_align(void *unaligned, zr_size align, zr_size *alignment,
 static void*
 zr_buffer_realloc(struct zr_buffer *b, zr_size capacity, zr_size *size)
 {
+    /* only the allocated front and back regions are copied, each directly
+     * to its final place, instead of copying the whole block including the
+     * unused gap and afterwards moving the back buffer a second time */
     void *temp;
     zr_size buffer_size;
+    zr_size back_size;
 
     ZR_ASSERT(b);
     ZR_ASSERT(size);
@@ -1459,27 +1597,42 @@ zr_buffer_realloc(struct zr_buffer *b, zr_size capacity, zr_size *size)
     temp = b->pool.alloc(b->pool.userdata, capacity);
     ZR_ASSERT(temp);
     if (!temp) return 0;
-    zr_memcopy(temp, b->memory.ptr, buffer_size);
-    b->pool.free(b->pool.userdata, b->memory.ptr);
+    if (b->allocated)
+        zr_memcopy(temp, b->memory.ptr, b->allocated);
     *size = capacity;
 
-    if (b->size == buffer_size) {
-        /* no back buffer so just set correct size */
-        b->size = capacity;
-        return temp;
-    } else {
+    back_size = buffer_size - b->size;
+    if (back_size) {
         /* copy back buffer to the end of the new buffer */
-        void *dst, *src;
-        zr_size back_size;
-        back_size = buffer_size - b->size;
-        dst = zr_ptr_add(void, temp, capacity - back_size);
-        src = zr_ptr_add(void, temp, b->size);
+        void *dst = zr_ptr_add(void, temp, capacity - back_size);
+        void *src = zr_ptr_add(void, b->memory.ptr, b->size);
         zr_memcopy(dst, src, back_size);
-        b->size = capacity - back_size;
+        if (b->marker[ZR_BUFFER_BACK].active)
+            b->marker[ZR_BUFFER_BACK].offset += capacity - buffer_size;
     }
+    b->pool.free(b->pool.userdata, b->memory.ptr);
+    b->size = capacity - back_size;
     return temp;
 }
 
+void
+zr_buffer_reserve(struct zr_buffer *b, zr_size size)
+{
+    /* grows a dynamic buffer ahead of time, best called while it is almost
+     * empty since only the allocated parts have to be copied */
+    zr_size cap;
+    void *memory;
+    ZR_ASSERT(b);
+    if (!b || b->type != ZR_BUFFER_DYNAMIC || !b->pool.alloc || !b->pool.free)
+        return;
+    if (size <= b->memory.size) return;
+
+    cap = (zr_size)((float)b->memory.size * b->grow_factor);
+    cap = MAX(cap, zr_round_up_pow2((zr_uint)size));
+    memory = zr_buffer_realloc(b, cap, &b->memory.size);
+    if (memory) b->memory.ptr = memory;
+}
+
 static void*
 zr_buffer_alloc(struct zr_buffer *b, enum zr_buffer_allocation_type type,
     zr_size size, zr_size align)
@@ -1633,6 +1786,7 @@ zr_command_buffer_init(struct zr_command_buffer *cmdbuf,
     if (!cmdbuf || !buffer) return;
     cmdbuf->base = buffer;
     cmdbuf->use_clipping = clip;
+    cmdbuf->widths = 0;
     cmdbuf->begin = buffer->allocated;
     cmdbuf->end = buffer->allocated;
     cmdbuf->last = buffer->allocated;
@@ -1869,7 +2023,7 @@ zr_draw_text(struct zr_command_buffer *b, struct zr_rect r,
     }
 
     /* make sure text fits inside bounds */
-    text_width = font->width(font->userdata, font->height, string, length);
+    text_width = zr_user_font_text_width(b->widths, font, string, length);
     if (text_width > r.w){
         float txt_width = (float)text_width;
         zr_size glyphs = 0;
@@ -1887,7 +2041,7 @@ zr_draw_text(struct zr_command_buffer *b, struct zr_rect r,
     cmd->h = (unsigned short)r.h;
     cmd->background = bg;
     cmd->foreground = fg;
-    cmd->font = font;
+    cmd->font = *font;
     cmd->length = length;
     cmd->height = font->height;
     zr_memcopy(cmd->string, string, length);
@@ -1916,9 +2070,27 @@ static void
 zr_canvas_setup(struct zr_canvas *list, struct zr_buffer *cmds,
     struct zr_buffer *vertexes, struct zr_buffer *elements,
     struct zr_draw_null_texture null,
-    enum zr_anti_aliasing line_AA, enum zr_anti_aliasing shape_AA)
+    enum zr_anti_aliasing line_AA, enum zr_anti_aliasing shape_AA,
+    const struct zr_draw_vertex_layout_element *layout,
+    zr_size vertex_size, zr_size vertex_alignment)
 {
+    ZR_ASSERT(!layout || vertex_size);
     list->null = null;
+    if (layout && vertex_size) {
+        /* vertexes are allocated one after another, so a size that is not a
+         * multiple of the alignment would add padding between them */
+        vertex_alignment = MAX(vertex_alignment, 1);
+        ZR_ASSERT(!(vertex_size % vertex_alignment) &&
+            "vertex size has to be a multiple of the vertex alignment");
+        vertex_size = ((vertex_size + vertex_alignment - 1) / vertex_alignment) * vertex_alignment;
+        list->vertex_layout = layout;
+        list->vertex_size = vertex_size;
+        list->vertex_alignment = vertex_alignment;
+    } else {
+        list->vertex_layout = 0;
+        list->vertex_size = sizeof(struct zr_draw_vertex);
+        list->vertex_alignment = ZR_ALIGNOF(struct zr_draw_vertex);
+    }
     list->clip_rect = zr_null_rect;
     list->vertexes = vertexes;
     list->elements = elements;
@@ -1941,6 +2113,7 @@ zr_canvas_clear(struct zr_canvas *list)
 
     list->element_count = 0;
     list->vertex_count = 0;
+    list->overflow = 0;
     list->cmd_offset = 0;
     list->cmd_count = 0;
     list->path_count = 0;
@@ -2050,17 +2223,25 @@ zr_canvas_push_image(struct zr_canvas *list, zr_handle texture)
     }
 }
 
-static struct zr_draw_vertex*
+static void*
 zr_canvas_alloc_vertexes(struct zr_canvas *list, zr_size count)
 {
-    struct zr_draw_vertex *vtx;
-    static const zr_size vtx_align = ZR_ALIGNOF(struct zr_draw_vertex);
-    static const zr_size vtx_size = sizeof(struct zr_draw_vertex);
+    void *vtx;
     ZR_ASSERT(list);
     if (!list) return 0;
+    if (list->overflow) return 0;
+#if !ZR_COMPILE_WITH_32BIT_DRAW_INDEX
+    /* vertexes past the 16-bit index range cannot be referenced, so this
+     * and all following shapes are dropped. Set
+     * ZR_COMPILE_WITH_32BIT_DRAW_INDEX to 1 if `overflow` gets set */
+    if (list->vertex_count + count > ZR_MAX_DRAW_VERTEXES) {
+        list->overflow = zr_true;
+        return 0;
+    }
+#endif
 
-    vtx = (struct zr_draw_vertex*)
-        zr_buffer_alloc(list->vertexes, ZR_BUFFER_FRONT, vtx_size*count, vtx_align);
+    vtx = zr_buffer_alloc(list->vertexes, ZR_BUFFER_FRONT,
+        list->vertex_size * count, list->vertex_alignment);
     if (!vtx) return 0;
     list->vertex_count += (unsigned int)count;
     return vtx;
@@ -2074,7 +2255,7 @@ zr_canvas_alloc_elements(struct zr_canvas *list, zr_size count)
     static const zr_size elem_align = ZR_ALIGNOF(zr_draw_index);
     static const zr_size elem_size = sizeof(zr_draw_index);
     ZR_ASSERT(list);
-    if (!list) return 0;
+    if (!list || list->overflow) return 0;
 
     ids = (zr_draw_index*)
         zr_buffer_alloc(list->elements, ZR_BUFFER_FRONT, elem_size*count, elem_align);
@@ -2085,14 +2266,173 @@ zr_canvas_alloc_elements(struct zr_canvas *list, zr_size count)
     return ids;
 }
 
-static struct zr_draw_vertex
-zr_draw_vertex(struct zr_vec2 pos, struct zr_vec2 uv, zr_draw_vertex_color col)
+static unsigned short
+zr_float_to_half(float in)
 {
-    struct zr_draw_vertex out;
-    out.position = pos;
-    out.uv = uv;
-    out.col = col;
-    return out;
+    /* truncating conversion with round-to-nearest on the last mantissa bit.
+     * Denormals are flushed to zero and NaNs become infinity */
+    union {float f; zr_uint u;} conv;
+    zr_uint sign, mantissa, half;
+    int exponent;
+
+    conv.f = in;
+    sign = (conv.u >> 16) & 0x8000;
+    exponent = (int)((conv.u >> 23) & 0xff) - 127 + 15;
+    mantissa = conv.u & 0x007fffff;
+    if (exponent <= 0) return (unsigned short)sign;
+    if (exponent >= 31) return (unsigned short)(sign | 0x7c00);
+    half = sign | ((zr_uint)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++;
+    return (unsigned short)half;
+}
+
+static void
+zr_draw_vertex_write_element(void *dst, const float *values, int count,
+    enum zr_draw_vertex_layout_format format)
+{
+    int i;
+    ZR_ASSERT(format < ZR_FORMAT_R8G8B8A8 && "invalid position/texcoord format");
+    for (i = 0; i < count; ++i) {
+        float value = values[i];
+        switch (format) {
+        case ZR_FORMAT_SCHAR: {
+            value = CLAMP(-128.0f, value, 127.0f);
+            ((signed char*)dst)[i] = (signed char)value;
+        } break;
+        case ZR_FORMAT_SSHORT: {
+            value = CLAMP(-32768.0f, value, 32767.0f);
+            ((short*)dst)[i] = (short)value;
+        } break;
+        case ZR_FORMAT_SINT: {
+            /* largest floats still representable after the conversion */
+            value = CLAMP(-2147483648.0f, value, 2147483520.0f);
+            ((int*)dst)[i] = (int)value;
+        } break;
+        case ZR_FORMAT_UCHAR: {
+            value = CLAMP(0.0f, value, 255.0f);
+            ((unsigned char*)dst)[i] = (unsigned char)value;
+        } break;
+        case ZR_FORMAT_USHORT: {
+            value = CLAMP(0.0f, value, 65535.0f);
+            ((unsigned short*)dst)[i] = (unsigned short)value;
+        } break;
+        case ZR_FORMAT_UINT: {
+            value = CLAMP(0.0f, value, 4294967040.0f);
+            ((zr_uint*)dst)[i] = (zr_uint)value;
+        } break;
+        case ZR_FORMAT_FLOAT: ((float*)dst)[i] = value; break;
+        case ZR_FORMAT_HALF: ((unsigned short*)dst)[i] = zr_float_to_half(value); break;
+        case ZR_FORMAT_DOUBLE: ((double*)dst)[i] = (double)value; break;
+        default: return;
+        }
+    }
+}
+
+static void
+zr_draw_vertex_write_color(void *dst, zr_draw_vertex_color col,
+    enum zr_draw_vertex_layout_format format)
+{
+    zr_byte *out = (zr_byte*)dst;
+    ZR_ASSERT(format >= ZR_FORMAT_R8G8B8A8 && "invalid color format");
+    switch (format) {
+    case ZR_FORMAT_R8G8B8A8: {
+        out[0] = (zr_byte)(col & 0xFF);
+        out[1] = (zr_byte)((col >> 8) & 0xFF);
+        out[2] = (zr_byte)((col >> 16) & 0xFF);
+        out[3] = (zr_byte)((col >> 24) & 0xFF);
+    } break;
+    case ZR_FORMAT_B8G8R8A8: {
+        out[0] = (zr_byte)((col >> 16) & 0xFF);
+        out[1] = (zr_byte)((col >> 8) & 0xFF);
+        out[2] = (zr_byte)(col & 0xFF);
+        out[3] = (zr_byte)((col >> 24) & 0xFF);
+    } break;
+    case ZR_FORMAT_R32G32B32A32_FLOAT: {
+        float *f = (float*)dst;
+        f[0] = (float)(col & 0xFF) / 255.0f;
+        f[1] = (float)((col >> 8) & 0xFF) / 255.0f;
+        f[2] = (float)((col >> 16) & 0xFF) / 255.0f;
+        f[3] = (float)((col >> 24) & 0xFF) / 255.0f;
+    } break;
+    default: break;
+    }
+}
+
+static void*
+zr_draw_vertex(void *dst, const struct zr_canvas *list,
+    struct zr_vec2 pos, struct zr_vec2 uv, zr_draw_vertex_color col)
+{
+    /* writes one vertex in the configured output format and returns
+     * a pointer to the following vertex */
+    const struct zr_draw_vertex_layout_element *elem;
+    if (!list->vertex_layout) {
+        struct zr_draw_vertex *vtx = (struct zr_draw_vertex*)dst;
+        vtx->position = pos;
+        vtx->uv = uv;
+        vtx->col = col;
+        return vtx + 1;
+    }
+
+    for (elem = list->vertex_layout; elem->attribute != ZR_VERTEX_ATTRIBUTE_COUNT; ++elem) {
+        void *address = (zr_byte*)dst + elem->offset;
+        switch (elem->attribute) {
+        case ZR_VERTEX_POSITION: zr_draw_vertex_write_element(address, &pos.x, 2, elem->format); break;
+        case ZR_VERTEX_TEXCOORD: zr_draw_vertex_write_element(address, &uv.x, 2, elem->format); break;
+        case ZR_VERTEX_COLOR: zr_draw_vertex_write_color(address, col, elem->format); break;
+        default: break;
+        }
+    }
+    return (zr_byte*)dst + list->vertex_size;
+}
+
+static struct zr_vec2
+zr_canvas_miter(struct zr_vec2 n0, struct zr_vec2 n1)
+{
+    /* average normals and scale to keep the thickness at sharp corners */
+    struct zr_vec2 dm = zr_vec2_muls(zr_vec2_add(n0, n1), 0.5f);
+    float dmr2 = dm.x * dm.x + dm.y * dm.y;
+    if (dmr2 > 0.000001f) {
+        float scale = 1.0f / dmr2;
+        scale = MIN(100.0f, scale);
+        dm = zr_vec2_muls(dm, scale);
+    }
+    return dm;
+}
+
+static void
+zr_canvas_normals(struct zr_vec2 *normals, const struct zr_vec2 *points,
+    zr_size count, zr_size points_count)
+{
+    /* calculates the normal of each segment from `points[i]` to `points[i+1]`
+     * with the last segment wrapping around to the first point */
+    zr_size i;
+    for (i = 0; i < count; ++i) {
+        const zr_size i2 = ((i + 1) == points_count) ? 0 : (i + 1);
+        struct zr_vec2 diff = zr_vec2_sub(points[i2], points[i]);
+        float len;
+
+        /* vec2 inverted lenth  */
+        len = zr_vec2_len_sqr(diff);
+        if (len != 0.0f)
+            len = zr_inv_sqrt(len);
+        else len = 1.0f;
+
+        diff = zr_vec2_muls(diff, len);
+        normals[i].x = diff.y;
+        normals[i].y = -diff.x;
+    }
+}
+
+static void
+zr_canvas_miters(struct zr_vec2 *miters, const struct zr_vec2 *normals,
+    zr_size points_count)
+{
+    /* calculates the miter of each point between the normal of the
+     * previous segment `normals[i-1]` and the next segment `normals[i]` */
+    zr_size i;
+    miters[0] = zr_canvas_miter(normals[points_count-1], normals[0]);
+    for (i = 1; i < points_count; ++i)
+        miters[i] = zr_canvas_miter(normals[i-1], normals[i]);
 }
 
 static void
@@ -2123,40 +2463,31 @@ zr_canvas_add_poly_line(struct zr_canvas *list, struct zr_vec2 *points,
         zr_size index = list->vertex_count;
         const zr_size idx_count = (thick_line) ?  (count * 18) : (count * 12);
         const zr_size vtx_count = (thick_line) ? (points_count * 4): (points_count *3);
-        struct zr_draw_vertex *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
+        void *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
         zr_draw_index *ids = zr_canvas_alloc_elements(list, idx_count);
 
         zr_size size;
-        struct zr_vec2 *normals, *temp;
+        struct zr_vec2 *normals, *miters, *temp;
+        zr_size vtx_offset;
         if (!vtx || !ids) return;
 
-        /* temporary allocate normals + points */
+        /* temporary allocate normals + miters + points. A growing buffer
+         * moves the vertexes, so they are looked up again afterwards */
+        vtx_offset = (zr_size)((zr_byte*)vtx - (zr_byte*)zr_buffer_memory(list->vertexes));
         zr_buffer_mark(list->vertexes, ZR_BUFFER_FRONT);
-        size = pnt_size * ((thick_line) ? 5 : 3) * points_count;
+        size = pnt_size * ((thick_line) ? 6 : 4) * points_count;
         normals = (struct zr_vec2*)
             zr_buffer_alloc(list->vertexes, ZR_BUFFER_FRONT, size, pnt_align);
         if (!normals) return;
-        temp = normals + points_count;
-
-        /* calculate normals */
-        for (i1 = 0; i1 < count; ++i1) {
-            const zr_size i2 = ((i1 + 1) == points_count) ? 0 : (i1 + 1);
-            struct zr_vec2 diff = zr_vec2_sub(points[i2], points[i1]);
-            float len;
-
-            /* vec2 inverted lenth  */
-            len = zr_vec2_len_sqr(diff);
-            if (len != 0.0f)
-                len = zr_inv_sqrt(len);
-            else len = 1.0f;
-
-            diff = zr_vec2_muls(diff, len);
-            normals[i1].x = diff.y;
-            normals[i1].y = -diff.x;
-        }
+        vtx = (zr_byte*)zr_buffer_memory(list->vertexes) + vtx_offset;
+        miters = normals + points_count;
+        temp = miters + points_count;
 
+        /* calculate normals and miters */
+        zr_canvas_normals(normals, points, count, points_count);
         if (!closed)
             normals[points_count-1] = normals[points_count-2];
+        zr_canvas_miters(miters, normals, points_count);
 
         if (!thick_line) {
             zr_size idx1, i;
@@ -2172,21 +2503,9 @@ zr_canvas_add_poly_line(struct zr_canvas *list, struct zr_vec2 *points,
             /* fill elements */
             idx1 = index;
             for (i1 = 0; i1 < count; i1++) {
-                struct zr_vec2 dm;
-                float dmr2;
                 zr_size i2 = ((i1 + 1) == points_count) ? 0 : (i1 + 1);
                 zr_size idx2 = ((i1+1) == points_count) ? index: (idx1 + 3);
-
-                /* average normals */
-                dm = zr_vec2_muls(zr_vec2_add(normals[i1], normals[i2]), 0.5f);
-                dmr2 = dm.x * dm.x + dm.y* dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f/dmr2;
-                    scale = MIN(100.0f, scale);
-                    dm = zr_vec2_muls(dm, scale);
-                }
-
-                dm = zr_vec2_muls(dm, AA_SIZE);
+                const struct zr_vec2 dm = zr_vec2_muls(miters[i2], AA_SIZE);
                 temp[i2*2+0] = zr_vec2_add(points[i2], dm);
                 temp[i2*2+1] = zr_vec2_sub(points[i2], dm);
 
@@ -2203,10 +2522,9 @@ zr_canvas_add_poly_line(struct zr_canvas *list, struct zr_vec2 *points,
             /* fill vertexes */
             for (i = 0; i < points_count; ++i) {
                 const struct zr_vec2 uv = list->null.uv;
-                vtx[0] = zr_draw_vertex(points[i], uv, col);
-                vtx[1] = zr_draw_vertex(temp[i*2+0], uv, col_trans);
-                vtx[2] = zr_draw_vertex(temp[i*2+1], uv, col_trans);
-                vtx += 3;
+                vtx = zr_draw_vertex(vtx, list, points[i], uv, col);
+                vtx = zr_draw_vertex(vtx, list, temp[i*2+0], uv, col_trans);
+                vtx = zr_draw_vertex(vtx, list, temp[i*2+1], uv, col_trans);
             }
         } else {
             zr_size idx1, i;
@@ -2235,15 +2553,7 @@ zr_canvas_add_poly_line(struct zr_canvas *list, struct zr_vec2 *points,
                 struct zr_vec2 dm_out, dm_in;
                 const zr_size i2 = ((i1+1) == points_count) ? 0: (i1 + 1);
                 zr_size idx2 = ((i1+1) == points_count) ? index: (idx1 + 4);
-
-                /* average normals */
-                struct zr_vec2 dm = zr_vec2_muls(zr_vec2_add(normals[i1], normals[i2]), 0.5f);
-                float dmr2 = dm.x * dm.x + dm.y* dm.y;
-                if (dmr2 > 0.000001f) {
-                    float scale = 1.0f/dmr2;
-                    scale = MIN(100.0f, scale);
-                    dm = zr_vec2_muls(dm, scale);
-                }
+                const struct zr_vec2 dm = miters[i2];
 
                 dm_out = zr_vec2_muls(dm, ((half_inner_thickness) + AA_SIZE));
                 dm_in = zr_vec2_muls(dm, half_inner_thickness);
@@ -2269,11 +2579,10 @@ zr_canvas_add_poly_line(struct zr_canvas *list, struct zr_vec2 *points,
             /* add vertexes */
             for (i = 0; i < points_count; ++i) {
                 const struct zr_vec2 uv = list->null.uv;
-                vtx[0] = zr_draw_vertex(temp[i*4+0], uv, col_trans);
-                vtx[1] = zr_draw_vertex(temp[i*4+1], uv, col);
-                vtx[2] = zr_draw_vertex(temp[i*4+2], uv, col);
-                vtx[3] = zr_draw_vertex(temp[i*4+3], uv, col_trans);
-                vtx += 4;
+                vtx = zr_draw_vertex(vtx, list, temp[i*4+0], uv, col_trans);
+                vtx = zr_draw_vertex(vtx, list, temp[i*4+1], uv, col);
+                vtx = zr_draw_vertex(vtx, list, temp[i*4+2], uv, col);
+                vtx = zr_draw_vertex(vtx, list, temp[i*4+3], uv, col_trans);
             }
         }
 
@@ -2285,7 +2594,7 @@ zr_canvas_add_poly_line(struct zr_canvas *list, struct zr_vec2 *points,
         zr_size idx = list->vertex_count;
         const zr_size idx_count = count * 6;
         const zr_size vtx_count = count * 4;
-        struct zr_draw_vertex *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
+        void *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
         zr_draw_index *ids = zr_canvas_alloc_elements(list, idx_count);
         if (!vtx || !ids) return;
 
@@ -2309,11 +2618,10 @@ zr_canvas_add_poly_line(struct zr_canvas *list, struct zr_vec2 *points,
             dx = diff.x * (thickness * 0.5f);
             dy = diff.y * (thickness * 0.5f);
 
-            vtx[0] = zr_draw_vertex(zr_vec2(p1.x + dy, p1.y - dx), uv, col);
-            vtx[1] = zr_draw_vertex(zr_vec2(p2.x + dy, p2.y - dx), uv, col);
-            vtx[2] = zr_draw_vertex(zr_vec2(p2.x - dy, p2.y + dx), uv, col);
-            vtx[3] = zr_draw_vertex(zr_vec2(p1.x - dy, p1.y + dx), uv, col);
-            vtx += 4;
+            vtx = zr_draw_vertex(vtx, list, zr_vec2(p1.x + dy, p1.y - dx), uv, col);
+            vtx = zr_draw_vertex(vtx, list, zr_vec2(p2.x + dy, p2.y - dx), uv, col);
+            vtx = zr_draw_vertex(vtx, list, zr_vec2(p2.x - dy, p2.y + dx), uv, col);
+            vtx = zr_draw_vertex(vtx, list, zr_vec2(p1.x - dy, p1.y + dx), uv, col);
 
             ids[0] = (zr_draw_index)(idx+0); ids[1] = (zr_draw_index)(idx+1);
             ids[2] = (zr_draw_index)(idx+2); ids[3] = (zr_draw_index)(idx+0);
@@ -2344,21 +2652,26 @@ zr_canvas_add_poly_convex(struct zr_canvas *list, struct zr_vec2 *points,
         zr_size index = list->vertex_count;
         const zr_size idx_count = (points_count-2)*3 + points_count*6;
         const zr_size vtx_count = (points_count*2);
-        struct zr_draw_vertex *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
+        void *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
         zr_draw_index *ids = zr_canvas_alloc_elements(list, idx_count);
 
         unsigned int vtx_inner_idx = (unsigned int)(index + 0);
         unsigned int vtx_outer_idx = (unsigned int)(index + 1);
-        struct zr_vec2 *normals = 0;
+        struct zr_vec2 *normals = 0, *miters = 0;
         zr_size size = 0;
+        zr_size vtx_offset;
         if (!vtx || !ids) return;
 
-        /* temporary allocate normals */
+        /* temporary allocate normals + miters and look up the vertexes
+         * again in case the buffer had to grow */
+        vtx_offset = (zr_size)((zr_byte*)vtx - (zr_byte*)zr_buffer_memory(list->vertexes));
         zr_buffer_mark(list->vertexes, ZR_BUFFER_FRONT);
-        size = pnt_size * points_count;
+        size = pnt_size * points_count * 2;
         normals = (struct zr_vec2*)
             zr_buffer_alloc(list->vertexes, ZR_BUFFER_FRONT, size, pnt_align);
         if (!normals) return;
+        vtx = (zr_byte*)zr_buffer_memory(list->vertexes) + vtx_offset;
+        miters = normals + points_count;
 
         /* add elements */
         for (i = 2; i < points_count; i++) {
@@ -2368,42 +2681,18 @@ zr_canvas_add_poly_convex(struct zr_canvas *list, struct zr_vec2 *points,
             ids += 3;
         }
 
-        /* compute normals */
-        for (i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++) {
-            struct zr_vec2 p0 = points[i0];
-            struct zr_vec2 p1 = points[i1];
-            struct zr_vec2 diff = zr_vec2_sub(p1, p0);
-
-            /* vec2 inverted lenth  */
-            float len = zr_vec2_len_sqr(diff);
-            if (len != 0.0f)
-                len = zr_inv_sqrt(len);
-            else len = 1.0f;
-            diff = zr_vec2_muls(diff, len);
-
-            normals[i0].x = diff.y;
-            normals[i0].y = -diff.x;
-        }
+        /* compute normals and miters */
+        zr_canvas_normals(normals, points, points_count, points_count);
+        zr_canvas_miters(miters, normals, points_count);
 
         /* add vertexes + indexes */
         for (i0 = points_count-1, i1 = 0; i1 < points_count; i0 = i1++) {
             const struct zr_vec2 uv = list->null.uv;
-            struct zr_vec2 n0 = normals[i0];
-            struct zr_vec2 n1 = normals[i1];
-            struct zr_vec2 dm = zr_vec2_muls(zr_vec2_add(n0, n1), 0.5f);
-
-            float dmr2 = dm.x*dm.x + dm.y*dm.y;
-            if (dmr2 > 0.000001f) {
-                float scale = 1.0f / dmr2;
-                scale = MIN(scale, 100.0f);
-                dm = zr_vec2_muls(dm, scale);
-            }
-            dm = zr_vec2_muls(dm, AA_SIZE * 0.5f);
+            const struct zr_vec2 dm = zr_vec2_muls(miters[i1], AA_SIZE * 0.5f);
 
             /* add vertexes */
-            vtx[0] = zr_draw_vertex(zr_vec2_sub(points[i1], dm), uv, col);
-            vtx[1] = zr_draw_vertex(zr_vec2_add(points[i1], dm), uv, col_trans);
-            vtx += 2;
+            vtx = zr_draw_vertex(vtx, list, zr_vec2_sub(points[i1], dm), uv, col);
+            vtx = zr_draw_vertex(vtx, list, zr_vec2_add(points[i1], dm), uv, col_trans);
 
             /* add indexes */
             ids[0] = (zr_draw_index)(vtx_inner_idx+(i1<<1));
@@ -2421,12 +2710,11 @@ zr_canvas_add_poly_convex(struct zr_canvas *list, struct zr_vec2 *points,
         zr_size index = list->vertex_count;
         const zr_size idx_count = (points_count-2)*3;
         const zr_size vtx_count = points_count;
-        struct zr_draw_vertex *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
+        void *vtx = zr_canvas_alloc_vertexes(list, vtx_count);
         zr_draw_index *ids = zr_canvas_alloc_elements(list, idx_count);
         if (!vtx || !ids) return;
         for (i = 0; i < vtx_count; ++i) {
-            vtx[0] = zr_draw_vertex(points[i], list->null.uv, col);
-            vtx++;
+            vtx = zr_draw_vertex(vtx, list, points[i], list->null.uv, col);
         }
         for (i = 2; i < points_count; ++i) {
             ids[0] = (zr_draw_index)index;
@@ -2639,7 +2927,7 @@ zr_canvas_push_rect_uv(struct zr_canvas *list, struct zr_vec2 a,
     struct zr_color color)
 {
     zr_draw_vertex_color col = zr_color32(color);
-    struct zr_draw_vertex *vtx;
+    void *vtx;
     struct zr_vec2 uvb, uvd;
     struct zr_vec2 b,d;
     zr_draw_index *idx;
@@ -2661,10 +2949,10 @@ zr_canvas_push_rect_uv(struct zr_canvas *list, struct zr_vec2 a,
     idx[2] = (zr_draw_index)(index+2); idx[3] = (zr_draw_index)(index+0);
     idx[4] = (zr_draw_index)(index+2); idx[5] = (zr_draw_index)(index+3);
 
-    vtx[0] = zr_draw_vertex(a, uva, col);
-    vtx[1] = zr_draw_vertex(b, uvb, col);
-    vtx[2] = zr_draw_vertex(c, uvc, col);
-    vtx[3] = zr_draw_vertex(d, uvd, col);
+    vtx = zr_draw_vertex(vtx, list, a, uva, col);
+    vtx = zr_draw_vertex(vtx, list, b, uvb, col);
+    vtx = zr_draw_vertex(vtx, list, c, uvc, col);
+    vtx = zr_draw_vertex(vtx, list, d, uvd, col);
 }
 
 static void
@@ -2689,6 +2977,179 @@ zr_canvas_add_image(struct zr_canvas *list, struct zr_image texture,
             zr_vec2(0.0f, 0.0f), zr_vec2(1.0f, 1.0f),color);
 }
 
+struct zr_text_glyph {
+    struct zr_vec2 a, b;
+    /* glyph quad relative to the left side of the text center line */
+    struct zr_vec2 uv[2];
+};
+
+struct zr_text_run {
+    zr_handle font;
+    /* user font handle the run was laid out with */
+    zr_query_font_glyph_f query;
+    /* glyph callback the run was laid out with or NULL for a free slot */
+    zr_handle texture;
+    /* font texture the glyph texture coordinates point into */
+    float font_height;
+    /* user font height the run was laid out with */
+    float height;
+    zr_hash hash;
+    unsigned int seq;
+    /* frame the run was last drawn in */
+    unsigned int lap;
+    /* ring buffer lap the glyphs were written in */
+    zr_size offset;
+    /* ring buffer offset of the glyphs followed by the text */
+    zr_size len;
+    zr_size count;
+};
+
+static float
+zr_text_glyph_query(struct zr_text_glyph *out, const struct zr_user_font *font,
+    float scale, float x, zr_rune unicode, zr_rune next)
+{
+    /* calculates the glyph quad and returns the offset to the next glyph */
+    struct zr_user_font_glyph g;
+    font->query(font->userdata, font->height, &g, unicode,
+                (next == ZR_UTF_INVALID) ? '\0' : next);
+    out->a.x = x + g.offset.x * scale;
+    out->a.y = -(font->height/2) + g.offset.y * scale;
+    out->b.x = out->a.x + g.width * scale;
+    out->b.y = out->a.y + g.height * scale;
+    out->uv[0] = g.uv[0];
+    out->uv[1] = g.uv[1];
+    return g.xadvance * scale;
+}
+
+static void
+zr_text_run_cache_init(struct zr_text_run_cache *cache, void *memory, zr_size size)
+{
+    /* a quarter of the memory holds the hash table of runs and the rest
+     * the ring buffer of glyph spans with about eight glyphs per run */
+    zr_size count = 16;
+    zr_zero(cache, sizeof(*cache));
+    cache->size = size;
+    if (!memory || size < 16 * sizeof(struct zr_text_run) * 4) return;
+    while (count * 2 * sizeof(struct zr_text_run) * 4 <= size)
+        count *= 2;
+    zr_zero(memory, count * sizeof(struct zr_text_run));
+    cache->runs = (struct zr_text_run*)memory;
+    cache->run_count = count;
+    cache->pool = (zr_byte*)memory + count * sizeof(struct zr_text_run);
+    cache->pool_size = size - count * sizeof(struct zr_text_run);
+}
+
+static int
+zr_text_run_valid(const struct zr_text_run_cache *cache, const struct zr_text_run *run)
+{
+    /* glyphs of the last lap stay valid until the ring buffer reaches them */
+    return run->lap == cache->lap ||
+        (run->lap + 1 == cache->lap && run->offset >= cache->head);
+}
+
+static const struct zr_text_glyph*
+zr_canvas_text_run(struct zr_canvas *list, const struct zr_user_font *font,
+    const char *text, zr_size len, float font_height, zr_size *count)
+{
+    /* Looks up the glyph layout of a text in the run cache. Runs are placed
+     * into the first free, overwritten or least recently drawn slot of a
+     * short probe sequence and keyed by font handle, glyph callback and
+     * texture since the user font of the context is changed in place. Slots
+     * are only emptied by `zr_text_cache_clear` so lookups stop at the first
+     * free one. Glyphs and text of a run are written one after another into a
+     * ring buffer, so each run only takes the space of its own glyphs. */
+    static const zr_size glyph_align = ZR_ALIGNOF(struct zr_text_glyph);
+    struct zr_text_run_cache *cache = &list->text_cache;
+    struct zr_text_glyph *glyphs;
+    zr_size i, n, size;
+    float x = 0, scale;
+    zr_size text_len, glyph_len, next_glyph_len;
+    zr_rune unicode, next;
+    zr_hash hash;
+    struct zr_text_run *run = 0;
+    struct zr_text_run *victim = 0;
+
+    /* glyph count is at most the text length, so reserve for the worst case */
+    size = len * sizeof(struct zr_text_glyph) + len;
+    if (font->dynamic || size > cache->pool_size / 4) return 0;
+    hash = zr_murmur_hash(text, (int)len, (zr_hash)len);
+    for (i = 0; i < ZR_TEXT_CACHE_PROBE; ++i) {
+        run = &cache->runs[(hash + i) & (cache->run_count-1)];
+        if (!run->query) {
+            victim = run;
+            break;
+        }
+        if (!zr_text_run_valid(cache, run)) {
+            if (!victim || zr_text_run_valid(cache, victim))
+                victim = run;
+            continue;
+        }
+        if (run->hash == hash && run->len == len && run->query == font->query &&
+            run->font.ptr == font->userdata.ptr &&
+            run->texture.ptr == font->texture.ptr &&
+            run->height == font_height && run->font_height == font->height) {
+            const char *str = (const char*)(cache->pool + run->offset +
+                run->count * sizeof(struct zr_text_glyph));
+            for (n = 0; n < len && str[n] == text[n]; ++n);
+            if (n == len) {
+                run->seq = list->seq;
+                cache->hits++;
+                *count = run->count;
+                return (const struct zr_text_glyph*)(cache->pool + run->offset);
+            }
+        }
+        if (run->seq != list->seq && (!victim || (zr_text_run_valid(cache, victim) &&
+            (list->seq - run->seq) > (list->seq - victim->seq))))
+            victim = run;
+    }
+    cache->misses++;
+    if (!victim) return 0;
+
+    /* layout the text at the ring buffer head */
+    if (cache->head + size > cache->pool_size) {
+        cache->head = 0;
+        cache->lap++;
+    }
+    run = victim;
+    run->font = font->userdata;
+    run->query = font->query;
+    run->texture = font->texture;
+    run->font_height = font->height;
+    run->height = font_height;
+    run->hash = hash;
+    run->seq = list->seq;
+    run->lap = cache->lap;
+    run->offset = cache->head;
+    run->len = len;
+    run->count = 0;
+
+    glyphs = (struct zr_text_glyph*)(cache->pool + run->offset);
+    scale = font_height / font->height;
+    glyph_len = text_len = zr_utf_decode(text, &unicode, len);
+    while (text_len <= len && glyph_len) {
+        if (unicode == ZR_UTF_INVALID) break;
+        next_glyph_len = zr_utf_decode(text + text_len, &next, len - text_len);
+        x += zr_text_glyph_query(&glyphs[run->count++], font, scale, x, unicode, next);
+        text_len += glyph_len;
+        glyph_len = next_glyph_len;
+        unicode = next;
+    }
+    size = run->count * sizeof(struct zr_text_glyph);
+    zr_memcopy(cache->pool + run->offset + size, text, len);
+    size = (size + len + glyph_align - 1) & ~(glyph_align - 1);
+    cache->head += size;
+    *count = run->count;
+    return glyphs;
+}
+
+static void
+zr_canvas_push_glyph(struct zr_canvas *list, struct zr_vec2 origin,
+    const struct zr_text_glyph *g, struct zr_color color)
+{
+    zr_canvas_push_rect_uv(list, zr_vec2(origin.x + g->a.x, origin.y + g->a.y),
+        zr_vec2(origin.x + g->b.x, origin.y + g->b.y), g->uv[0], g->uv[1], color);
+}
+
 static void
 zr_canvas_add_text(struct zr_canvas *list, const struct zr_user_font *font,
     struct zr_rect rect, const char *text, zr_size len, float font_height,
@@ -2698,8 +3159,8 @@ zr_canvas_add_text(struct zr_canvas *list, const struct zr_user_font *font,
     zr_size text_len;
     zr_rune unicode, next;
     zr_size glyph_len, next_glyph_len;
-    struct zr_user_font_glyph g;
-    scale = font_height / font->height;
+    struct zr_text_glyph g;
+    struct zr_vec2 origin;
 
     ZR_ASSERT(list);
     if (!list || !len || !text) return;
@@ -2710,37 +3171,98 @@ zr_canvas_add_text(struct zr_canvas *list, const struct zr_user_font *font,
 
     /* draw text background */
     zr_canvas_push_image(list, font->texture);
+    origin = zr_vec2(rect.x, rect.y + (rect.h/2));
+
+    /* draw the cached glyph layout of the text */
+    if (list->text_cache.runs) {
+        zr_size i, count;
+        const struct zr_text_glyph *glyphs;
+        glyphs = zr_canvas_text_run(list, font, text, len, font_height, &count);
+        if (glyphs) {
+            for (i = 0; i < count; ++i)
+                zr_canvas_push_glyph(list, origin, &glyphs[i], color);
+            return;
+        }
+    }
 
     /* draw every glyph image */
-    x = rect.x;
+    x = 0;
+    scale = font_height / font->height;
     glyph_len = text_len = zr_utf_decode(text, &unicode, len);
     if (!glyph_len) return;
     while (text_len <= len && glyph_len) {
-        float gx, gy, gh, gw;
-        float char_width = 0;
         if (unicode == ZR_UTF_INVALID) break;
 
         /* query currently drawn glyph information */
         next_glyph_len = zr_utf_decode(text + text_len, &next, len - text_len);
-        font->query(font->userdata, font->height, &g, unicode,
-                    (next == ZR_UTF_INVALID) ? '\0' : next);
-
-        /* calculate and draw glyph drawing rectangle and image */
-        gx = x + g.offset.x * scale;
-        gy = rect.y + (rect.h/2) - (font->height/2) + g.offset.y * scale;
-        gw = g.width * scale; gh = g.height * scale;
-        char_width = g.xadvance * scale;
-        zr_canvas_push_rect_uv(list, zr_vec2(gx,gy), zr_vec2(gx + gw, gy+ gh),
-            g.uv[0], g.uv[1], color);
+        x += zr_text_glyph_query(&g, font, scale, x, unicode, next);
+        zr_canvas_push_glyph(list, origin, &g, color);
 
         /* offset next glyph */
         text_len += glyph_len;
-        x += char_width;
         glyph_len = next_glyph_len;
         unicode = next;
     }
 }
 
+static void
+zr_canvas_load_command(struct zr_canvas *list, const struct zr_command *cmd,
+    float line_thickness, unsigned int curve_segments)
+{
+    switch (cmd->type) {
+    case ZR_COMMAND_NOP: break;
+    case ZR_COMMAND_SCISSOR: {
+        const struct zr_command_scissor *s = zr_command(scissor, cmd);
+        zr_canvas_add_clip(list, zr_rect(s->x, s->y, s->w, s->h));
+    } break;
+    case ZR_COMMAND_LINE: {
+        const struct zr_command_line *l = zr_command(line, cmd);
+        zr_canvas_add_line(list, zr_vec2(l->begin.x, l->begin.y),
+            zr_vec2(l->end.x, l->end.y), l->color, line_thickness);
+    } break;
+    case ZR_COMMAND_CURVE: {
+        const struct zr_command_curve *q = zr_command(curve, cmd);
+        zr_canvas_add_curve(list, zr_vec2(q->begin.x, q->begin.y),
+            zr_vec2(q->ctrl[0].x, q->ctrl[0].y), zr_vec2(q->ctrl[1].x,
+            q->ctrl[1].y), zr_vec2(q->end.x, q->end.y), q->color,
+            curve_segments, line_thickness);
+    } break;
+    case ZR_COMMAND_RECT: {
+        const struct zr_command_rect *r = zr_command(rect, cmd);
+        zr_canvas_add_rect(list, zr_rect(r->x, r->y, r->w, r->h),
+            r->color, (float)r->rounding);
+    } break;
+    case ZR_COMMAND_CIRCLE: {
+        const struct zr_command_circle *c = zr_command(circle, cmd);
+        zr_canvas_add_circle(list, zr_vec2((float)c->x + (float)c->w/2,
+            (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
+            curve_segments);
+    } break;
+    case ZR_COMMAND_ARC: {
+        const struct zr_command_arc *c = zr_command(arc, cmd);
+        zr_canvas_path_arc_to(list, zr_vec2(c->cx, c->cy), c->r,
+            c->a[0], c->a[1], curve_segments);
+        zr_canvas_path_fill(list, c->color);
+    } break;
+    case ZR_COMMAND_TRIANGLE: {
+        const struct zr_command_triangle *t = zr_command(triangle, cmd);
+        zr_canvas_add_triangle(list, zr_vec2(t->a.x, t->a.y),
+            zr_vec2(t->b.x, t->b.y), zr_vec2(t->c.x, t->c.y), t->color);
+    } break;
+    case ZR_COMMAND_TEXT: {
+        const struct zr_command_text *t = zr_command(text, cmd);
+        zr_canvas_add_text(list, &t->font, zr_rect(t->x, t->y, t->w, t->h),
+            t->string, t->length, t->height, t->foreground);
+    } break;
+    case ZR_COMMAND_IMAGE: {
+        const struct zr_command_image *i = zr_command(image, cmd);
+        zr_canvas_add_image(list, i->img, zr_rect(i->x, i->y, i->w, i->h),
+            zr_rgb(255, 255, 255));
+    } break;
+    default: break;
+    }
+}
+
 static void
 zr_canvas_load(struct zr_canvas *list, struct zr_context *queue,
     float line_thickness, unsigned int curve_segments)
@@ -2752,109 +3274,307 @@ zr_canvas_load(struct zr_canvas *list, struct zr_context *queue,
     ZR_ASSERT(queue);
     line_thickness = MAX(line_thickness, 1.0f);
     if (!list || !queue || !list->vertexes || !list->elements) return;
+    zr_foreach(cmd, queue)
+        zr_canvas_load_command(list, cmd, line_thickness, curve_segments);
+}
 
-    zr_foreach(cmd, queue) {
-        switch (cmd->type) {
-        case ZR_COMMAND_NOP: break;
-        case ZR_COMMAND_SCISSOR: {
-            const struct zr_command_scissor *s = zr_command(scissor, cmd);
-            zr_canvas_add_clip(list, zr_rect(s->x, s->y, s->w, s->h));
-        } break;
-        case ZR_COMMAND_LINE: {
-            const struct zr_command_line *l = zr_command(line, cmd);
-            zr_canvas_add_line(list, zr_vec2(l->begin.x, l->begin.y),
-                zr_vec2(l->end.x, l->end.y), l->color, line_thickness);
-        } break;
-        case ZR_COMMAND_CURVE: {
-            const struct zr_command_curve *q = zr_command(curve, cmd);
-            zr_canvas_add_curve(list, zr_vec2(q->begin.x, q->begin.y),
-                zr_vec2(q->ctrl[0].x, q->ctrl[0].y), zr_vec2(q->ctrl[1].x,
-                q->ctrl[1].y), zr_vec2(q->end.x, q->end.y), q->color,
-                curve_segments, line_thickness);
-        } break;
-        case ZR_COMMAND_RECT: {
-            const struct zr_command_rect *r = zr_command(rect, cmd);
-            zr_canvas_add_rect(list, zr_rect(r->x, r->y, r->w, r->h),
-                r->color, (float)r->rounding);
-        } break;
-        case ZR_COMMAND_CIRCLE: {
-            const struct zr_command_circle *c = zr_command(circle, cmd);
-            zr_canvas_add_circle(list, zr_vec2((float)c->x + (float)c->w/2,
-                (float)c->y + (float)c->h/2), (float)c->w/2, c->color,
-                curve_segments);
-        } break;
-        case ZR_COMMAND_ARC: {
-            const struct zr_command_arc *c = zr_command(arc, cmd);
-            zr_canvas_path_arc_to(list, zr_vec2(c->cx, c->cy), c->r,
-                c->a[0], c->a[1], curve_segments);
-            zr_canvas_path_fill(list, c->color);
-        } break;
-        case ZR_COMMAND_TRIANGLE: {
-            const struct zr_command_triangle *t = zr_command(triangle, cmd);
-            zr_canvas_add_triangle(list, zr_vec2(t->a.x, t->a.y),
-                zr_vec2(t->b.x, t->b.y), zr_vec2(t->c.x, t->c.y), t->color);
-        } break;
-        case ZR_COMMAND_TEXT: {
-            const struct zr_command_text *t = zr_command(text, cmd);
-            zr_canvas_add_text(list, t->font, zr_rect(t->x, t->y, t->w, t->h),
-                t->string, t->length, t->height, t->foreground);
-        } break;
-        case ZR_COMMAND_IMAGE: {
-            const struct zr_command_image *i = zr_command(image, cmd);
-            zr_canvas_add_image(list, i->img, zr_rect(i->x, i->y, i->w, i->h),
-                zr_rgb(255, 255, 255));
-        } break;
-        default: break;
+struct zr_canvas_jobs {
+    const struct zr_context *ctx;
+    struct zr_window **windows;
+    float line_thickness;
+    unsigned int curve_segments;
+};
+
+static void
+zr_canvas_chunk_free(struct zr_canvas_chunk *chunk)
+{
+    zr_buffer_free(&chunk->cmds);
+    zr_buffer_free(&chunk->vertexes);
+    zr_buffer_free(&chunk->elements);
+    zr_zero(chunk, sizeof(*chunk));
+}
+
+static void
+zr_canvas_load_window(void *data, unsigned int index)
+{
+    /* converts the command range of one window into its private chunk.
+     * Runs on user worker threads so it only reads shared state */
+    const struct zr_canvas_jobs *jobs = (const struct zr_canvas_jobs*)data;
+    struct zr_window *win = jobs->windows[index];
+    struct zr_canvas_chunk *chunk = &win->chunk;
+    const zr_byte *buffer = (const zr_byte*)jobs->ctx->memory.memory.ptr;
+    const struct zr_command *cmd;
+    struct zr_canvas list;
+    zr_size offset;
+
+    list = jobs->ctx->canvas;
+    list.buffer = &chunk->cmds;
+    list.vertexes = &chunk->vertexes;
+    list.elements = &chunk->elements;
+    list.clip_rect = zr_null_rect;
+    list.element_count = 0;
+    list.vertex_count = 0;
+    list.overflow = 0;
+    list.cmd_offset = 0;
+    list.cmd_count = 0;
+    list.path_count = 0;
+    list.path_offset = 0;
+    zr_zero(&list.text_cache, sizeof(list.text_cache));
+    zr_buffer_clear(list.buffer);
+    zr_buffer_clear(list.vertexes);
+    zr_buffer_clear(list.elements);
+
+    offset = win->buffer.begin;
+    while (1) {
+        cmd = zr_ptr_add_const(struct zr_command, buffer, offset);
+        zr_canvas_load_command(&list, cmd, jobs->line_thickness, jobs->curve_segments);
+        if (offset == win->buffer.last) break;
+        offset = cmd->next;
+    }
+
+    chunk->vertex_count = list.vertex_count;
+    chunk->element_count = list.element_count;
+    chunk->cmd_count = list.cmd_count;
+    chunk->cmd_offset = list.cmd_offset;
+    chunk->overflow = list.overflow;
+}
+
+static void
+zr_canvas_append(struct zr_canvas *list, const struct zr_canvas_chunk *chunk)
+{
+    /* copies a converted window chunk behind the already converted windows
+     * and rebases its element indexes onto the output vertex buffer */
+    const struct zr_draw_command *cmds;
+    const zr_draw_index *src_ids;
+    unsigned int base, i;
+    if (!chunk->cmd_count) return;
+
+    base = list->vertex_count;
+    if (chunk->vertex_count) {
+        const zr_size size = list->vertex_size * chunk->vertex_count;
+        const zr_byte *src = (const zr_byte*)chunk->vertexes.memory.ptr;
+        void *vtx = zr_canvas_alloc_vertexes(list, chunk->vertex_count);
+        if (!vtx) return;
+        zr_memcopy(vtx, src + chunk->vertexes.allocated - size, size);
+    }
+
+    src_ids = zr_ptr_add_const(zr_draw_index, chunk->elements.memory.ptr,
+        chunk->elements.allocated - sizeof(zr_draw_index) * chunk->element_count);
+    cmds = zr_ptr_add_const(struct zr_draw_command, chunk->cmds.memory.ptr,
+        chunk->cmds.memory.size - chunk->cmd_offset);
+    for (i = 0; i < chunk->cmd_count; ++i) {
+        const struct zr_draw_command *cmd = cmds - i;
+        struct zr_draw_command *prev = 0;
+        zr_draw_index *ids;
+        unsigned int j;
+
+        /* continue the last draw command if the state did not change */
+        if (!i && list->cmd_count) prev = zr_canvas_command_last(list);
+        if (!prev || prev->texture.id != cmd->texture.id ||
+            prev->clip_rect.x != cmd->clip_rect.x ||
+            prev->clip_rect.y != cmd->clip_rect.y ||
+            prev->clip_rect.w != cmd->clip_rect.w ||
+            prev->clip_rect.h != cmd->clip_rect.h) {
+            if (!zr_canvas_push_command(list, cmd->clip_rect, cmd->texture))
+                return;
         }
+        if (!cmd->elem_count) continue;
+
+        ids = zr_canvas_alloc_elements(list, cmd->elem_count);
+        if (!ids) return;
+        for (j = 0; j < cmd->elem_count; ++j)
+            ids[j] = (zr_draw_index)(src_ids[j] + base);
+        src_ids += cmd->elem_count;
     }
 }
 
+static void
+zr_canvas_load_parallel(struct zr_canvas *list, struct zr_context *ctx,
+    float line_thickness, unsigned int curve_segments,
+    zr_convert_dispatch_f dispatch, zr_handle userdata)
+{
+    static const zr_size ptr_size = sizeof(struct zr_window*);
+    static const zr_size ptr_align = ZR_ALIGNOF(struct zr_window*);
+    struct zr_canvas_jobs jobs;
+    struct zr_window **windows;
+    struct zr_window *iter;
+    unsigned int count = 0, i;
+
+    ZR_ASSERT(list);
+    ZR_ASSERT(list->vertexes);
+    ZR_ASSERT(list->elements);
+    ZR_ASSERT(ctx);
+    line_thickness = MAX(line_thickness, 1.0f);
+    if (!list || !ctx || !list->vertexes || !list->elements) return;
+    if (!ctx->count) return;
+
+    /* temporary list of all windows with commands */
+    zr_buffer_mark(list->buffer, ZR_BUFFER_FRONT);
+    windows = (struct zr_window**)zr_buffer_alloc(list->buffer,
+        ZR_BUFFER_FRONT, ptr_size * ctx->count, ptr_align);
+    if (!windows) return;
+    for (iter = ctx->begin; iter; iter = iter->next) {
+        if (iter->buffer.begin == iter->buffer.end) continue;
+        if (!iter->chunk.cmds.memory.ptr) {
+            zr_buffer_init(&iter->chunk.cmds, &ctx->memory.pool, ZR_DEFAULT_COMMAND_BUFFER_SIZE);
+            zr_buffer_init(&iter->chunk.vertexes, &ctx->memory.pool, ZR_DEFAULT_COMMAND_BUFFER_SIZE);
+            zr_buffer_init(&iter->chunk.elements, &ctx->memory.pool, ZR_DEFAULT_COMMAND_BUFFER_SIZE);
+        }
+        windows[count++] = iter;
+    }
+
+    jobs.ctx = ctx;
+    jobs.windows = windows;
+    jobs.line_thickness = line_thickness;
+    jobs.curve_segments = curve_segments;
+    dispatch(userdata, zr_canvas_load_window, &jobs, count);
+
+    for (i = 0; i < count; ++i) {
+        zr_canvas_append(list, &windows[i]->chunk);
+        if (windows[i]->chunk.overflow)
+            list->overflow = zr_true;
+    }
+    zr_buffer_reset(list->buffer, ZR_BUFFER_FRONT);
+}
+
+static int
+zr_canvas_dynamic_text(struct zr_context *ctx)
+{
+    /* glyph lookups of dynamic fonts write to the atlas, so text drawn with
+     * one cannot be converted by parallel jobs. Text commands carry their
+     * own font, which covers pushed fonts, style changes and retained
+     * windows alike */
+    const struct zr_command *cmd;
+    zr_foreach(cmd, ctx) {
+        const struct zr_command_text *t;
+        if (cmd->type != ZR_COMMAND_TEXT) continue;
+        t = (const struct zr_command_text*)cmd;
+        if (t->font.dynamic) return zr_true;
+    }
+    return zr_false;
+}
+
 void
 zr_convert(struct zr_context *ctx, struct zr_buffer *cmds,
     struct zr_buffer *vertexes, struct zr_buffer *elements,
     const struct zr_convert_config *config)
 {
     zr_canvas_setup(&ctx->canvas, cmds, vertexes, elements,
-        config->null, config->line_AA, config->shape_AA);
-    zr_canvas_load(&ctx->canvas, ctx, config->line_thickness,
-        config->circle_segment_count);
+        config->null, config->line_AA, config->shape_AA,
+        config->vertex_layout, config->vertex_size, config->vertex_alignment);
+    if (config->dispatch && ctx->memory.type == ZR_BUFFER_DYNAMIC &&
+        !zr_canvas_dynamic_text(ctx)) {
+        zr_canvas_load_parallel(&ctx->canvas, ctx, config->line_thickness,
+            config->circle_segment_count, config->dispatch, config->userdata);
+    } else {
+        struct zr_text_run_cache *cache = &ctx->canvas.text_cache;
+        if (cache->size != config->text_cache_size && ctx->memory.type == ZR_BUFFER_DYNAMIC &&
+            ctx->memory.pool.alloc) {
+            /* glyph run cache is only used by the single threaded conversion */
+            void *memory = 0;
+            if (cache->runs)
+                ctx->memory.pool.free(ctx->memory.pool.userdata, cache->runs);
+            if (config->text_cache_size)
+                memory = ctx->memory.pool.alloc(ctx->memory.pool.userdata,
+                    config->text_cache_size);
+            zr_text_run_cache_init(cache, memory, config->text_cache_size);
+            if (memory && !cache->runs)
+                ctx->memory.pool.free(ctx->memory.pool.userdata, memory);
+        }
+        ctx->canvas.seq = ctx->seq;
+        zr_canvas_load(&ctx->canvas, ctx, config->line_thickness,
+            config->circle_segment_count);
+    }
 }
 
-const struct zr_draw_command*
-zr__draw_begin(const struct zr_context *ctx,
-    const struct zr_buffer *buffer)
+static const struct zr_draw_command*
+zr_canvas_draw_begin(const struct zr_canvas *list, const struct zr_buffer *buffer)
 {
     zr_byte *memory;
     zr_size offset;
     const struct zr_draw_command *cmd;
     ZR_ASSERT(buffer);
-    if (!buffer || !buffer->size || !ctx->canvas.cmd_count) return 0;
+    if (!buffer || !buffer->size || !list->cmd_count) return 0;
 
     memory = buffer->memory.ptr;
-    offset = buffer->memory.size - ctx->canvas.cmd_offset;
+    offset = buffer->memory.size - list->cmd_offset;
     cmd = zr_ptr_add(const struct zr_draw_command, memory, offset);
     return cmd;
 }
 
-const struct zr_draw_command*
-zr__draw_next(const struct zr_draw_command *cmd,
-    const struct zr_buffer *buffer, const struct zr_context *ctx)
+static const struct zr_draw_command*
+zr_canvas_draw_next(const struct zr_canvas *list, const struct zr_draw_command *cmd,
+    const struct zr_buffer *buffer)
 {
     zr_byte *memory;
     zr_size offset, size;
     const struct zr_draw_command *end;
     ZR_ASSERT(buffer);
-    ZR_ASSERT(ctx);
-    if (!cmd || !buffer || !ctx) return 0;
+    if (!cmd || !buffer) return 0;
     memory = (zr_byte*)buffer->memory.ptr;
     size = buffer->memory.size;
-    offset = size - ctx->canvas.cmd_offset;
+    offset = size - list->cmd_offset;
     end = zr_ptr_add(const struct zr_draw_command, memory, offset);
-    end -= (ctx->canvas.cmd_count-1);
+    end -= (list->cmd_count-1);
     if (cmd <= end) return 0;
     return (cmd-1);
 }
 
+const struct zr_draw_command*
+zr__draw_begin(const struct zr_context *ctx,
+    const struct zr_buffer *buffer)
+{
+    ZR_ASSERT(ctx);
+    if (!ctx) return 0;
+    return zr_canvas_draw_begin(&ctx->canvas, buffer);
+}
+
+const struct zr_draw_command*
+zr__draw_next(const struct zr_draw_command *cmd,
+    const struct zr_buffer *buffer, const struct zr_context *ctx)
+{
+    ZR_ASSERT(ctx);
+    if (!ctx) return 0;
+    return zr_canvas_draw_next(&ctx->canvas, cmd, buffer);
+}
+
+void
+zr_frame_convert(struct zr_frame *frame, struct zr_buffer *cmds,
+    struct zr_buffer *vertexes, struct zr_buffer *elements,
+    const struct zr_convert_config *config)
+{
+    const struct zr_command *cmd;
+    float line_thickness;
+    ZR_ASSERT(frame);
+    ZR_ASSERT(config);
+    if (!frame || !config || !vertexes || !elements) return;
+
+    zr_canvas_setup(&frame->canvas, cmds, vertexes, elements,
+        config->null, config->line_AA, config->shape_AA,
+        config->vertex_layout, config->vertex_size, config->vertex_alignment);
+    line_thickness = MAX(config->line_thickness, 1.0f);
+    zr_frame_foreach(cmd, frame)
+        zr_canvas_load_command(&frame->canvas, cmd, line_thickness,
+            config->circle_segment_count);
+}
+
+const struct zr_draw_command*
+zr__frame_draw_begin(const struct zr_frame *frame, const struct zr_buffer *buffer)
+{
+    ZR_ASSERT(frame);
+    if (!frame) return 0;
+    return zr_canvas_draw_begin(&frame->canvas, buffer);
+}
+
+const struct zr_draw_command*
+zr__frame_draw_next(const struct zr_draw_command *cmd,
+    const struct zr_buffer *buffer, const struct zr_frame *frame)
+{
+    ZR_ASSERT(frame);
+    if (!frame) return 0;
+    return zr_canvas_draw_next(&frame->canvas, cmd, buffer);
+}
+
 #endif
 /*
  * ==============================================================
@@ -2917,6 +3637,7 @@ zr__draw_next(const struct zr_draw_command *cmd,
 struct zr_font_bake_data {
     stbtt_fontinfo info;
     stbrp_rect *rects;
+    int rect_count;
     stbtt_pack_range *ranges;
     zr_rune range_count;
 };
@@ -2927,6 +3648,8 @@ struct zr_font_baker {
     stbtt_packedchar *packed_chars;
     stbrp_rect *rects;
     stbtt_pack_range *ranges;
+    stbrp_rect custom;
+    int width, height;
 };
 
 static const zr_size zr_rect_align = ZR_ALIGNOF(stbrp_rect);
@@ -2961,6 +3684,13 @@ zr_range_glyph_count(const zr_rune *range, int count)
     return total_glyphs;
 }
 
+static int
+zr_font_sdf_pad(float spread)
+{
+    int pad = (int)spread;
+    return ((float)pad < spread) ? pad + 1: pad;
+}
+
 const zr_rune*
 zr_font_default_glyph_ranges(void)
 {
@@ -3023,8 +3753,9 @@ void zr_font_bake_memory(zr_size *temp, int *glyph_count,
     if (!config->range)
         config->range = zr_font_default_glyph_ranges();
     for (i = 0; i < count; ++i) {
-        range_count += zr_range_count(config[i].range);
-        *glyph_count += zr_range_glyph_count(config[i].range, range_count);
+        int font_ranges = zr_range_count(config[i].range);
+        range_count += font_ranges;
+        *glyph_count += zr_range_glyph_count(config[i].range, font_ranges);
     }
 
     *temp = (zr_size)*glyph_count * sizeof(stbrp_rect);
@@ -3050,16 +3781,51 @@ zr_font_baker(void *memory, int glyph_count, int count)
     return baker;
 }
 
-int
-zr_font_bake_pack(zr_size *image_memory, int *width, int *height,
+static int
+zr_font_bake_pack_rects(struct zr_font_baker *baker, int width, int height,
+    int heuristic, int font_count, int *used_height)
+{
+    /* packs the custom space first so it will be in the upper left corner
+     * and afterwards the glyphs of every font. Returns if all rects fit */
+    int i, j, fit = zr_true;
+    stbtt_pack_context *spc = &baker->spc;
+    stbrp_context *context = (stbrp_context*)spc->pack_info;
+
+    *used_height = 0;
+    stbrp_init_target(context, width - spc->padding, height - spc->padding,
+        (stbrp_node*)spc->nodes, width - spc->padding);
+    stbrp_setup_heuristic(context, heuristic);
+    if (baker->custom.w) {
+        stbrp_pack_rects(context, &baker->custom, 1);
+        if (baker->custom.was_packed)
+            *used_height = (int)(baker->custom.y + baker->custom.h);
+        else fit = zr_false;
+    }
+    for (i = 0; i < font_count; ++i) {
+        struct zr_font_bake_data *tmp = &baker->build[i];
+        stbrp_pack_rects(context, tmp->rects, tmp->rect_count);
+        for (j = 0; j < tmp->rect_count; ++j) {
+            if (tmp->rects[j].was_packed)
+                *used_height = MAX(*used_height, tmp->rects[j].y + tmp->rects[j].h);
+            else fit = zr_false;
+        }
+    }
+    return fit;
+}
+
+static int
+zr_font_bake_pack_atlas(zr_size *image_memory, int *width, int *height,
     struct zr_recti *custom, void *temp, zr_size temp_size,
-    const struct zr_font_config *config, int count)
+    const struct zr_font_config *config, int count, int tight)
 {
-    static const zr_size max_height = 1024 * 32;
+    static const int max_height = 1024 * 32;
     struct zr_font_baker* baker;
     int total_glyph_count = 0;
     int total_range_count = 0;
     int i = 0;
+    int default_width, pack_width, side = 1;
+    int used_height = 0;
+    zr_size area = 0;
 
     ZR_ASSERT(image_memory);
     ZR_ASSERT(width);
@@ -3072,8 +3838,9 @@ zr_font_bake_pack(zr_size *image_memory, int *width, int *height,
         !temp_size || !count) return zr_false;
 
     for (i = 0; i < count; ++i) {
-        total_range_count += zr_range_count(config[i].range);
-        total_glyph_count += zr_range_glyph_count(config[i].range, total_range_count);
+        int font_ranges = zr_range_count(config[i].range);
+        total_range_count += font_ranges;
+        total_glyph_count += zr_range_glyph_count(config[i].range, font_ranges);
     }
 
     /* setup font baker from temporary memory */
@@ -3086,33 +3853,22 @@ zr_font_bake_pack(zr_size *image_memory, int *width, int *height,
             return zr_false;
     }
 
-    *height = 0;
-    *width = (total_glyph_count > 1000) ? 1024 : 512;
-    stbtt_PackBegin(&baker->spc, 0, (int)*width, (int)max_height, 0, 1, 0);
+    if (custom) {
+        baker->custom.w = (stbrp_coord)((custom->w * 2) + 1);
+        baker->custom.h = (stbrp_coord)(custom->h + 1);
+        area += (zr_size)baker->custom.w * (zr_size)baker->custom.h;
+    }
+
+    /* the packing context is only used to gather glyph rects until the image
+     * width is known, so it is created wide enough for every tried width */
+    default_width = (total_glyph_count > 1000) ? 1024 : 512;
+    stbtt_PackBegin(&baker->spc, 0, default_width, max_height, 0, 1, 0);
     {
         int input_i = 0;
         int range_n = 0, rect_n = 0, char_n = 0;
 
-        /* pack custom user data first so it will be in the upper left corner*/
-        if (custom) {
-            stbrp_rect custom_space;
-            zr_zero(&custom_space, sizeof(custom_space));
-            custom_space.w = (stbrp_coord)((custom->w * 2) + 1);
-            custom_space.h = (stbrp_coord)(custom->h + 1);
-
-            stbtt_PackSetOversampling(&baker->spc, 1, 1);
-            stbrp_pack_rects((stbrp_context*)baker->spc.pack_info, &custom_space, 1);
-            *height = MAX(*height, (int)(custom_space.y + custom_space.h));
-
-            custom->x = (short)custom_space.x;
-            custom->y = (short)custom_space.y;
-            custom->w = (short)custom_space.w;
-            custom->h = (short)custom_space.h;
-        }
-
-        /* first font pass: pack all glyphs */
+        /* first font pass: gather the rects of all glyphs */
         for (input_i = 0; input_i < count; input_i++) {
-            int n = 0;
             const zr_rune *in_range;
             const struct zr_font_config *cfg = &config[input_i];
             struct zr_font_bake_data *tmp = &baker->build[input_i];
@@ -3138,63 +3894,252 @@ zr_font_bake_pack(zr_size *image_memory, int *width, int *height,
                 char_n += tmp->ranges[i].num_chars;
             }
 
-            /* pack */
+            /* gather */
             tmp->rects = baker->rects + rect_n;
             rect_n += glyph_count;
-            stbtt_PackSetOversampling(&baker->spc, cfg->oversample_h, cfg->oversample_v);
-            n = stbtt_PackFontRangesGatherRects(&baker->spc, &tmp->info,
+            if (cfg->sdf_spread > 0)
+                stbtt_PackSetOversampling(&baker->spc, 1, 1);
+            else stbtt_PackSetOversampling(&baker->spc, cfg->oversample_h, cfg->oversample_v);
+            tmp->rect_count = stbtt_PackFontRangesGatherRects(&baker->spc, &tmp->info,
                 tmp->ranges, (int)tmp->range_count, tmp->rects);
-            stbrp_pack_rects((stbrp_context*)baker->spc.pack_info, tmp->rects, (int)n);
-
-            /* texture height */
-            for (i = 0; i < n; ++i) {
-                if (tmp->rects[i].was_packed)
-                    *height = MAX(*height, tmp->rects[i].y + tmp->rects[i].h);
+            if (cfg->sdf_spread > 0) {
+                /* distance fields extend past the glyph outline */
+                const int pad = zr_font_sdf_pad(cfg->sdf_spread);
+                for (i = 0; i < tmp->rect_count; ++i) {
+                    tmp->rects[i].w = (stbrp_coord)(tmp->rects[i].w + 2 * pad);
+                    tmp->rects[i].h = (stbrp_coord)(tmp->rects[i].h + 2 * pad);
+                }
             }
+            for (i = 0; i < tmp->rect_count; ++i)
+                area += (zr_size)tmp->rects[i].w * (zr_size)tmp->rects[i].h;
         }
         ZR_ASSERT(rect_n == total_glyph_count);
         ZR_ASSERT(char_n == total_glyph_count);
         ZR_ASSERT(range_n == total_range_count);
     }
-    *height = (int)zr_round_up_pow2((zr_uint)*height);
+
+    /* the widest image tried is four times the side of a square image
+     * with the area of all rects, which is never reached in practice */
+    while ((zr_size)side * (zr_size)side < area) side *= 2;
+    pack_width = MAX(default_width, MIN(side * 4, max_height));
+    if (tight && pack_width > default_width) {
+        stbtt_PackEnd(&baker->spc);
+        stbtt_PackBegin(&baker->spc, 0, pack_width, max_height, 0, 1, 0);
+    }
+
+    *width = 0;
+    if (tight) {
+        /* try power of two sizes from the smallest possible area upwards,
+         * the square or wider size first and then the same size rotated */
+        int w = side, h = side;
+        if ((zr_size)side * (zr_size)side / 2 >= area) h = side / 2;
+        while (!*width && w <= pack_width && h <= max_height) {
+            int shape, heuristic;
+            for (shape = 0; shape < 2 && !*width; ++shape) {
+                int try_w = (shape) ? h: w;
+                int try_h = (shape) ? w: h;
+                if (shape && w == h) break;
+                for (heuristic = 0; heuristic < 2 && !*width; ++heuristic) {
+                    if (zr_font_bake_pack_rects(baker, try_w, try_h, (heuristic) ?
+                        STBRP_HEURISTIC_Skyline_BF_sortHeight:
+                        STBRP_HEURISTIC_Skyline_BL_sortHeight, count, &used_height))
+                        *width = try_w;
+                }
+            }
+            if (w == h) w *= 2;
+            else h *= 2;
+        }
+    }
+    if (!*width) {
+        /* fixed width with the height growing as needed */
+        *width = default_width;
+        zr_font_bake_pack_rects(baker, default_width, max_height,
+            STBRP_HEURISTIC_Skyline_default, count, &used_height);
+    }
+    *height = (int)zr_round_up_pow2((zr_uint)used_height);
+    baker->width = *width;
+    baker->height = *height;
+    baker->spc.width = *width;
+    baker->spc.stride_in_bytes = *width;
     *image_memory = (zr_size)(*width) * (zr_size)(*height);
+
+    if (custom) {
+        custom->x = (short)baker->custom.x;
+        custom->y = (short)baker->custom.y;
+        custom->w = (short)baker->custom.w;
+        custom->h = (short)baker->custom.h;
+    }
     return zr_true;
 }
 
+int
+zr_font_bake_pack(zr_size *image_memory, int *width, int *height,
+    struct zr_recti *custom, void *temp, zr_size temp_size,
+    const struct zr_font_config *config, int count)
+{
+    return zr_font_bake_pack_atlas(image_memory, width, height, custom,
+        temp, temp_size, config, count, zr_false);
+}
+
+int
+zr_font_bake_pack_tight(zr_size *image_memory, int *width, int *height,
+    struct zr_recti *custom, void *temp, zr_size temp_size,
+    const struct zr_font_config *config, int count)
+{
+    return zr_font_bake_pack_atlas(image_memory, width, height, custom,
+        temp, temp_size, config, count, zr_true);
+}
+
 void
-zr_font_bake(void *image_memory, int width, int height,
-    void *temp, zr_size temp_size, struct zr_font_glyph *glyphs,
-    int glyphs_count, const struct zr_font_config *config, int font_count)
+zr_font_bake_report(struct zr_font_pack_report *report,
+    struct zr_font_pack_stats *fonts, const void *temp, int font_count)
 {
-    int input_i = 0;
-    struct zr_font_baker* baker;
-    zr_rune glyph_n = 0;
+    int i, j;
+    zr_size custom;
+    const struct zr_font_baker *baker;
 
-    ZR_ASSERT(image_memory);
-    ZR_ASSERT(width);
-    ZR_ASSERT(height);
-    ZR_ASSERT(config);
+    ZR_ASSERT(report);
     ZR_ASSERT(temp);
-    ZR_ASSERT(temp_size);
-    ZR_ASSERT(font_count);
-    ZR_ASSERT(glyphs_count);
-    if (!image_memory || !width || !height || !config || !temp ||
-        !temp_size || !font_count || !glyphs || !glyphs_count)
+    if (!report || !temp) return;
+    baker = (const struct zr_font_baker*)ZR_ALIGN_PTR(temp, zr_baker_align);
+
+    zr_zero(report, sizeof(*report));
+    report->width = baker->width;
+    report->height = baker->height;
+    report->image_size = (zr_size)baker->width * (zr_size)baker->height;
+    for (i = 0; i < font_count; ++i) {
+        struct zr_font_pack_stats stats;
+        const struct zr_font_bake_data *tmp = &baker->build[i];
+        zr_zero(&stats, sizeof(stats));
+        stats.glyph_count = tmp->rect_count;
+        for (j = 0; j < tmp->rect_count; ++j) {
+            if (!tmp->rects[j].was_packed) continue;
+            stats.packed_count++;
+            stats.used += (zr_size)tmp->rects[j].w * (zr_size)tmp->rects[j].h;
+        }
+        if (report->image_size)
+            stats.fill = (float)stats.used / (float)report->image_size;
+        if (fonts) fonts[i] = stats;
+        report->total.glyph_count += stats.glyph_count;
+        report->total.packed_count += stats.packed_count;
+        report->total.used += stats.used;
+    }
+
+    custom = (baker->custom.was_packed) ?
+        (zr_size)baker->custom.w * (zr_size)baker->custom.h: 0;
+    report->wasted = report->image_size - MIN(report->image_size, report->total.used + custom);
+    if (report->image_size) {
+        report->total.fill = (float)report->total.used / (float)report->image_size;
+        report->fill = (float)(report->total.used + custom) / (float)report->image_size;
+    }
+}
+
+static void
+zr_font_sdf_render(zr_byte *dst, int stride, int w, int h, const zr_byte *src,
+    int src_w, int src_h, int pad, float spread)
+{
+    /* converts a coverage bitmap into a signed distance field padded by
+     * `pad` on each side. Every texel searches the nearest texel on the other
+     * side of the outline inside the padding radius. Partially covered
+     * texels lie on the outline and use their coverage as distance */
+    int x, y, dx, dy;
+    for (y = 0; y < h; ++y) {
+        for (x = 0; x < w; ++x) {
+            float dist;
+            int value, inside, best = pad * pad + 1;
+            int sx = x - pad, sy = y - pad;
+            int c = (sx >= 0 && sy >= 0 && sx < src_w && sy < src_h) ?
+                src[sx + sy * src_w]: 0;
+            inside = (c >= 128);
+            for (dy = -pad; dy <= pad; ++dy) {
+                int ty = sy + dy;
+                for (dx = -pad; dx <= pad; ++dx) {
+                    int tx = sx + dx, t, d = dx * dx + dy * dy;
+                    if (d >= best) continue;
+                    t = (tx >= 0 && ty >= 0 && tx < src_w && ty < src_h) ?
+                        src[tx + ty * src_w]: 0;
+                    if ((t >= 128) != inside) best = d;
+                }
+            }
+            if (c > 0 && c < 255 && best <= 2)
+                dist = ((float)c - 127.5f) / 255.0f;
+            else if (best > pad * pad)
+                dist = (inside) ? spread: -spread;
+            else {
+                dist = (float)best * zr_inv_sqrt((float)best) - 0.5f;
+                dist = (inside) ? dist: -dist;
+            }
+            value = 128 + (int)(dist * 127.0f / spread);
+            dst[x + y * stride] = (zr_byte)CLAMP(0, value, 255);
+        }
+    }
+}
+
+static void
+zr_font_bake_render(stbtt_pack_context *spc, struct zr_font_bake_data *tmp,
+    stbtt_pack_range *ranges, int range_count, stbrp_rect *rects,
+    const struct zr_font_config *cfg)
+{
+    int i, j, k = 0;
+    int pad;
+    if (cfg->sdf_spread <= 0) {
+        stbtt_PackSetOversampling(spc, cfg->oversample_h, cfg->oversample_v);
+        stbtt_PackFontRangesRenderIntoRects(spc, &tmp->info, ranges, range_count, rects);
         return;
+    }
 
-    /* second font pass: render glyphs */
-    baker = (struct zr_font_baker*)ZR_ALIGN_PTR(temp, zr_baker_align);
-    zr_zero(image_memory, (zr_size)((zr_size)width * (zr_size)height));
-    baker->spc.pixels = (unsigned char*)image_memory;
-    baker->spc.height = (int)height;
-    for (input_i = 0; input_i < font_count; ++input_i) {
-        const struct zr_font_config *cfg = &config[input_i];
-        struct zr_font_bake_data *tmp = &baker->build[input_i];
-        stbtt_PackSetOversampling(&baker->spc, cfg->oversample_h, cfg->oversample_v);
-        stbtt_PackFontRangesRenderIntoRects(&baker->spc, &tmp->info, tmp->ranges,
-            (int)tmp->range_count, tmp->rects);
+    /* rasterize each glyph and write its distance field into the packed
+     * rect, filling the packed glyph data the way stb_truetype does */
+    pad = zr_font_sdf_pad(cfg->sdf_spread);
+    for (i = 0; i < range_count; ++i) {
+        float scale = stbtt_ScaleForPixelHeight(&tmp->info, ranges[i].font_size);
+        for (j = 0; j < ranges[i].num_chars; ++j) {
+            int advance, lsb, x0, y0, x1, y1, w, h, bw, bh;
+            stbrp_rect *r = &rects[k++];
+            stbtt_packedchar *bc = &ranges[i].chardata_for_range[j];
+            int codepoint = ranges[i].first_unicode_codepoint_in_range + j;
+            int glyph = stbtt_FindGlyphIndex(&tmp->info, codepoint);
+            unsigned char *bitmap;
+            if (!r->was_packed) continue;
+
+            /* skip the one pixel packing padding on the left and top */
+            r->x = (stbrp_coord)(r->x + spc->padding);
+            r->y = (stbrp_coord)(r->y + spc->padding);
+            r->w = (stbrp_coord)(r->w - spc->padding);
+            r->h = (stbrp_coord)(r->h - spc->padding);
+
+            stbtt_GetGlyphHMetrics(&tmp->info, glyph, &advance, &lsb);
+            stbtt_GetGlyphBitmapBox(&tmp->info, glyph, scale, scale, &x0, &y0, &x1, &y1);
+            w = x1 - x0;
+            h = y1 - y0;
+            bitmap = (w > 0 && h > 0) ? stbtt_GetGlyphBitmap(&tmp->info, scale,
+                scale, glyph, &bw, &bh, 0, 0): 0;
+            if (bitmap) {
+                zr_font_sdf_render(spc->pixels + r->x + r->y * spc->stride_in_bytes,
+                    spc->stride_in_bytes, r->w, r->h, bitmap, bw, bh, pad, cfg->sdf_spread);
+                stbtt_FreeBitmap(bitmap, tmp->info.userdata);
+            }
+
+            bc->x0 = (unsigned short)r->x;
+            bc->y0 = (unsigned short)r->y;
+            bc->x1 = (unsigned short)(r->x + r->w);
+            bc->y1 = (unsigned short)(r->y + r->h);
+            bc->xadvance = scale * (float)advance;
+            bc->xoff = (float)(x0 - pad);
+            bc->yoff = (float)(y0 - pad);
+            bc->xoff2 = (float)(x0 - pad + r->w);
+            bc->yoff2 = (float)(y0 - pad + r->h);
+        }
     }
-    stbtt_PackEnd(&baker->spc);
+}
+
+static void
+zr_font_bake_glyphs(struct zr_font_baker *baker, int width, int height,
+    struct zr_font_glyph *glyphs, const struct zr_font_config *config,
+    int font_count)
+{
+    int input_i = 0;
+    zr_rune glyph_n = 0;
 
     /* third pass: setup font and glyphs */
     for (input_i = 0; input_i < font_count; ++input_i)  {
@@ -3216,6 +4161,7 @@ zr_font_bake(void *image_memory, int width, int height,
         dst_font->ascent = ((float)unscaled_ascent * font_scale);
         dst_font->descent = ((float)unscaled_descent * font_scale);
         dst_font->glyph_offset = glyph_n;
+        dst_font->sdf_spread = MAX(cfg->sdf_spread, 0);
 
         /* fill own baked font glyph array */
         for (i = 0; i < tmp->range_count; ++i) {
@@ -3235,7 +4181,7 @@ zr_font_bake(void *image_memory, int width, int height,
                     (int)height, char_idx, &dummy_x, &dummy_y, &q, 0);
 
                 /* fill own glyph type with data */
-                glyph = &glyphs[dst_font->glyph_offset + (unsigned int)char_idx];
+                glyph = &glyphs[dst_font->glyph_offset + glyph_count - 1];
                 glyph->codepoint = codepoint;
                 glyph->x0 = q.x0; glyph->y0 = q.y0;
                 glyph->x1 = q.x1; glyph->y1 = q.y1;
@@ -3258,11 +4204,146 @@ zr_font_bake(void *image_memory, int width, int height,
                     glyph->xadvance = (float)(int)(glyph->xadvance + 0.5f);
             }
         }
-        dst_font->glyph_count = glyph_count;
-        glyph_n += dst_font->glyph_count;
+        dst_font->glyph_count = glyph_count;
+        glyph_n += dst_font->glyph_count;
+    }
+}
+
+static struct zr_font_baker*
+zr_font_bake_begin(void *image_memory, int width, int height, void *temp)
+{
+    struct zr_font_baker *baker;
+    baker = (struct zr_font_baker*)ZR_ALIGN_PTR(temp, zr_baker_align);
+    zr_zero(image_memory, (zr_size)((zr_size)width * (zr_size)height));
+    baker->spc.pixels = (unsigned char*)image_memory;
+    baker->spc.height = (int)height;
+    return baker;
+}
+
+void
+zr_font_bake(void *image_memory, int width, int height,
+    void *temp, zr_size temp_size, struct zr_font_glyph *glyphs,
+    int glyphs_count, const struct zr_font_config *config, int font_count)
+{
+    int input_i = 0;
+    struct zr_font_baker* baker;
+
+    ZR_ASSERT(image_memory);
+    ZR_ASSERT(width);
+    ZR_ASSERT(height);
+    ZR_ASSERT(config);
+    ZR_ASSERT(temp);
+    ZR_ASSERT(temp_size);
+    ZR_ASSERT(font_count);
+    ZR_ASSERT(glyphs_count);
+    if (!image_memory || !width || !height || !config || !temp ||
+        !temp_size || !font_count || !glyphs || !glyphs_count)
+        return;
+
+    /* second font pass: render glyphs */
+    baker = zr_font_bake_begin(image_memory, width, height, temp);
+    for (input_i = 0; input_i < font_count; ++input_i) {
+        struct zr_font_bake_data *tmp = &baker->build[input_i];
+        zr_font_bake_render(&baker->spc, tmp, tmp->ranges, (int)tmp->range_count,
+            tmp->rects, &config[input_i]);
+    }
+    stbtt_PackEnd(&baker->spc);
+    zr_font_bake_glyphs(baker, width, height, glyphs, config, font_count);
+}
+
+#define ZR_FONT_BAKE_JOB_SIZE 256
+
+struct zr_font_bake_jobs {
+    struct zr_font_baker *baker;
+    const struct zr_font_config *config;
+    int font_count;
+};
+
+static unsigned int
+zr_font_bake_job_count(const struct zr_font_baker *baker, int font_count)
+{
+    int i;
+    zr_rune r;
+    unsigned int count = 0;
+    for (i = 0; i < font_count; ++i) {
+        const struct zr_font_bake_data *tmp = &baker->build[i];
+        for (r = 0; r < tmp->range_count; ++r) {
+            count += (unsigned int)(tmp->ranges[r].num_chars +
+                ZR_FONT_BAKE_JOB_SIZE - 1) / ZR_FONT_BAKE_JOB_SIZE;
+        }
+    }
+    return count;
+}
+
+static void
+zr_font_bake_job(void *data, unsigned int index)
+{
+    /* rasterizes one slice of a glyph range. Every glyph has its own packed
+     * rect, so slices write to disjoint parts of the image */
+    int i;
+    zr_rune r;
+    struct zr_font_bake_jobs *jobs = (struct zr_font_bake_jobs*)data;
+    for (i = 0; i < jobs->font_count; ++i) {
+        struct zr_font_bake_data *tmp = &jobs->baker->build[i];
+        int rect_n = 0;
+        for (r = 0; r < tmp->range_count; ++r) {
+            int offset;
+            stbtt_pack_range range;
+            stbtt_pack_context spc;
+            const stbtt_pack_range *src = &tmp->ranges[r];
+            unsigned int slices = (unsigned int)(src->num_chars +
+                ZR_FONT_BAKE_JOB_SIZE - 1) / ZR_FONT_BAKE_JOB_SIZE;
+            if (index >= slices) {
+                index -= slices;
+                rect_n += src->num_chars;
+                continue;
+            }
+
+            /* the pack context is copied since rendering changes its oversampling */
+            offset = (int)index * ZR_FONT_BAKE_JOB_SIZE;
+            range = *src;
+            range.first_unicode_codepoint_in_range += offset;
+            range.num_chars = MIN(src->num_chars - offset, ZR_FONT_BAKE_JOB_SIZE);
+            range.chardata_for_range += offset;
+            spc = jobs->baker->spc;
+            zr_font_bake_render(&spc, tmp, &range, 1, tmp->rects + rect_n + offset,
+                &jobs->config[i]);
+            return;
+        }
     }
 }
 
+void
+zr_font_bake_dispatch(void *image_memory, int width, int height,
+    void *temp, zr_size temp_size, struct zr_font_glyph *glyphs,
+    int glyphs_count, const struct zr_font_config *config, int font_count,
+    zr_convert_dispatch_f dispatch, zr_handle userdata)
+{
+    struct zr_font_bake_jobs jobs;
+
+    ZR_ASSERT(image_memory);
+    ZR_ASSERT(width);
+    ZR_ASSERT(height);
+    ZR_ASSERT(config);
+    ZR_ASSERT(temp);
+    ZR_ASSERT(temp_size);
+    ZR_ASSERT(font_count);
+    ZR_ASSERT(glyphs_count);
+    ZR_ASSERT(dispatch);
+    if (!image_memory || !width || !height || !config || !temp ||
+        !temp_size || !font_count || !glyphs || !glyphs_count || !dispatch)
+        return;
+
+    /* second font pass: render glyph range slices as independent jobs */
+    jobs.baker = zr_font_bake_begin(image_memory, width, height, temp);
+    jobs.config = config;
+    jobs.font_count = font_count;
+    dispatch(userdata, zr_font_bake_job, &jobs,
+        zr_font_bake_job_count(jobs.baker, font_count));
+    stbtt_PackEnd(&jobs.baker->spc);
+    zr_font_bake_glyphs(jobs.baker, width, height, glyphs, config, font_count);
+}
+
 void
 zr_font_bake_custom_data(void *img_memory, int img_width, int img_height,
     struct zr_recti img_dst, const char *texture_data_mask, int tex_width,
@@ -3307,11 +4388,759 @@ zr_font_bake_convert(void *out_memory, int img_width, int img_height,
     for (n = (int)(img_width * img_height); n > 0; n--)
         *dst++ = ((zr_rune)(*src++) << 24) | 0x00FFFFFF;
 }
+/* -------------------------------------------------------------
+ *
+ *                          FONT CACHE
+ *
+ * --------------------------------------------------------------*/
+#define ZR_FONT_CACHE_MAGIC 0x4346525A
+#define ZR_FONT_CACHE_VERSION 3
+#define ZR_FONT_CACHE_ALIGN(x) (((x) + 7) & ~(zr_size)7)
+
+struct zr_font_cache_header {
+    zr_uint magic;
+    /* 'ZRFC' which also rejects caches written with another byte order */
+    zr_uint version;
+    zr_uint identity;
+    /* hash of the TTF files and configurations of all fonts */
+    zr_uint glyph_size;
+    /* size of `struct zr_font_glyph` when the cache was written */
+    zr_uint size;
+    /* total size of the cache in bytes */
+    zr_uint image_width, image_height;
+    zr_uint image_size, image_offset;
+    zr_uint glyph_count, glyph_offset;
+    zr_uint font_count, range_count;
+    struct zr_recti custom;
+};
+
+struct zr_font_cache_font {
+    float height, ascent, descent;
+    float sdf_spread;
+    zr_rune glyph_offset, glyph_count;
+    zr_uint range_offset;
+    /* index of the first range value inside the range array */
+};
+
+zr_uint
+zr_font_cache_identity(const struct zr_font_config *config, int count)
+{
+    int i;
+    zr_hash hash = (zr_hash)count;
+    ZR_ASSERT(config);
+    if (!config) return 0;
+    for (i = 0; i < count; ++i) {
+        const struct zr_font_config *c = &config[i];
+        zr_uint v[8];
+        v[0] = (zr_uint)(int)(c->size * 1000.0f);
+        v[1] = (zr_uint)c->oversample_h;
+        v[2] = (zr_uint)c->oversample_v;
+        v[3] = (zr_uint)c->pixel_snap;
+        v[4] = (zr_uint)c->coord_type;
+        v[5] = (zr_uint)(int)(c->spacing.x * 1000.0f);
+        v[6] = (zr_uint)(int)(c->spacing.y * 1000.0f);
+        v[7] = (zr_uint)(int)(c->sdf_spread * 1000.0f);
+        hash = zr_murmur_hash(v, (int)sizeof(v), hash);
+        if (c->ttf_blob)
+            hash = zr_murmur_hash(c->ttf_blob, (int)c->ttf_size, hash);
+        if (c->range)
+            hash = zr_murmur_hash(c->range, zr_range_count(c->range) * 2 *
+                (int)sizeof(zr_rune), hash);
+    }
+    return hash;
+}
+
+static int
+zr_font_cache_check_ranges(const zr_rune *range, zr_rune glyph_count)
+{
+    /* ranges read from a cache have to be ordered pairs covering exactly the
+     * glyphs of their font. The range array is known to end with 0. */
+    zr_rune total = 0;
+    for (; range[0]; range += 2) {
+        if (range[1] < range[0] || range[1] - range[0] >= glyph_count - total)
+            return zr_false;
+        total += range[1] - range[0] + 1;
+    }
+    return total == glyph_count;
+}
+
+static zr_size
+zr_font_cache_ranges(const struct zr_font_cache *cache)
+{
+    /* number of range values of all fonts including their terminators */
+    int i;
+    zr_size count = 0;
+    for (i = 0; i < cache->font_count; ++i) {
+        const zr_rune *range = cache->fonts[i].ranges;
+        count += (range) ? (zr_size)zr_range_count(range) * 2 + 1: 1;
+    }
+    return count;
+}
+
+static zr_size
+zr_font_cache_layout(const struct zr_font_cache *cache, zr_size *glyph_offset,
+    zr_size *image_offset)
+{
+    zr_size size = sizeof(struct zr_font_cache_header);
+    size += (zr_size)cache->font_count * sizeof(struct zr_font_cache_font);
+    size += zr_font_cache_ranges(cache) * sizeof(zr_rune);
+    *glyph_offset = ZR_FONT_CACHE_ALIGN(size);
+    size = *glyph_offset + (zr_size)cache->glyph_count * sizeof(struct zr_font_glyph);
+    *image_offset = ZR_FONT_CACHE_ALIGN(size);
+    return *image_offset + cache->image_size;
+}
+
+zr_size
+zr_font_cache_size(const struct zr_font_cache *cache)
+{
+    zr_size glyph_offset, image_offset;
+    ZR_ASSERT(cache);
+    if (!cache) return 0;
+    return zr_font_cache_layout(cache, &glyph_offset, &image_offset);
+}
+
+zr_size
+zr_font_cache_store(void *memory, zr_size size, const struct zr_font_cache *cache)
+{
+    int i;
+    zr_size total, glyph_offset, image_offset;
+    zr_rune *ranges;
+    zr_uint range_count = 0;
+    struct zr_font_cache_header *header;
+    struct zr_font_cache_font *fonts;
+
+    ZR_ASSERT(memory);
+    ZR_ASSERT(cache);
+    if (!memory || !cache || !cache->image || !cache->glyphs || !cache->fonts)
+        return 0;
+
+    total = zr_font_cache_layout(cache, &glyph_offset, &image_offset);
+    ZR_ASSERT(size >= total);
+    if (size < total) return 0;
+    zr_zero(memory, total);
+
+    header = (struct zr_font_cache_header*)memory;
+    header->magic = ZR_FONT_CACHE_MAGIC;
+    header->version = ZR_FONT_CACHE_VERSION;
+    header->identity = cache->identity;
+    header->glyph_size = (zr_uint)sizeof(struct zr_font_glyph);
+    header->size = (zr_uint)total;
+    header->image_width = (zr_uint)cache->image_width;
+    header->image_height = (zr_uint)cache->image_height;
+    header->image_size = (zr_uint)cache->image_size;
+    header->image_offset = (zr_uint)image_offset;
+    header->glyph_count = (zr_uint)cache->glyph_count;
+    header->glyph_offset = (zr_uint)glyph_offset;
+    header->font_count = (zr_uint)cache->font_count;
+    header->range_count = (zr_uint)zr_font_cache_ranges(cache);
+    header->custom = cache->custom;
+
+    /* font metrics followed by the ranges of all fonts */
+    fonts = (struct zr_font_cache_font*)(header + 1);
+    ranges = (zr_rune*)(fonts + cache->font_count);
+    for (i = 0; i < cache->font_count; ++i) {
+        const struct zr_baked_font *src = &cache->fonts[i];
+        zr_size n = (src->ranges) ? (zr_size)zr_range_count(src->ranges) * 2: 0;
+        fonts[i].height = src->height;
+        fonts[i].ascent = src->ascent;
+        fonts[i].descent = src->descent;
+        fonts[i].sdf_spread = src->sdf_spread;
+        fonts[i].glyph_offset = src->glyph_offset;
+        fonts[i].glyph_count = src->glyph_count;
+        fonts[i].range_offset = range_count;
+        if (n) zr_memcopy(&ranges[range_count], src->ranges, n * sizeof(zr_rune));
+        range_count += (zr_uint)n + 1;
+    }
+    zr_memcopy(zr_ptr_add(void, memory, glyph_offset), cache->glyphs,
+        (zr_size)cache->glyph_count * sizeof(struct zr_font_glyph));
+    zr_memcopy(zr_ptr_add(void, memory, image_offset), cache->image, cache->image_size);
+    return total;
+}
+
+int
+zr_font_cache_load(struct zr_font_cache *cache, struct zr_baked_font *fonts,
+    int max_fonts, zr_uint identity, void *memory, zr_size size)
+{
+    zr_uint i;
+    zr_size avail;
+    const zr_rune *ranges;
+    const struct zr_font_cache_header *header;
+    const struct zr_font_cache_font *src;
+
+    ZR_ASSERT(cache);
+    ZR_ASSERT(fonts);
+    ZR_ASSERT(memory);
+    if (!cache || !fonts || !memory || max_fonts < 0 || size < sizeof(*header))
+        return zr_false;
+
+    /* only accept caches written by the same version and platform for the
+     * same fonts */
+    header = (const struct zr_font_cache_header*)memory;
+    if (header->magic != ZR_FONT_CACHE_MAGIC ||
+        header->version != ZR_FONT_CACHE_VERSION ||
+        header->identity != identity ||
+        header->glyph_size != sizeof(struct zr_font_glyph) ||
+        header->size > size || header->font_count > (zr_uint)max_fonts)
+        return zr_false;
+
+    /* all sections have to be aligned and inside the cache. Sizes are
+     * compared against the space left so the checks cannot overflow */
+    if (header->glyph_offset < sizeof(*header) || header->glyph_offset > header->size ||
+        header->image_offset > header->size ||
+        ZR_FONT_CACHE_ALIGN(header->glyph_offset) != header->glyph_offset ||
+        ZR_FONT_CACHE_ALIGN(header->image_offset) != header->image_offset ||
+        header->glyph_count > (header->size - header->glyph_offset) / header->glyph_size ||
+        header->image_size > header->size - header->image_offset)
+        return zr_false;
+    if (header->image_height &&
+        header->image_width > header->image_size / header->image_height)
+        return zr_false;
+
+    avail = (zr_size)header->glyph_offset - sizeof(*header);
+    if ((zr_size)header->font_count > avail / sizeof(*src))
+        return zr_false;
+    avail -= (zr_size)header->font_count * sizeof(*src);
+    if (!header->range_count || (zr_size)header->range_count > avail / sizeof(zr_rune))
+        return zr_false;
+
+    src = (const struct zr_font_cache_font*)(header + 1);
+    ranges = (const zr_rune*)(src + header->font_count);
+    if (ranges[header->range_count-1] != 0)
+        return zr_false;
+
+    for (i = 0; i < header->font_count; ++i) {
+        if (src[i].range_offset >= header->range_count ||
+            src[i].glyph_count > header->glyph_count ||
+            src[i].glyph_offset > header->glyph_count - src[i].glyph_count ||
+            !zr_font_cache_check_ranges(&ranges[src[i].range_offset], src[i].glyph_count))
+            return zr_false;
+        fonts[i].height = src[i].height;
+        fonts[i].ascent = src[i].ascent;
+        fonts[i].descent = src[i].descent;
+        fonts[i].sdf_spread = src[i].sdf_spread;
+        fonts[i].glyph_offset = src[i].glyph_offset;
+        fonts[i].glyph_count = src[i].glyph_count;
+        fonts[i].ranges = &ranges[src[i].range_offset];
+    }
+
+    cache->image = zr_ptr_add(void, memory, header->image_offset);
+    cache->image_width = (int)header->image_width;
+    cache->image_height = (int)header->image_height;
+    cache->image_size = header->image_size;
+    cache->custom = header->custom;
+    cache->glyphs = zr_ptr_add(struct zr_font_glyph, memory, header->glyph_offset);
+    cache->glyph_count = (int)header->glyph_count;
+    cache->fonts = fonts;
+    cache->font_count = (int)header->font_count;
+    cache->identity = header->identity;
+    return zr_true;
+}
+
+/* -------------------------------------------------------------
+ *
+ *                          DYNAMIC ATLAS
+ *
+ * --------------------------------------------------------------*/
+#define ZR_FONT_ATLAS_PAGES 4
+
+struct zr_font_atlas_glyph {
+    struct zr_font_glyph glyph;
+    int page;
+    /* page holding the glyph image, -1 if it did not fit or -2 if unused */
+    int next;
+    /* next glyph inside the same page or free list */
+    unsigned int frame;
+    /* frame the glyph was last placed in */
+};
+
+struct zr_font_atlas_page {
+    stbrp_context pack;
+    stbrp_node *nodes;
+    int y, height;
+    /* image rows covered by the page */
+    int glyphs;
+    /* first glyph inside the page or -1 */
+    unsigned int frame;
+    /* frame the page was last drawn from */
+};
+
+struct zr_font_atlas {
+    stbtt_fontinfo info;
+    struct zr_font_config config;
+    float scale, ascent;
+    zr_byte *pixels;
+    int width, height;
+    struct zr_recti dirty;
+    /* image area changed since the last `zr_font_dynamic_update` */
+    unsigned int frame;
+    int current;
+    /* page the last glyph was packed into */
+    struct zr_font_atlas_page pages[ZR_FONT_ATLAS_PAGES];
+    struct zr_font_atlas_glyph *glyphs;
+    int capacity;
+    int free;
+    int *table;
+    /* open addressing codepoint to glyph hash table */
+    zr_uint table_mask;
+    struct zr_font_glyph fallback;
+    struct zr_font_glyph scratch;
+    /* glyph returned if all glyph slots are in use */
+};
+
+static const zr_size zr_atlas_align = ZR_ALIGNOF(struct zr_font_atlas);
+static const zr_size zr_atlas_glyph_align = ZR_ALIGNOF(struct zr_font_atlas_glyph);
+static const zr_size zr_node_align = ZR_ALIGNOF(stbrp_node);
+static const zr_size zr_int_align = ZR_ALIGNOF(int);
+
+static int
+zr_font_atlas_capacity(int width, int height, float size)
+{
+    /* number of glyphs that fit into the image if each covers half of
+     * a square of the font size */
+    int area = (int)(size * size * 0.5f);
+    return MAX((width * height) / MAX(area, 1), 64);
+}
+
+static struct zr_font_atlas*
+zr_font_atlas_layout(void *memory, int width, int height, float size)
+{
+    int i;
+    struct zr_font_atlas *atlas;
+    if (!memory) return 0;
+    /* setup atlas inside a memory block */
+    atlas = (struct zr_font_atlas*)ZR_ALIGN_PTR(memory, zr_atlas_align);
+    atlas->capacity = zr_font_atlas_capacity(width, height, size);
+    atlas->table_mask = zr_round_up_pow2((zr_uint)atlas->capacity * 2) - 1;
+    atlas->glyphs = (struct zr_font_atlas_glyph*)ZR_ALIGN_PTR((atlas + 1), zr_atlas_glyph_align);
+    atlas->pages[0].nodes = (stbrp_node*)ZR_ALIGN_PTR((atlas->glyphs + atlas->capacity), zr_node_align);
+    for (i = 1; i < ZR_FONT_ATLAS_PAGES; ++i)
+        atlas->pages[i].nodes = atlas->pages[i-1].nodes + width;
+    atlas->table = (int*)ZR_ALIGN_PTR((atlas->pages[ZR_FONT_ATLAS_PAGES-1].nodes + width), zr_int_align);
+    atlas->pixels = (zr_byte*)(atlas->table + atlas->table_mask + 1);
+    atlas->width = width;
+    atlas->height = height;
+    return atlas;
+}
+
+void
+zr_font_dynamic_memory(zr_size *memory, int width, int height,
+    const struct zr_font_config *config)
+{
+    int capacity;
+    zr_size table;
+    ZR_ASSERT(memory);
+    ZR_ASSERT(config);
+    if (!memory) return;
+    *memory = 0;
+    if (!config || width <= 0 || height <= 0) return;
+
+    capacity = zr_font_atlas_capacity(width, height, config->size);
+    table = (zr_size)zr_round_up_pow2((zr_uint)capacity * 2);
+    *memory = sizeof(struct zr_font_atlas);
+    *memory += (zr_size)capacity * sizeof(struct zr_font_atlas_glyph);
+    *memory += (zr_size)(ZR_FONT_ATLAS_PAGES * width) * sizeof(stbrp_node);
+    *memory += table * sizeof(int);
+    *memory += (zr_size)width * (zr_size)height;
+    *memory += zr_atlas_align + zr_atlas_glyph_align + zr_node_align + zr_int_align;
+}
+
+static void
+zr_font_atlas_invalidate(struct zr_font_atlas *atlas, int x, int y, int w, int h)
+{
+    struct zr_recti *d = &atlas->dirty;
+    if (w <= 0 || h <= 0) return;
+    if (d->w && d->h) {
+        int x1 = MAX(d->x + d->w, x + w);
+        int y1 = MAX(d->y + d->h, y + h);
+        x = MIN(d->x, x);
+        y = MIN(d->y, y);
+        w = x1 - x;
+        h = y1 - y;
+    }
+    d->x = (short)x; d->y = (short)y;
+    d->w = (short)w; d->h = (short)h;
+}
+
+static void
+zr_font_atlas_metrics(const struct zr_font_atlas *atlas, int index,
+    struct zr_font_glyph *glyph, int *w, int *h)
+{
+    /* fills the glyph position and advance the same way `zr_font_bake` does */
+    int advance, bearing, x0, y0, x1, y1;
+    const struct zr_font_config *cfg = &atlas->config;
+    stbtt_GetGlyphHMetrics(&atlas->info, index, &advance, &bearing);
+    stbtt_GetGlyphBitmapBox(&atlas->info, index, atlas->scale, atlas->scale,
+        &x0, &y0, &x1, &y1);
+
+    glyph->x0 = (float)x0;
+    glyph->y0 = (float)y0 + atlas->ascent + 0.5f;
+    glyph->x1 = (float)x1;
+    glyph->y1 = (float)y1 + atlas->ascent + 0.5f;
+    glyph->u0 = glyph->v0 = glyph->u1 = glyph->v1 = 0;
+    glyph->xadvance = ((float)advance * atlas->scale + cfg->spacing.x);
+    if (cfg->pixel_snap)
+        glyph->xadvance = (float)(int)(glyph->xadvance + 0.5f);
+    *w = x1 - x0;
+    *h = y1 - y0;
+}
+
+static void
+zr_font_atlas_render(struct zr_font_atlas *atlas, int index,
+    struct zr_font_glyph *glyph, int x, int y, int w, int h)
+{
+    zr_byte *dst = atlas->pixels + x + y * atlas->width;
+    stbtt_MakeGlyphBitmap(&atlas->info, dst, w, h, atlas->width,
+        atlas->scale, atlas->scale, index);
+    zr_font_atlas_invalidate(atlas, x, y, w, h);
+
+    glyph->u0 = (float)x;
+    glyph->v0 = (float)y;
+    glyph->u1 = (float)(x + w);
+    glyph->v1 = (float)(y + h);
+    if (atlas->config.coord_type == ZR_COORD_UV) {
+        glyph->u0 /= (float)atlas->width;
+        glyph->v0 /= (float)atlas->height;
+        glyph->u1 /= (float)atlas->width;
+        glyph->v1 /= (float)atlas->height;
+    }
+}
+
+static void
+zr_font_atlas_rehash(struct zr_font_atlas *atlas)
+{
+    int i;
+    for (i = 0; i <= (int)atlas->table_mask; ++i)
+        atlas->table[i] = -1;
+    for (i = 0; i < atlas->capacity; ++i) {
+        zr_uint slot;
+        if (atlas->glyphs[i].page == -2) continue;
+        slot = (atlas->glyphs[i].glyph.codepoint * 2654435761u) & atlas->table_mask;
+        while (atlas->table[slot] >= 0)
+            slot = (slot + 1) & atlas->table_mask;
+        atlas->table[slot] = i;
+    }
+}
+
+static int
+zr_font_atlas_evict(struct zr_font_atlas *atlas)
+{
+    /* clears the page drawn from least recently. Pages drawn from in the
+     * current frame are still referenced by vertexes and are never cleared */
+    int i, iter;
+    int page = -1;
+    struct zr_font_atlas_page *p;
+    for (i = 0; i < ZR_FONT_ATLAS_PAGES; ++i) {
+        const struct zr_font_atlas_page *candidate = &atlas->pages[i];
+        if (candidate->frame == atlas->frame) continue;
+        if (page < 0 || (atlas->frame - candidate->frame) >
+            (atlas->frame - atlas->pages[page].frame))
+            page = i;
+    }
+    if (page < 0) return -1;
+
+    p = &atlas->pages[page];
+    iter = p->glyphs;
+    while (iter >= 0) {
+        struct zr_font_atlas_glyph *g = &atlas->glyphs[iter];
+        int next = g->next;
+        g->page = -2;
+        g->next = atlas->free;
+        atlas->free = iter;
+        iter = next;
+    }
+    p->glyphs = -1;
+    zr_zero(atlas->pixels + p->y * atlas->width, (zr_size)(p->height * atlas->width));
+    zr_font_atlas_invalidate(atlas, 0, p->y, atlas->width, p->height);
+    stbrp_init_target(&p->pack, atlas->width, p->height, p->nodes, atlas->width);
+    zr_font_atlas_rehash(atlas);
+    atlas->current = page;
+    return page;
+}
+
+static int
+zr_font_atlas_alloc(struct zr_font_atlas *atlas)
+{
+    int slot;
+    if (atlas->free < 0) {
+        /* release glyphs without image that were not looked up this frame */
+        int i, released = 0;
+        for (i = 0; i < atlas->capacity; ++i) {
+            struct zr_font_atlas_glyph *g = &atlas->glyphs[i];
+            if (g->page != -1 || g->frame == atlas->frame) continue;
+            g->page = -2;
+            g->next = atlas->free;
+            atlas->free = i;
+            released++;
+        }
+        if (released)
+            zr_font_atlas_rehash(atlas);
+    }
+    if (atlas->free < 0)
+        zr_font_atlas_evict(atlas);
+    if (atlas->free < 0)
+        return -1;
+
+    slot = atlas->free;
+    atlas->free = atlas->glyphs[slot].next;
+    atlas->glyphs[slot].page = -1;
+    atlas->glyphs[slot].next = -1;
+    return slot;
+}
+
+static void
+zr_font_atlas_place(struct zr_font_atlas *atlas, int slot, int index)
+{
+    /* packs the glyph image into the first page with enough space left.
+     * If every page is full the least recently drawn page is cleared */
+    int i, w, h, page = -1;
+    stbrp_rect rect;
+    struct zr_font_atlas_glyph *g = &atlas->glyphs[slot];
+
+    g->frame = atlas->frame;
+    zr_font_atlas_metrics(atlas, index, &g->glyph, &w, &h);
+    if (w > 0 && h > 0) {
+        zr_zero(&rect, sizeof(rect));
+        rect.w = (stbrp_coord)(w + 1);
+        rect.h = (stbrp_coord)(h + 1);
+        for (i = 0; i < ZR_FONT_ATLAS_PAGES && page < 0; ++i) {
+            int p = (atlas->current + i) % ZR_FONT_ATLAS_PAGES;
+            stbrp_pack_rects(&atlas->pages[p].pack, &rect, 1);
+            if (rect.was_packed) page = p;
+        }
+        if (page < 0) {
+            page = zr_font_atlas_evict(atlas);
+            if (page >= 0) {
+                stbrp_pack_rects(&atlas->pages[page].pack, &rect, 1);
+                if (!rect.was_packed) page = -1;
+            }
+        }
+        if (page < 0) {
+            /* no space left in this frame so only the advance is valid */
+            g->glyph.x1 = g->glyph.x0;
+            g->glyph.y1 = g->glyph.y0;
+            return;
+        }
+        zr_font_atlas_render(atlas, index, &g->glyph, rect.x,
+            atlas->pages[page].y + rect.y, w, h);
+    } else page = atlas->current;
+
+    g->page = page;
+    g->next = atlas->pages[page].glyphs;
+    atlas->pages[page].glyphs = slot;
+    atlas->pages[page].frame = atlas->frame;
+    atlas->current = page;
+}
+
+static const struct zr_font_glyph*
+zr_font_atlas_find(struct zr_font *font, zr_rune unicode)
+{
+    int slot, index;
+    zr_uint hash;
+    struct zr_font_atlas_glyph *g;
+    struct zr_font_atlas *atlas = font->dynamic;
+
+    hash = (unicode * 2654435761u) & atlas->table_mask;
+    while ((slot = atlas->table[hash]) >= 0) {
+        g = &atlas->glyphs[slot];
+        if (g->glyph.codepoint == unicode) {
+            if (g->page >= 0)
+                atlas->pages[g->page].frame = atlas->frame;
+            else if (g->frame != atlas->frame)
+                zr_font_atlas_place(atlas, slot,
+                    stbtt_FindGlyphIndex(&atlas->info, (int)unicode));
+            return &g->glyph;
+        }
+        hash = (hash + 1) & atlas->table_mask;
+    }
+
+    /* first lookup of the glyph */
+    if (font->ranges) {
+        int i, count = zr_range_count(font->ranges);
+        for (i = 0; i < count; ++i) {
+            if (unicode >= font->ranges[i*2+0] && unicode <= font->ranges[i*2+1])
+                break;
+        }
+        if (i == count) return font->fallback;
+    }
+    /* like baked ranges, missing codepoints inside a range are drawn with
+     * the font's missing glyph, all others with the fallback glyph */
+    index = stbtt_FindGlyphIndex(&atlas->info, (int)unicode);
+    if (!index && !font->ranges) return font->fallback;
+    slot = zr_font_atlas_alloc(atlas);
+    if (slot < 0) {
+        /* every glyph is in use this frame so return the advance without
+         * image, which is only valid until the next lookup */
+        int w, h;
+        zr_font_atlas_metrics(atlas, index, &atlas->scratch, &w, &h);
+        atlas->scratch.codepoint = unicode;
+        atlas->scratch.x1 = atlas->scratch.x0;
+        atlas->scratch.y1 = atlas->scratch.y0;
+        return &atlas->scratch;
+    }
+
+    g = &atlas->glyphs[slot];
+    g->glyph.codepoint = unicode;
+    hash = (unicode * 2654435761u) & atlas->table_mask;
+    while (atlas->table[hash] >= 0)
+        hash = (hash + 1) & atlas->table_mask;
+    atlas->table[hash] = slot;
+    zr_font_atlas_place(atlas, slot, index);
+    return &g->glyph;
+}
+
+int
+zr_font_init_dynamic(struct zr_font *font, float pixel_height,
+    zr_rune fallback_codepoint, struct zr_recti *custom, void *memory,
+    zr_size size, int width, int height, const struct zr_font_config *config,
+    zr_handle handle)
+{
+    int i, w, h, index;
+    int top = 0, x = 0;
+    int page_height;
+    zr_size needed;
+    struct zr_font_atlas *atlas;
+    int ascent, descent, line_gap;
+
+    ZR_ASSERT(font);
+    ZR_ASSERT(memory);
+    ZR_ASSERT(config);
+    if (!font || !memory || !config || !config->ttf_blob)
+        return zr_false;
+
+    zr_font_dynamic_memory(&needed, width, height, config);
+    ZR_ASSERT(size >= needed);
+    if (!needed || size < needed) return zr_false;
+    zr_zero(memory, needed);
+    atlas = zr_font_atlas_layout(memory, width, height, config->size);
+    if (!stbtt_InitFont(&atlas->info, (const unsigned char*)config->ttf_blob, 0))
+        return zr_false;
+
+    atlas->config = *config;
+    atlas->scale = stbtt_ScaleForPixelHeight(&atlas->info, config->size);
+    stbtt_GetFontVMetrics(&atlas->info, &ascent, &descent, &line_gap);
+    atlas->ascent = (float)ascent * atlas->scale;
+
+    /* custom space and fallback glyph stay in a strip above all pages */
+    if (custom) {
+        custom->x = 0;
+        custom->y = 0;
+        custom->w = (short)((custom->w * 2) + 1);
+        custom->h = (short)(custom->h + 1);
+        x = custom->w;
+        top = custom->h;
+    }
+    index = stbtt_FindGlyphIndex(&atlas->info, (int)fallback_codepoint);
+    zr_font_atlas_metrics(atlas, index, &atlas->fallback, &w, &h);
+    atlas->fallback.codepoint = fallback_codepoint;
+    if (x + w > width) return zr_false;
+    if (w > 0 && h > 0)
+        zr_font_atlas_render(atlas, index, &atlas->fallback, x, 0, w, h);
+    top = MAX(top, h + 1);
+
+    page_height = (height - top) / ZR_FONT_ATLAS_PAGES;
+    if (page_height <= 0) return zr_false;
+    for (i = 0; i < ZR_FONT_ATLAS_PAGES; ++i) {
+        struct zr_font_atlas_page *p = &atlas->pages[i];
+        p->y = top + i * page_height;
+        p->height = page_height;
+        p->glyphs = -1;
+        stbrp_init_target(&p->pack, width, page_height, p->nodes, width);
+    }
+    for (i = 0; i < atlas->capacity; ++i) {
+        atlas->glyphs[i].page = -2;
+        atlas->glyphs[i].next = i + 1;
+    }
+    atlas->glyphs[atlas->capacity-1].next = -1;
+    atlas->free = 0;
+    atlas->frame = 1;
+    zr_font_atlas_rehash(atlas);
+    zr_font_atlas_invalidate(atlas, 0, 0, width, height);
+
+    zr_zero(font, sizeof(*font));
+    font->ascent = atlas->ascent;
+    font->descent = (float)descent * atlas->scale;
+    font->size = config->size;
+    font->scale = (float)pixel_height / (float)font->size;
+    font->ranges = config->range;
+    font->atlas = handle;
+    font->fallback_codepoint = fallback_codepoint;
+    font->fallback = &atlas->fallback;
+    font->dynamic = atlas;
+    for (i = 0; i < ZR_FONT_PAGE_COUNT; ++i)
+        font->pages[i].type = ZR_FONT_PAGE_EMPTY;
+    return zr_true;
+}
+
+void*
+zr_font_dynamic_image(struct zr_font *font, int *width, int *height)
+{
+    ZR_ASSERT(font);
+    ZR_ASSERT(font->dynamic);
+    if (!font || !font->dynamic) return 0;
+    if (width) *width = font->dynamic->width;
+    if (height) *height = font->dynamic->height;
+    return font->dynamic->pixels;
+}
+
+int
+zr_font_dynamic_update(struct zr_font *font, struct zr_recti *dirty)
+{
+    struct zr_font_atlas *atlas;
+    ZR_ASSERT(font);
+    ZR_ASSERT(dirty);
+    if (!font || !font->dynamic || !dirty)
+        return zr_false;
+
+    atlas = font->dynamic;
+    atlas->frame++;
+    if (!atlas->dirty.w || !atlas->dirty.h)
+        return zr_false;
+    *dirty = atlas->dirty;
+    zr_zero(&atlas->dirty, sizeof(atlas->dirty));
+    return zr_true;
+}
+
 /* -------------------------------------------------------------
  *
  *                          FONT
  *
  * --------------------------------------------------------------*/
+static void
+zr_font_build_pages(struct zr_font *font)
+{
+    int i = 0;
+    int count;
+    int total_glyphs = 0;
+    ZR_ASSERT(font);
+    ZR_ASSERT(font->ranges);
+
+    /* Every page covers 256 codepoints. A page touched by exactly one glyph
+     * range stores the glyph index of its first codepoint, so a lookup is
+     * just a bounds check and an indexed load. Pages touched by more than one
+     * range fall back to searching all ranges. */
+    for (i = 0; i < ZR_FONT_PAGE_COUNT; ++i)
+        font->pages[i].type = ZR_FONT_PAGE_EMPTY;
+
+    count = zr_range_count(font->ranges);
+    for (i = 0; i < count; ++i) {
+        zr_rune p;
+        zr_rune f = font->ranges[(i*2)+0];
+        zr_rune t = font->ranges[(i*2)+1];
+        for (p = (f >> 8); p <= (t >> 8) && p < ZR_FONT_PAGE_COUNT; ++p) {
+            struct zr_font_page *page = &font->pages[p];
+            if (page->type != ZR_FONT_PAGE_EMPTY) {
+                page->type = ZR_FONT_PAGE_SEARCH;
+                continue;
+            }
+            page->type = ZR_FONT_PAGE_DIRECT;
+            page->first = (zr_byte)((p == (f >> 8)) ? (f & 0xFF) : 0x00);
+            page->last = (zr_byte)((p == (t >> 8)) ? (t & 0xFF) : 0xFF);
+            page->offset = total_glyphs + (int)(p << 8) - (int)f;
+        }
+        total_glyphs += (int)((t - f) + 1);
+    }
+}
+
 void
 zr_font_init(struct zr_font *font, float pixel_height,
     zr_rune fallback_codepoint, struct zr_font_glyph *glyphs,
@@ -3332,7 +5161,9 @@ zr_font_init(struct zr_font *font, float pixel_height,
     font->glyph_count = baked_font->glyph_count;
     font->ranges = baked_font->ranges;
     font->atlas = atlas;
+    font->sdf_spread = baked_font->sdf_spread;
     font->fallback_codepoint = fallback_codepoint;
+    zr_font_build_pages(font);
     font->fallback = zr_font_find_glyph(font, fallback_codepoint);
 }
 
@@ -3345,7 +5176,22 @@ zr_font_find_glyph(struct zr_font *font, zr_rune unicode)
     const struct zr_font_glyph *glyph = 0;
     ZR_ASSERT(font);
 
+    if (font->dynamic)
+        return zr_font_atlas_find(font, unicode);
     glyph = font->fallback;
+    if ((unicode >> 8) < ZR_FONT_PAGE_COUNT) {
+        /* basic multilingual plane glyph lookup table */
+        const struct zr_font_page *page = &font->pages[unicode >> 8];
+        const zr_byte index = (zr_byte)(unicode & 0xFF);
+        if (page->type == ZR_FONT_PAGE_DIRECT) {
+            if (index < page->first || index > page->last)
+                return glyph;
+            return &font->glyphs[page->offset + (int)index];
+        } else if (page->type == ZR_FONT_PAGE_EMPTY)
+            return glyph;
+    }
+
+    /* linear search over all glyph ranges */
     count = zr_range_count(font->ranges);
     for (i = 0; i < count; ++i) {
         int diff;
@@ -3359,6 +5205,23 @@ zr_font_find_glyph(struct zr_font *font, zr_rune unicode)
     return glyph;
 }
 
+static float
+zr_font_glyph_advance(zr_handle handle, float height, zr_rune codepoint)
+{
+    float scale;
+    const struct zr_font_glyph *glyph;
+    struct zr_font *font = (struct zr_font*)handle.ptr;
+    ZR_ASSERT(font);
+    if (!font || codepoint == ZR_UTF_INVALID)
+        return 0;
+
+    /* truncated the same way as in `zr_font_text_width` so advances add up
+     * to exactly the text width */
+    scale = height/font->size;
+    glyph = zr_font_find_glyph(font, codepoint);
+    return (float)(zr_size)(glyph->xadvance * scale);
+}
+
 static zr_size
 zr_font_text_width(zr_handle handle, float height, const char *text, zr_size len)
 {
@@ -3419,10 +5282,12 @@ zr_font_ref(struct zr_font *font)
     zr_zero(&user_font, sizeof(user_font));
     user_font.height = font->size * font->scale;
     user_font.width = zr_font_text_width;
+    user_font.advance = zr_font_glyph_advance;
     user_font.userdata.ptr = font;
 #if ZR_COMPILE_WITH_VERTEX_BUFFER
     user_font.query = zr_font_query_font_glyph;
     user_font.texture = font->atlas;
+    user_font.dynamic = (font->dynamic != 0);
 #endif
     return user_font;
 }
@@ -3820,7 +5685,7 @@ zr_widget_text(struct zr_command_buffer *o, struct zr_rect b,
     label.y = b.y + t->padding.y;
     label.h = b.h - 2 * t->padding.y;
 
-    text_width = f->width(f->userdata, f->height, (const char*)string, len);
+    text_width = zr_user_font_text_width(o->widths, f, string, len);
     text_width += (zr_size)(2 * t->padding.x);
 
     if (a == ZR_TEXT_LEFT) {
@@ -4837,7 +6702,7 @@ zr_widget_edit_field(struct zr_command_buffer *out, struct zr_rect r,
     {
         /* text management */
         struct zr_rect label;
-        zr_size cursor_w = font->width(font->userdata,font->height,"X", 1);
+        zr_size cursor_w = zr_user_font_text_width(out->widths, font, "X", 1);
         zr_size text_len = len;
         zr_size glyph_off = 0;
         zr_size glyph_cnt = 0;
@@ -5011,7 +6876,7 @@ zr_widget_edit_box(struct zr_command_buffer *out, struct zr_rect r,
 
     buffer = zr_edit_box_get(box);
     len = zr_edit_box_len_char(box);
-    cursor_w = font->width(font->userdata,font->height,(const char*)"X", 1);
+    cursor_w = zr_user_font_text_width(out->widths, font, "X", 1);
 
     {
         /* calulate total number of needed rows */
@@ -5586,7 +7451,7 @@ zr_do_property(enum zr_widget_status *ws,
 
     /* text label */
     name_len = zr_strsiz(name);
-    size = f->width(f->userdata, f->height, name, name_len);
+    size = zr_user_font_text_width(out->widths, f, name, name_len);
     label.x = left.x + left.w + p->padding.x;
     label.w = (float)size + 2 * p->padding.x;
     label.y = property.y + p->border_size;
@@ -5606,7 +7471,7 @@ zr_do_property(enum zr_widget_status *ws,
     } else {
         zr_ftos(string, property_value);
         num_len = zr_string_float_limit(string, ZR_MAX_FLOAT_PRECISION);
-        size = f->width(f->userdata, f->height, string, num_len);
+        size = zr_user_font_text_width(out->widths, f, string, num_len);
         dst = string;
         length = &num_len;
     }
@@ -5978,17 +7843,17 @@ zr_input_is_key_down(const struct zr_input *i, enum zr_keys key)
     COLOR(TAB_HEADER,               40, 40, 40, 255)\
     COLOR(SCALER,                   100, 100, 100, 255)
 
-static const char *zr_style_color_names[] = {
+static const char *const zr_style_color_names[] = {
     #define COLOR(a,b,c,d,e) #a,
         ZR_STYLE_COLOR_MAP(COLOR)
     #undef COLOR
 };
-static const char *zr_style_rounding_names[] = {
+static const char *const zr_style_rounding_names[] = {
     #define ROUNDING(a,b) #a,
         ZR_STYLE_ROUNDING_MAP(ROUNDING)
     #undef ROUNDING
 };
-static const char *zr_style_property_names[] = {
+static const char *const zr_style_property_names[] = {
     #define PROPERTY(a,b,c) #a,
         ZR_STYLE_PROPERTY_MAP(PROPERTY)
     #undef PROPERTY
@@ -6349,6 +8214,7 @@ zr_pool_alloc(struct zr_pool *pool)
  * ===============================================================*/
 static void zr_free_table(struct zr_context*, struct zr_table*);
 static void zr_remove_table(struct zr_window*, struct zr_table*);
+static void zr_value_index_free(struct zr_context*, struct zr_window*);
 
 static void*
 zr_create_window(struct zr_context *ctx)
@@ -6371,9 +8237,81 @@ zr_create_window(struct zr_context *ctx)
         ZR_ASSERT(win);
         if (!win) return 0;
     }
-    zr_zero(win, sizeof(union zr_page_data));
-    win->seq = ctx->seq;
-    return win;
+    zr_zero(win, sizeof(union zr_page_data));
+    win->seq = ctx->seq;
+    return win;
+}
+
+static void
+zr_index_put(struct zr_window **index, unsigned int size, struct zr_window *win)
+{
+    unsigned int slot = win->name & (size-1);
+    while (index[slot])
+        slot = (slot + 1) & (size-1);
+    index[slot] = win;
+}
+
+static int
+zr_index_grow(struct zr_context *ctx)
+{
+    /* allocates a bigger window hash table and reinserts all windows */
+    unsigned int size = ZR_WINDOW_INDEX_MIN_SIZE;
+    struct zr_window **index;
+    struct zr_window *iter;
+    const struct zr_allocator *alloc = &ctx->memory.pool;
+
+    while (size < (ctx->count + 1) * 2)
+        size *= 2;
+    index = (struct zr_window**)alloc->alloc(alloc->userdata, size * sizeof(*index));
+    if (index) {
+        zr_zero(index, size * sizeof(*index));
+        for (iter = ctx->begin; iter; iter = iter->next)
+            zr_index_put(index, size, iter);
+    }
+    if (ctx->index)
+        alloc->free(alloc->userdata, ctx->index);
+    ctx->index = index;
+    ctx->index_size = (index) ? size: 0;
+    return index != 0;
+}
+
+static void
+zr_index_insert(struct zr_context *ctx, struct zr_window *win)
+{
+    /* windows are only indexed if the context can allocate memory. Otherwise
+     * or if allocation fails lookup falls back to walking the window list */
+    if (ctx->memory.type != ZR_BUFFER_DYNAMIC || !ctx->memory.pool.alloc)
+        return;
+    if ((ctx->count + 1) * 2 > ctx->index_size && !zr_index_grow(ctx))
+        return;
+    zr_index_put(ctx->index, ctx->index_size, win);
+}
+
+static void
+zr_index_remove(struct zr_context *ctx, struct zr_window *win)
+{
+    /* linear probing deletion which moves following entries back into the
+     * freed slot instead of leaving tombstones */
+    unsigned int slot, next, mask;
+    if (!ctx->index) return;
+    mask = ctx->index_size - 1;
+    slot = win->name & mask;
+    while (ctx->index[slot] != win) {
+        if (!ctx->index[slot]) return;
+        slot = (slot + 1) & mask;
+    }
+
+    ctx->index[slot] = 0;
+    next = (slot + 1) & mask;
+    while (ctx->index[next]) {
+        const unsigned int home = ctx->index[next]->name & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            ctx->index[slot] = ctx->index[next];
+            ctx->index[next] = 0;
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
 }
 
 static void
@@ -6382,6 +8320,7 @@ zr_free_window(struct zr_context *ctx, struct zr_window *win)
     /* unlink windows from list */
     struct zr_table *n, *it = win->tables;
 
+    zr_index_remove(ctx, win);
     if (win == ctx->begin) {
         ctx->begin = win->next;
         if (win->next)
@@ -6392,9 +8331,9 @@ zr_free_window(struct zr_context *ctx, struct zr_window *win)
             ctx->end->next = 0;
     } else {
         if (win->next)
-            win->next->prev = win->next;
+            win->next->prev = win->prev;
         if (win->prev)
-            win->prev->next = win->prev;
+            win->prev->next = win->next;
     }
     if (win->popup.win) {
         zr_free_window(ctx, win->popup.win);
@@ -6410,11 +8349,10 @@ zr_free_window(struct zr_context *ctx, struct zr_window *win)
         if (it->seq != ctx->seq) {
             zr_remove_table(win, it);
             zr_free_table(ctx, it);
-            if (it == win->tables)
-                win->tables = n;
         }
         it = n;
     }
+    zr_value_index_free(ctx, win);
 
     /* link windows into freelist */
     if (!ctx->freelist) {
@@ -6429,6 +8367,17 @@ static struct zr_window*
 zr_find_window(struct zr_context *ctx, zr_hash hash)
 {
     struct zr_window *iter;
+    if (ctx->index) {
+        const unsigned int mask = ctx->index_size - 1;
+        unsigned int slot = hash & mask;
+        while (ctx->index[slot]) {
+            if (ctx->index[slot]->name == hash)
+                return ctx->index[slot];
+            slot = (slot + 1) & mask;
+        }
+        return 0;
+    }
+
     iter = ctx->begin;
     while (iter) {
         if (iter->name == hash)
@@ -6446,6 +8395,7 @@ zr_insert_window(struct zr_context *ctx, struct zr_window *win)
     ZR_ASSERT(win);
     if (!win || !ctx) return;
 
+    zr_index_insert(ctx, win);
     if (!ctx->begin) {
         win->next = 0;
         win->prev = 0;
@@ -6476,9 +8426,36 @@ zr_start(struct zr_context *ctx, struct zr_window *win)
 }
 
 
+static zr_hash
+zr_window_input_hash(const struct zr_context *ctx, const struct zr_window *win)
+{
+    /* hashes everything that can change the drawing output of a cached window
+     * from the outside. Mouse and keyboard input only count if the window
+     * can actually react to them. */
+    zr_hash hash;
+    zr_flags flags;
+    const struct zr_input *in = &ctx->input;
+    int active = (win == ctx->active);
+
+    flags = win->flags & ~(zr_flags)(ZR_WINDOW_RETAINED|ZR_WINDOW_DIRTY);
+    hash = zr_murmur_hash(&win->bounds, (int)sizeof(win->bounds), ZR_WINDOW_CACHED);
+    hash = zr_murmur_hash(&flags, (int)sizeof(flags), hash);
+    hash = zr_murmur_hash(&win->scrollbar, (int)sizeof(win->scrollbar), hash);
+    hash = zr_murmur_hash(&active, (int)sizeof(active), hash);
+    if (zr_input_is_mouse_hovering_rect(in, win->bounds) ||
+        zr_input_is_mouse_prev_hovering_rect(in, win->bounds))
+        hash = zr_murmur_hash(&in->mouse, (int)sizeof(in->mouse), hash);
+    if (!(win->flags & ZR_WINDOW_ROM)) {
+        hash = zr_murmur_hash(in->keyboard.keys, (int)sizeof(in->keyboard.keys), hash);
+        hash = zr_murmur_hash(in->keyboard.text, (int)in->keyboard.text_len, hash);
+    }
+    return hash;
+}
+
 static void
 zr_remove_window(struct zr_context *ctx, struct zr_window *win)
 {
+    zr_index_remove(ctx, win);
     if (win->prev)
         win->prev->next = win->next;
     if (win->next)
@@ -6499,7 +8476,13 @@ zr_create_table(struct zr_context *ctx)
 
 static void
 zr_free_table(struct zr_context *ctx, struct zr_table *tbl)
-{zr_free_window(ctx, (struct zr_window*)tbl);}
+{
+    /* tables share the window pool so they go directly onto the freelist */
+    struct zr_window *page = (struct zr_window*)(void*)tbl;
+    zr_zero(page, sizeof(union zr_page_data));
+    page->next = ctx->freelist;
+    ctx->freelist = page;
+}
 
 static void
 zr_push_table(struct zr_window *win, struct zr_table *tbl)
@@ -6523,8 +8506,12 @@ zr_push_table(struct zr_window *win, struct zr_table *tbl)
 static void
 zr_remove_table(struct zr_window *win, struct zr_table *tbl)
 {
-    if (win->tables == tbl)
+    if (win->tables == tbl) {
+        /* all tables behind the first one are full */
         win->tables = tbl->next;
+        win->table_size = (win->tables) ? ZR_VALUE_PAGE_CAPACITY: 0;
+    }
+    win->table_count--;
     if (tbl->next)
         tbl->next->prev = tbl->prev;
     if (tbl->prev)
@@ -6533,11 +8520,85 @@ zr_remove_table(struct zr_window *win, struct zr_table *tbl)
     tbl->prev = 0;
 }
 
+static void
+zr_value_index_free(struct zr_context *ctx, struct zr_window *win)
+{
+    if (win->values)
+        ctx->memory.pool.free(ctx->memory.pool.userdata, win->values);
+    win->values = 0;
+    win->value_size = 0;
+    win->value_count = 0;
+}
+
+static void
+zr_value_index_put(struct zr_window *win, zr_hash key, struct zr_table *tbl,
+    unsigned int index)
+{
+    const unsigned int mask = win->value_size - 1;
+    unsigned int slot = key & mask;
+    while (win->values[slot].table)
+        slot = (slot + 1) & mask;
+    win->values[slot].key = key;
+    win->values[slot].index = index;
+    win->values[slot].table = tbl;
+    win->value_count++;
+}
+
+static void
+zr_value_index_build(struct zr_context *ctx, struct zr_window *win)
+{
+    /* indexes all values of the window tables. Tables are only linked and
+     * unlinked as a whole so values never move while indexed */
+    unsigned int count, size = ZR_VALUE_INDEX_MIN_SIZE;
+    unsigned short i, table_size;
+    struct zr_value_slot *values;
+    struct zr_table *iter;
+
+    zr_value_index_free(ctx, win);
+    if (ctx->memory.type != ZR_BUFFER_DYNAMIC || !ctx->memory.pool.alloc)
+        return;
+
+    count = (unsigned int)(win->table_count-1) * ZR_VALUE_PAGE_CAPACITY + win->table_size;
+    while (size < count * 2)
+        size *= 2;
+    values = (struct zr_value_slot*)
+        ctx->memory.pool.alloc(ctx->memory.pool.userdata, size * sizeof(*values));
+    if (!values) return;
+    zr_zero(values, size * sizeof(*values));
+    win->values = values;
+    win->value_size = size;
+
+    table_size = win->table_size;
+    for (iter = win->tables; iter; iter = iter->next) {
+        for (i = 0; i < table_size; ++i)
+            zr_value_index_put(win, iter->keys[i], iter, i);
+        table_size = ZR_VALUE_PAGE_CAPACITY;
+    }
+}
+
 static zr_uint*
-zr_find_value(struct zr_window *win, zr_hash name)
+zr_find_value(struct zr_context *ctx, struct zr_window *win, zr_hash name)
 {
     unsigned short size = win->table_size;
     struct zr_table *iter = win->tables;
+
+    /* a single table is searched directly, more get a hash index */
+    if (!win->values && win->table_count > 1)
+        zr_value_index_build(ctx, win);
+    if (win->values) {
+        const unsigned int mask = win->value_size - 1;
+        unsigned int slot = name & mask;
+        while (win->values[slot].table) {
+            struct zr_value_slot *value = &win->values[slot];
+            if (value->key == name) {
+                value->table->seq = win->seq;
+                return &value->table->values[value->index];
+            }
+            slot = (slot + 1) & mask;
+        }
+        return 0;
+    }
+
     while (iter) {
         unsigned short i = 0;
         for (i = 0; i < size; ++i) {
@@ -6563,6 +8624,14 @@ zr_add_value(struct zr_context *ctx, struct zr_window *win,
     win->tables->seq = win->seq;
     win->tables->keys[win->table_size] = name;
     win->tables->values[win->table_size] = value;
+    if (win->values) {
+        if ((win->value_count + 1) * 2 > win->value_size) {
+            win->table_size++;
+            zr_value_index_build(ctx, win);
+            return &win->tables->values[win->table_size-1];
+        }
+        zr_value_index_put(win, name, win->tables, win->table_size);
+    }
     return &win->tables->values[win->table_size++];
 }
 
@@ -6689,19 +8758,405 @@ zr__next(struct zr_context *ctx, const struct zr_command *cmd)
     return next;
 }
 
+void
+zr_frame_get(struct zr_context *ctx, struct zr_frame *frame)
+{
+    struct zr_window *iter;
+    ZR_ASSERT(ctx);
+    ZR_ASSERT(frame);
+    if (!ctx || !frame) return;
+
+    /* the frame just references the linked command list inside the buffer */
+    frame->memory = ctx->memory.memory.ptr;
+    frame->end = ctx->memory.allocated;
+    frame->begin = frame->end;
+    if (ctx->count) {
+        if (!ctx->build) {
+            zr_build(ctx);
+            ctx->build = zr_true;
+        }
+        iter = ctx->begin;
+        while (iter && iter->buffer.begin == iter->buffer.end)
+            iter = iter->next;
+        if (iter) frame->begin = iter->buffer.begin;
+    }
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+    zr_canvas_init(&frame->canvas);
+#endif
+}
+
+const struct zr_command*
+zr__frame_begin(const struct zr_frame *frame)
+{
+    ZR_ASSERT(frame);
+    if (!frame || frame->begin >= frame->end) return 0;
+    return zr_ptr_add_const(struct zr_command, frame->memory, frame->begin);
+}
+
+const struct zr_command*
+zr__frame_next(const struct zr_frame *frame, const struct zr_command *cmd)
+{
+    ZR_ASSERT(frame);
+    if (!frame || !cmd || cmd->next >= frame->end) return 0;
+    return zr_ptr_add_const(struct zr_command, frame->memory, cmd->next);
+}
+
+static void
+zr_command_buffer_move(struct zr_command_buffer *b, zr_byte *dst,
+    const zr_byte *src, zr_size offset)
+{
+    /* moves a finished window command buffer down to `offset` either inside
+     * the same or into another command memory and rebases all command offsets
+     * pointing inside of it */
+    struct zr_command *cmd;
+    zr_size delta;
+
+    ZR_ASSERT(offset <= b->begin);
+    delta = b->begin - offset;
+    if (delta || dst != src) {
+        zr_memcopy(dst + offset, src + b->begin, b->end - b->begin);
+        b->begin -= delta;
+        b->end -= delta;
+        b->last -= delta;
+
+        cmd = zr_ptr_add(struct zr_command, dst, b->begin);
+        while (delta && (zr_size)((zr_byte*)cmd - dst) != b->last) {
+            cmd->next -= delta;
+            cmd = zr_ptr_add(struct zr_command, dst, cmd->next);
+        }
+    }
+    cmd = zr_ptr_add(struct zr_command, dst, b->last);
+    cmd->next = b->end;
+}
+
+static zr_size
+zr_retain(struct zr_context *ctx, const zr_byte *src)
+{
+    /* keeps the commands of all cached windows used in this frame by moving
+     * them in buffer order from the memory of the last frame to the front of
+     * the command buffer */
+    struct zr_window *iter;
+    zr_byte *memory = (zr_byte*)ctx->memory.memory.ptr;
+    zr_size offset = 0;
+
+    for (iter = ctx->begin; iter; iter = iter->next)
+        iter->flags &= ~(zr_flags)ZR_WINDOW_RETAINED;
+    if (!src) return 0;
+
+    while (1) {
+        struct zr_window *win = 0;
+        for (iter = ctx->begin; iter; iter = iter->next) {
+            if (!(iter->flags & ZR_WINDOW_CACHED) || iter->seq != ctx->seq ||
+                (iter->flags & ZR_WINDOW_HIDDEN) || iter->popup.active ||
+                iter->buffer.begin == iter->buffer.end || iter->buffer.begin < offset)
+                continue;
+            if (!win || iter->buffer.begin < win->buffer.begin)
+                win = iter;
+        }
+        if (!win) break;
+        zr_command_buffer_move(&win->buffer, memory, src, offset);
+        win->flags |= ZR_WINDOW_RETAINED;
+        offset = win->buffer.end;
+    }
+    return offset;
+}
+
+static void
+zr_rect_merge(struct zr_rect *dst, struct zr_rect r)
+{
+    float x1, y1;
+    if (r.w <= 0 || r.h <= 0) return;
+    if (dst->w <= 0 || dst->h <= 0) {
+        *dst = r;
+        return;
+    }
+    x1 = MAX(dst->x + dst->w, r.x + r.w);
+    y1 = MAX(dst->y + dst->h, r.y + r.h);
+    dst->x = MIN(dst->x, r.x);
+    dst->y = MIN(dst->y, r.y);
+    dst->w = x1 - dst->x;
+    dst->h = y1 - dst->y;
+}
+
+static zr_uint
+zr_color_hash(struct zr_color c)
+{return ((zr_uint)c.r << 24) | ((zr_uint)c.g << 16) | ((zr_uint)c.b << 8) | (zr_uint)c.a;}
+
+static zr_hash
+zr_command_hash(const struct zr_command *cmd, struct zr_rect *bounds, zr_hash seed)
+{
+    /* hashes all drawing relevant command values and calculates the command
+     * bounds. Struct padding is never hashed since it is not initialized. */
+    zr_uint v[12];
+    int n = 0;
+    float x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    v[n++] = (zr_uint)cmd->type;
+
+    switch (cmd->type) {
+    case ZR_COMMAND_SCISSOR: {
+        const struct zr_command_scissor *c = zr_command(scissor, cmd);
+        v[n++] = (zr_uint)c->x; v[n++] = (zr_uint)c->y;
+        v[n++] = (zr_uint)c->w; v[n++] = (zr_uint)c->h;
+        x0 = c->x; y0 = c->y; x1 = x0 + c->w; y1 = y0 + c->h;
+    } break;
+    case ZR_COMMAND_LINE: {
+        const struct zr_command_line *c = zr_command(line, cmd);
+        v[n++] = (zr_uint)c->begin.x; v[n++] = (zr_uint)c->begin.y;
+        v[n++] = (zr_uint)c->end.x; v[n++] = (zr_uint)c->end.y;
+        v[n++] = zr_color_hash(c->color);
+        x0 = MIN(c->begin.x, c->end.x); x1 = MAX(c->begin.x, c->end.x) + 1;
+        y0 = MIN(c->begin.y, c->end.y); y1 = MAX(c->begin.y, c->end.y) + 1;
+    } break;
+    case ZR_COMMAND_CURVE: {
+        const struct zr_command_curve *c = zr_command(curve, cmd);
+        v[n++] = (zr_uint)c->begin.x; v[n++] = (zr_uint)c->begin.y;
+        v[n++] = (zr_uint)c->end.x; v[n++] = (zr_uint)c->end.y;
+        v[n++] = (zr_uint)c->ctrl[0].x; v[n++] = (zr_uint)c->ctrl[0].y;
+        v[n++] = (zr_uint)c->ctrl[1].x; v[n++] = (zr_uint)c->ctrl[1].y;
+        v[n++] = zr_color_hash(c->color);
+        x0 = MIN(MIN(c->begin.x, c->end.x), MIN(c->ctrl[0].x, c->ctrl[1].x));
+        y0 = MIN(MIN(c->begin.y, c->end.y), MIN(c->ctrl[0].y, c->ctrl[1].y));
+        x1 = MAX(MAX(c->begin.x, c->end.x), MAX(c->ctrl[0].x, c->ctrl[1].x)) + 1;
+        y1 = MAX(MAX(c->begin.y, c->end.y), MAX(c->ctrl[0].y, c->ctrl[1].y)) + 1;
+    } break;
+    case ZR_COMMAND_RECT: {
+        const struct zr_command_rect *c = zr_command(rect, cmd);
+        v[n++] = (zr_uint)c->x; v[n++] = (zr_uint)c->y;
+        v[n++] = (zr_uint)c->w; v[n++] = (zr_uint)c->h;
+        v[n++] = c->rounding; v[n++] = zr_color_hash(c->color);
+        x0 = c->x; y0 = c->y; x1 = x0 + c->w; y1 = y0 + c->h;
+    } break;
+    case ZR_COMMAND_CIRCLE: {
+        const struct zr_command_circle *c = zr_command(circle, cmd);
+        v[n++] = (zr_uint)c->x; v[n++] = (zr_uint)c->y;
+        v[n++] = (zr_uint)c->w; v[n++] = (zr_uint)c->h;
+        v[n++] = zr_color_hash(c->color);
+        x0 = c->x; y0 = c->y; x1 = x0 + c->w; y1 = y0 + c->h;
+    } break;
+    case ZR_COMMAND_ARC: {
+        const struct zr_command_arc *c = zr_command(arc, cmd);
+        v[n++] = (zr_uint)c->cx; v[n++] = (zr_uint)c->cy; v[n++] = (zr_uint)c->r;
+        v[n++] = (zr_uint)(c->a[0] * 1000.0f); v[n++] = (zr_uint)(c->a[1] * 1000.0f);
+        v[n++] = zr_color_hash(c->color);
+        x0 = c->cx - c->r; y0 = c->cy - c->r;
+        x1 = c->cx + c->r + 1; y1 = c->cy + c->r + 1;
+    } break;
+    case ZR_COMMAND_TRIANGLE: {
+        const struct zr_command_triangle *c = zr_command(triangle, cmd);
+        v[n++] = (zr_uint)c->a.x; v[n++] = (zr_uint)c->a.y;
+        v[n++] = (zr_uint)c->b.x; v[n++] = (zr_uint)c->b.y;
+        v[n++] = (zr_uint)c->c.x; v[n++] = (zr_uint)c->c.y;
+        v[n++] = zr_color_hash(c->color);
+        x0 = MIN(c->a.x, MIN(c->b.x, c->c.x)); x1 = MAX(c->a.x, MAX(c->b.x, c->c.x)) + 1;
+        y0 = MIN(c->a.y, MIN(c->b.y, c->c.y)); y1 = MAX(c->a.y, MAX(c->b.y, c->c.y)) + 1;
+    } break;
+    case ZR_COMMAND_TEXT: {
+        const struct zr_command_text *c = zr_command(text, cmd);
+        v[n++] = (zr_uint)c->x; v[n++] = (zr_uint)c->y;
+        v[n++] = (zr_uint)c->w; v[n++] = (zr_uint)c->h;
+        v[n++] = zr_color_hash(c->background); v[n++] = zr_color_hash(c->foreground);
+        v[n++] = (zr_uint)(c->height * 1000.0f);
+        /* the font is identified by its handles and height */
+        v[n++] = (zr_uint)c->font.userdata.id;
+        v[n++] = (zr_uint)(c->font.height * 1000.0f);
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+        v[n++] = (zr_uint)c->font.texture.id;
+#endif
+        seed = zr_murmur_hash(c->string, (int)c->length, seed);
+        x0 = c->x; y0 = c->y; x1 = x0 + c->w; y1 = y0 + c->h;
+    } break;
+    case ZR_COMMAND_IMAGE: {
+        const struct zr_command_image *c = zr_command(image, cmd);
+        v[n++] = (zr_uint)c->x; v[n++] = (zr_uint)c->y;
+        v[n++] = (zr_uint)c->w; v[n++] = (zr_uint)c->h;
+        v[n++] = (zr_uint)c->img.handle.id;
+        v[n++] = (zr_uint)c->img.region[0]; v[n++] = (zr_uint)c->img.region[1];
+        v[n++] = (zr_uint)c->img.region[2]; v[n++] = (zr_uint)c->img.region[3];
+        x0 = c->x; y0 = c->y; x1 = x0 + c->w; y1 = y0 + c->h;
+    } break;
+    case ZR_COMMAND_NOP:
+    default: break;
+    }
+    bounds->x = x0;
+    bounds->y = y0;
+    bounds->w = x1 - x0;
+    bounds->h = y1 - y0;
+    return zr_murmur_hash(v, n * (int)sizeof(v[0]), seed);
+}
+
+int
+zr_frame_changed(struct zr_context *ctx)
+{
+    zr_hash hash = 0;
+    const struct zr_command *cmd;
+    ZR_ASSERT(ctx);
+    if (!ctx) return 1;
+    if (ctx->frame_changed >= 0)
+        return ctx->frame_changed;
+
+    zr_foreach(cmd, ctx) {
+        struct zr_rect bounds;
+        hash = zr_command_hash(cmd, &bounds, hash);
+    }
+    ctx->frame_changed = (hash != ctx->frame);
+    ctx->frame = hash;
+    return ctx->frame_changed;
+}
+
+static int
+zr_window_regions(struct zr_context *ctx, const struct zr_window *win,
+    struct zr_damage_region *regions)
+{
+    /* splits the window command buffer into regions at each scissor command
+     * and hashes each region. Regions past the maximum are merged into
+     * the last region */
+    int count = 0;
+    struct zr_rect clip = zr_null_rect;
+    const struct zr_command *cmd;
+    const struct zr_command *last;
+    struct zr_damage_region *region = 0;
+    zr_byte *memory = (zr_byte*)ctx->memory.memory.ptr;
+
+    if (win->buffer.begin == win->buffer.end)
+        return 0;
+
+    cmd = zr_ptr_add_const(struct zr_command, memory, win->buffer.begin);
+    last = zr_ptr_add_const(struct zr_command, memory, win->buffer.last);
+    while (1) {
+        struct zr_rect bounds;
+        if (!region || (cmd->type == ZR_COMMAND_SCISSOR &&
+            region->bounds.w > 0 && count < ZR_MAX_DAMAGE_REGIONS)) {
+            /* start a new clip region */
+            region = &regions[count++];
+            region->hash = 0;
+            region->bounds = zr_rect(0,0,0,0);
+        }
+        region->hash = zr_command_hash(cmd, &bounds, region->hash);
+        if (cmd->type == ZR_COMMAND_SCISSOR) {
+            clip = bounds;
+        } else {
+            zr_unify(&bounds, &clip, bounds.x, bounds.y,
+                bounds.x + bounds.w, bounds.y + bounds.h);
+            zr_rect_merge(&region->bounds, bounds);
+        }
+        if (cmd == last) break;
+        cmd = zr_ptr_add_const(struct zr_command, memory, cmd->next);
+    }
+    return count;
+}
+
+static void
+zr_damage_add(struct zr_rect *rects, int max, int *count, struct zr_rect r)
+{
+    int i;
+    if (r.w <= 0 || r.h <= 0 || max <= 0) return;
+    for (i = 0; i < *count; ++i) {
+        /* merge overlapping rectangles */
+        if (ZR_INTERSECT(rects[i].x, rects[i].y, rects[i].w, rects[i].h,
+            r.x, r.y, r.w, r.h)) {
+            zr_rect_merge(&rects[i], r);
+            return;
+        }
+    }
+    if (*count < max)
+        rects[(*count)++] = r;
+    else zr_rect_merge(&rects[max-1], r);
+}
+
+int
+zr_damage(struct zr_context *ctx, struct zr_rect *rects, int max)
+{
+    int count = 0;
+    unsigned short order = 0;
+    struct zr_window *iter;
+
+    ZR_ASSERT(ctx);
+    ZR_ASSERT(rects);
+    if (!ctx || !rects) return 0;
+
+    zr_damage_add(rects, max, &count, ctx->damage);
+    ctx->damage = zr_rect(0,0,0,0);
+
+    for (iter = ctx->begin; iter; iter = iter->next, ++order) {
+        int i, n;
+        struct zr_damage_region regions[ZR_MAX_DAMAGE_REGIONS];
+        if (iter->seq != ctx->seq) continue;
+        n = zr_window_regions(ctx, iter, regions);
+        for (i = 0; i < MAX(n, (int)iter->damage_count); ++i) {
+            /* compare each clip region with the one of the last query */
+            const struct zr_damage_region *old = &iter->damage[i];
+            const struct zr_damage_region *cur = &regions[i];
+            if (i >= n) {
+                zr_damage_add(rects, max, &count, old->bounds);
+            } else if (i >= (int)iter->damage_count) {
+                zr_damage_add(rects, max, &count, cur->bounds);
+            } else if (old->hash != cur->hash || iter->damage_order != order ||
+                old->bounds.x != cur->bounds.x || old->bounds.y != cur->bounds.y ||
+                old->bounds.w != cur->bounds.w || old->bounds.h != cur->bounds.h) {
+                zr_damage_add(rects, max, &count, old->bounds);
+                zr_damage_add(rects, max, &count, cur->bounds);
+            }
+        }
+        for (i = 0; i < n; ++i)
+            iter->damage[i] = regions[i];
+        iter->damage_count = (unsigned short)n;
+        iter->damage_order = order;
+    }
+    return count;
+}
+
+static const zr_byte*
+zr_flip(struct zr_context *ctx)
+{
+    /* continues with the least recently used command buffer and keeps the
+     * finished frame alive for `zr_frame_get` handles. Returns the memory of
+     * the finished frame or NULL if cached windows cannot be retained */
+    struct zr_buffer finished = ctx->memory;
+    unsigned int i;
+
+    ctx->memory = ctx->frames[0];
+    for (i = 0; i + 2 < ctx->frame_count; ++i)
+        ctx->frames[i] = ctx->frames[i+1];
+    ctx->frames[ctx->frame_count-2] = finished;
+    zr_buffer_clear(&ctx->memory);
+
+    /* make room for the commands of cached windows */
+    if (finished.allocated && !zr_buffer_alloc(&ctx->memory,
+        ZR_BUFFER_FRONT, finished.allocated, 1))
+        return 0;
+    ctx->memory.needed = 0;
+    return (const zr_byte*)finished.memory.ptr;
+}
+
 void
 zr_clear(struct zr_context *ctx)
 {
     struct zr_window *iter;
     struct zr_window *next;
+    const zr_byte *last;
+    zr_size needed;
     ZR_ASSERT(ctx);
 
     if (!ctx) return;
-    if (ctx->pool)
+    needed = ctx->memory.needed;
+    last = (const zr_byte*)ctx->memory.memory.ptr;
+    if (ctx->frame_count > 1)
+        last = zr_flip(ctx);
+    else if (ctx->pool)
         zr_buffer_clear(&ctx->memory);
     else zr_buffer_reset(&ctx->memory, ZR_BUFFER_FRONT);
 
+    /* commands of cached windows survive at the front of the buffer */
+    ctx->memory.allocated = zr_retain(ctx, last);
+    ctx->memory.needed += ctx->memory.allocated;
+
+    /* grow command memory now while only retained commands have to be
+     * copied, instead of in the middle of the next frame's commands */
+    if (ctx->pool && needed > ctx->memory.memory.size - ctx->memory.memory.size/4)
+        zr_buffer_reserve(&ctx->memory, needed + needed/2);
+
     ctx->build = 0;
+    ctx->frame_changed = -1;
     ctx->memory.calls = 0;
 #if ZR_COMPILE_WITH_VERTEX_BUFFER
     zr_canvas_clear(&ctx->canvas);
@@ -6728,23 +9183,56 @@ zr_clear(struct zr_context *ctx)
             n = it->next;
             if (it->seq != ctx->seq) {
                 zr_remove_table(iter, it);
-                zr_zero(it, sizeof(union zr_page_data));
                 zr_free_table(ctx, it);
-                if (it == iter->tables)
-                    iter->tables = n;
+                zr_value_index_free(ctx, iter);
             }
             it = n;
         }}
 
         /* window itself is not used anymore so free */
         if (iter->seq != ctx->seq) {
+            unsigned short i;
+            for (i = 0; i < iter->damage_count; ++i)
+                zr_rect_merge(&ctx->damage, iter->damage[i].bounds);
             next = iter->next;
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+            zr_canvas_chunk_free(&iter->chunk);
+#endif
             zr_free_window(ctx, iter);
             ctx->count--;
             iter = next;
         } else iter = iter->next;
     }
     ctx->seq++;
+    ctx->widths.seq = ctx->seq;
+}
+
+void
+zr_text_cache_clear(struct zr_context *ctx)
+{
+    ZR_ASSERT(ctx);
+    if (!ctx) return;
+    if (ctx->widths.slots)
+        zr_zero(ctx->widths.slots, ZR_TEXT_WIDTH_CACHE_SIZE * sizeof(struct zr_text_width));
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+    if (ctx->canvas.text_cache.runs)
+        zr_text_run_cache_init(&ctx->canvas.text_cache, ctx->canvas.text_cache.runs,
+            ctx->canvas.text_cache.size);
+#endif
+}
+
+static void
+zr_text_width_cache_init(struct zr_context *ctx)
+{
+    /* string width cache is only available with an allocator */
+    zr_size size;
+    if (ctx->memory.type != ZR_BUFFER_DYNAMIC || !ctx->memory.pool.alloc)
+        return;
+    size = ZR_TEXT_WIDTH_CACHE_SIZE * sizeof(struct zr_text_width);
+    ctx->widths.slots = (struct zr_text_width*)
+        ctx->memory.pool.alloc(ctx->memory.pool.userdata, size);
+    if (ctx->widths.slots)
+        zr_zero(ctx->widths.slots, size);
 }
 
 static void
@@ -6754,6 +9242,7 @@ zr_setup(struct zr_context *ctx, const struct zr_user_font *font)
     ZR_ASSERT(font);
     if (!ctx || !font) return;
     zr_zero_struct(*ctx);
+    ctx->frame_changed = -1;
     zr_load_default_style(ctx, ZR_DEFAULT_ALL);
     ctx->style.font = *font;
 #if ZR_COMPILE_WITH_VERTEX_BUFFER
@@ -6773,6 +9262,21 @@ zr_init_fixed(struct zr_context *ctx, void *memory, zr_size size,
     return 1;
 }
 
+int
+zr_init_buffered(struct zr_context *ctx, struct zr_allocator *alloc,
+    const struct zr_user_font *font, unsigned int frames)
+{
+    unsigned int i;
+    ZR_ASSERT(frames >= 1 && frames <= ZR_MAX_FRAMES);
+    if (!zr_init(ctx, alloc, font)) return 0;
+    frames = CLAMP(1, frames, ZR_MAX_FRAMES);
+    if (frames < 2) return 1;
+    for (i = 0; i < frames-1; ++i)
+        zr_buffer_init(&ctx->frames[i], alloc, ZR_DEFAULT_COMMAND_BUFFER_SIZE);
+    ctx->frame_count = frames;
+    return 1;
+}
+
 int
 zr_init_custom(struct zr_context *ctx, struct zr_buffer *cmds,
     struct zr_buffer *pool, const struct zr_user_font *font)
@@ -6796,6 +9300,7 @@ zr_init_custom(struct zr_context *ctx, struct zr_buffer *cmds,
         ctx->pool = alloc->alloc(alloc->userdata, sizeof(struct zr_pool));
         zr_pool_init(ctx->pool, alloc, ZR_POOL_DEFAULT_CAPACITY);
     }
+    zr_text_width_cache_init(ctx);
     return 1;
 }
 
@@ -6809,15 +9314,55 @@ zr_init(struct zr_context *ctx, struct zr_allocator *alloc,
     zr_buffer_init(&ctx->memory, alloc, ZR_DEFAULT_COMMAND_BUFFER_SIZE);
     ctx->pool = alloc->alloc(alloc->userdata, sizeof(struct zr_pool));
     zr_pool_init(ctx->pool, alloc, ZR_POOL_DEFAULT_CAPACITY);
+    zr_text_width_cache_init(ctx);
     return 1;
 }
 
+void
+zr_reserve(struct zr_context *ctx, zr_size size)
+{
+    unsigned int i;
+    ZR_ASSERT(ctx);
+    if (!ctx || !ctx->pool) return;
+    zr_buffer_reserve(&ctx->memory, size);
+    for (i = 0; i + 1 < ctx->frame_count; ++i)
+        zr_buffer_reserve(&ctx->frames[i], size);
+}
+
 void
 zr_free(struct zr_context *ctx)
 {
     ZR_ASSERT(ctx);
     if (!ctx) return;
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+    {struct zr_window *iter;
+    for (iter = ctx->begin; iter; iter = iter->next)
+        zr_canvas_chunk_free(&iter->chunk);}
+#endif
+    {struct zr_window *iter;
+    for (iter = ctx->begin; iter; iter = iter->next) {
+        zr_value_index_free(ctx, iter);
+        if (iter->popup.win)
+            zr_value_index_free(ctx, iter->popup.win);
+    }}
+    if (ctx->index)
+        ctx->memory.pool.free(ctx->memory.pool.userdata, ctx->index);
+    if (ctx->widths.slots)
+        ctx->memory.pool.free(ctx->memory.pool.userdata, ctx->widths.slots);
+    zr_zero(&ctx->widths, sizeof(ctx->widths));
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+    if (ctx->canvas.text_cache.runs)
+        ctx->memory.pool.free(ctx->memory.pool.userdata, ctx->canvas.text_cache.runs);
+    zr_zero(&ctx->canvas.text_cache, sizeof(ctx->canvas.text_cache));
+#endif
     zr_buffer_free(&ctx->memory);
+    if (ctx->frame_count) {
+        unsigned int i;
+        for (i = 0; i < ctx->frame_count-1; ++i)
+            zr_buffer_free(&ctx->frames[i]);
+        zr_zero(ctx->frames, sizeof(ctx->frames));
+        ctx->frame_count = 0;
+    }
     if (ctx->pool) zr_pool_free(ctx->pool);
 
     zr_zero(&ctx->input, sizeof(ctx->input));
@@ -6833,6 +9378,8 @@ zr_free(struct zr_context *ctx)
     ctx->current = 0;
     ctx->freelist = 0;
     ctx->count = 0;
+    ctx->index = 0;
+    ctx->index_size = 0;
 }
 
 int
@@ -6856,14 +9403,15 @@ zr_begin(struct zr_context *ctx, struct zr_layout *layout,
     win = zr_find_window(ctx, title_hash);
     if (!win) {
         win = zr_create_window(ctx);
-        zr_insert_window(ctx, win);
-        zr_command_buffer_init(&win->buffer, &ctx->memory, ZR_CLIPPING_ON);
         ZR_ASSERT(win);
         if (!win) return 0;
+        win->name = title_hash;
+        zr_insert_window(ctx, win);
+        zr_command_buffer_init(&win->buffer, &ctx->memory, ZR_CLIPPING_ON);
+        win->buffer.widths = &ctx->widths;
 
         win->flags = flags;
         win->bounds = bounds;
-        win->name = title_hash;
         win->popup.win = 0;
     } else {
         /* update public window flags */
@@ -6871,7 +9419,11 @@ zr_begin(struct zr_context *ctx, struct zr_layout *layout,
         win->flags |= flags;
         win->seq++;
     }
-    if (win->flags & ZR_WINDOW_HIDDEN) return 0;
+    if (win->flags & ZR_WINDOW_HIDDEN) {
+        /* drop possibly retained commands of a cached window */
+        zr_command_buffer_reset(&win->buffer);
+        return 0;
+    }
 
     /* overlapping window */
     if (!(win->flags & ZR_WINDOW_SUB) && !(win->flags & ZR_WINDOW_HIDDEN))
@@ -6879,7 +9431,6 @@ zr_begin(struct zr_context *ctx, struct zr_layout *layout,
         int inpanel, ishovered;
         const struct zr_window *iter = win;
 
-        zr_start(ctx, win);
         inpanel = zr_input_mouse_clicked(&ctx->input, ZR_BUTTON_LEFT, win->bounds);
         ishovered = zr_input_is_mouse_hovering_rect(&ctx->input, win->bounds);
 
@@ -6929,6 +9480,27 @@ zr_begin(struct zr_context *ctx, struct zr_layout *layout,
         }
         if (ctx->end != win)
             win->flags |= ZR_WINDOW_ROM;
+
+        if (win->flags & ZR_WINDOW_CACHED) {
+            zr_hash hash = zr_window_input_hash(ctx, win);
+            if ((win->flags & ZR_WINDOW_RETAINED) && !(win->flags & ZR_WINDOW_DIRTY) &&
+                hash == win->cache) {
+                /* nothing changed so reuse the commands from the last frame */
+                struct zr_table *it;
+                for (it = win->tables; it; it = it->next)
+                    it->seq = win->seq;
+                zr_zero(layout, sizeof(*layout));
+                layout->flags = win->flags;
+                layout->bounds = win->bounds;
+                layout->offset = &win->scrollbar;
+                win->layout = layout;
+                ctx->current = win;
+                return 0;
+            }
+            win->cache = hash;
+        }
+        win->flags &= ~(zr_flags)(ZR_WINDOW_RETAINED|ZR_WINDOW_DIRTY);
+        zr_start(ctx, win);
    }
 
     win->layout = layout;
@@ -6945,7 +9517,8 @@ zr_end(struct zr_context *ctx)
     if (!ctx || !ctx->current) return;
     ZR_ASSERT(ctx->current);
     ZR_ASSERT(ctx->current->layout);
-    zr_layout_end(ctx);
+    if (!(ctx->current->flags & ZR_WINDOW_RETAINED))
+        zr_layout_end(ctx);
     ctx->current = 0;
 }
 /*----------------------------------------------------------------
@@ -7165,6 +9738,24 @@ zr_window_collapse_if(struct zr_context *ctx, const char *name,
     else win->flags &= ~(zr_flags)ZR_WINDOW_HIDDEN;
 }
 
+void
+zr_window_invalidate(struct zr_context *ctx, const char *name)
+{
+    int title_len;
+    zr_hash title_hash;
+    struct zr_window *win;
+    ZR_ASSERT(ctx);
+    if (!ctx) return;
+
+    title_len = (int)zr_strsiz(name);
+    title_hash = zr_murmur_hash(name, (int)title_len, ZR_WINDOW_TITLE);
+    win = zr_find_window(ctx, title_hash);
+    if (!win) return;
+    win->flags |= ZR_WINDOW_DIRTY;
+    if (win == ctx->current && win->layout)
+        win->layout->flags |= ZR_WINDOW_DIRTY;
+}
+
 void
 zr_window_set_focus(struct zr_context *ctx, const char *name)
 {
@@ -7632,7 +10223,7 @@ zr_layout_end(struct zr_context *ctx)
             scroll.has_scrolling = (window == ctx->active);
             scroll_offset = zr_do_scrollbarv(&state, out, bounds, scroll_offset,
                                     scroll_target, scroll_step, &scroll, in);
-            layout->offset->y = (unsigned short)scroll_offset;
+            layout->offset->y = (zr_uint)scroll_offset;
         }
         {
             /* horizontal scrollbar */
@@ -7660,7 +10251,7 @@ zr_layout_end(struct zr_context *ctx)
             scroll.has_scrolling = zr_false;
             scroll_offset = zr_do_scrollbarh(&state, out, bounds, scroll_offset,
                                     scroll_target, scroll_step, &scroll, in);
-            layout->offset->x = (unsigned short)scroll_offset;
+            layout->offset->x = (zr_uint)scroll_offset;
         }
     }
 
@@ -8331,6 +10922,108 @@ zr_layout_peek(struct zr_rect *bounds, struct zr_context *ctx)
     layout->row.index = index;
 }
 
+void
+zr_list_view_begin(struct zr_context *ctx, struct zr_list_view *view,
+    zr_size count, float row_height)
+{
+    float step;
+    double top, first, last, skip;
+    struct zr_vec2 spacing;
+    const struct zr_rect *c;
+    struct zr_window *win;
+    struct zr_layout *layout;
+
+    ZR_ASSERT(ctx);
+    ZR_ASSERT(view);
+    ZR_ASSERT(ctx->current);
+    ZR_ASSERT(ctx->current->layout);
+    if (!ctx || !ctx->current || !ctx->current->layout || !view)
+        return;
+
+    win = ctx->current;
+    layout = win->layout;
+    c = &layout->clip;
+    spacing = zr_get_property(ctx, ZR_PROPERTY_ITEM_SPACING);
+    step = row_height + spacing.y;
+
+    /* finish the currently active row so the list starts in a new one */
+    layout->at_y += layout->row.height;
+    layout->row.height = 0;
+    view->count = count;
+    view->row_height = row_height;
+    view->at_y = layout->at_y;
+    view->begin = view->end = 0;
+    view->offset = 0;
+
+    /* calculate the range of rows overlapping the clipping rectangle. Row
+     * offsets of long lists do not fit into a float, so this is done in
+     * double precision */
+    top = (double)layout->at_y - (double)layout->offset->y;
+    if (count && step > 0 && !(layout->flags & ZR_WINDOW_MINIMIZED)) {
+        first = ((double)c->y - top) / (double)step;
+        last = ((double)c->y + (double)c->h - top) / (double)step;
+        first = MAX(first, 0);
+        last = MIN(last + 1, (double)count);
+        if (first < last) {
+            view->begin = MIN((zr_size)first, count);
+            view->end = MIN((zr_size)last, count);
+        }
+    }
+
+    /* skip all rows above the visible area in one step */
+    if (view->begin && (layout->flags & ZR_WINDOW_DYNAMIC)) {
+        struct zr_vec2 panel_padding = zr_get_property(ctx, ZR_PROPERTY_PADDING);
+        zr_draw_rect(&win->buffer,  zr_rect(layout->bounds.x, layout->at_y,
+            layout->bounds.w, (float)view->begin * step + panel_padding.y),
+            0, ctx->style.colors[ZR_COLOR_WINDOW]);
+    }
+
+    /* the whole pixels of the skipped rows are taken out of the scroll
+     * offset until `zr_list_view_end`, so visible rows are positioned
+     * relative to the first visible row and keep pixel precision */
+    skip = (double)view->begin * (double)step;
+    view->offset = (zr_uint)MIN(skip, (double)layout->offset->y);
+    layout->offset->y -= view->offset;
+    layout->at_y += (float)(skip - (double)view->offset);
+    zr_row_layout(ctx, ZR_DYNAMIC, row_height, 1, 0);
+}
+
+void
+zr_list_view_end(struct zr_context *ctx, struct zr_list_view *view)
+{
+    float step;
+    float end_y;
+    struct zr_vec2 spacing;
+    struct zr_layout *layout;
+
+    ZR_ASSERT(ctx);
+    ZR_ASSERT(view);
+    ZR_ASSERT(ctx->current);
+    ZR_ASSERT(ctx->current->layout);
+    if (!ctx || !ctx->current || !ctx->current->layout || !view)
+        return;
+
+    layout = ctx->current->layout;
+    spacing = zr_get_property(ctx, ZR_PROPERTY_ITEM_SPACING);
+    step = view->row_height + spacing.y;
+    end_y = (float)((double)view->at_y + (double)view->count * (double)step);
+    layout->offset->y += view->offset;
+    view->offset = 0;
+
+    /* skip all rows below the visible area in one step */
+    if ((layout->flags & ZR_WINDOW_DYNAMIC) && view->end < view->count) {
+        struct zr_vec2 panel_padding = zr_get_property(ctx, ZR_PROPERTY_PADDING);
+        const float y = (float)((double)view->at_y + (double)view->end * (double)step);
+        zr_draw_rect(&ctx->current->buffer,  zr_rect(layout->bounds.x, y,
+            layout->bounds.w, end_y - y + panel_padding.y), 0,
+            ctx->style.colors[ZR_COLOR_WINDOW]);
+    }
+
+    /* the next allocated row begins directly after the last list row */
+    layout->at_y = end_y - layout->row.height;
+    layout->row.index = layout->row.columns;
+}
+
 int
 zr_layout_push(struct zr_context *ctx, enum zr_layout_node_type type,
     const char *title, enum zr_collapse_states initial_state)
@@ -8379,7 +11072,7 @@ zr_layout_push(struct zr_context *ctx, enum zr_layout_node_type type,
     /* find or create tab persistent state (open/closed) */
     title_len = (int)zr_strsiz(title);
     title_hash = zr_murmur_hash(title, (int)title_len, ZR_WINDOW_HIDDEN);
-    state = zr_find_value(win, title_hash);
+    state = zr_find_value(ctx, win, title_hash);
     if (!state) {
         state = zr_add_value(ctx, win, title_hash, 0);
         *state = initial_state;
@@ -9716,13 +12409,14 @@ int
 zr_group_begin(struct zr_context *ctx, struct zr_layout *layout,
     const char *title, zr_flags flags)
 {
-    union {struct zr_scroll *s; zr_uint *i;} value;
+    zr_uint *value[2];
     struct zr_rect bounds;
     const struct zr_rect *c;
     struct zr_window panel;
     int title_len;
-    zr_hash title_hash;
+    zr_hash title_hash[2];
     struct zr_window *win;
+    int i;
 
     ZR_ASSERT(ctx);
     ZR_ASSERT(title);
@@ -9737,13 +12431,16 @@ zr_group_begin(struct zr_context *ctx, struct zr_layout *layout,
     zr_panel_alloc_space(&bounds, ctx);
     zr_zero(layout, sizeof(*layout));
 
-    /* find group persistent scrollbar value */
+    /* find group persistent horizontal and vertical scrollbar value */
     title_len = (int)zr_strsiz(title);
-    title_hash = zr_murmur_hash(title, (int)title_len, ZR_WINDOW_SUB);
-    value.i = zr_find_value(win, title_hash);
-    if (!value.i) {
-        value.i = zr_add_value(ctx, win, title_hash, 0);
-        *value.i = 0;
+    title_hash[0] = zr_murmur_hash(title, (int)title_len, ZR_WINDOW_SUB);
+    title_hash[1] = zr_murmur_hash(&title_hash[0], (int)sizeof(zr_hash), ZR_WINDOW_SUB);
+    for (i = 0; i < 2; ++i) {
+        value[i] = zr_find_value(ctx, win, title_hash[i]);
+        if (!value[i]) {
+            value[i] = zr_add_value(ctx, win, title_hash[i], 0);
+            *value[i] = 0;
+        }
     }
 
     if (!ZR_INTERSECT(c->x, c->y, c->w, c->h, bounds.x, bounds.y, bounds.w, bounds.h) &&
@@ -9759,15 +12456,18 @@ zr_group_begin(struct zr_context *ctx, struct zr_layout *layout,
     zr_zero(&panel, sizeof(panel));
     panel.bounds = bounds;
     panel.flags = flags;
-    panel.scrollbar.x = (unsigned short)value.s->x;
-    panel.scrollbar.y = (unsigned short)value.s->y;
+    panel.scrollbar.x = *value[0];
+    panel.scrollbar.y = *value[1];
     panel.buffer = win->buffer;
     panel.layout = layout;
     ctx->current = &panel;
     zr_layout_begin(ctx, (flags & ZR_WINDOW_TITLE) ? title: 0);
 
     win->buffer = panel.buffer;
-    layout->offset = value.s;
+    layout->scrollbar = panel.scrollbar;
+    layout->scrollbar_state[0] = value[0];
+    layout->scrollbar_state[1] = value[1];
+    layout->offset = &layout->scrollbar;
     layout->parent = win->layout;
     win->layout = layout;
     ctx->current = win;
@@ -9800,8 +12500,7 @@ zr_group_end(struct zr_context *ctx)
     /* dummy window */
     zr_zero(&pan, sizeof(pan));
     pan.bounds = g->bounds;
-    pan.scrollbar.x = (unsigned short)g->offset->x;
-    pan.scrollbar.y = (unsigned short)g->offset->y;
+    pan.scrollbar = *g->offset;
     pan.flags = g->flags|ZR_WINDOW_SUB;
     pan.buffer = win->buffer;
     pan.layout = g;
@@ -9815,6 +12514,9 @@ zr_group_end(struct zr_context *ctx)
     zr_draw_scissor(&pan.buffer, clip);
     zr_end(ctx);
 
+    /* store the updated scrollbar offset back into the window state */
+    *g->scrollbar_state[0] = g->scrollbar.x;
+    *g->scrollbar_state[1] = g->scrollbar.y;
     win->buffer = pan.buffer;
     zr_draw_scissor(&win->buffer, parent->clip);
     ctx->current = win;
@@ -9926,6 +12628,7 @@ zr_nonblock_begin(struct zr_layout *layout, struct zr_context *ctx,
         popup = zr_create_window(ctx);
         win->popup.win = popup;
         zr_command_buffer_init(&popup->buffer, &ctx->memory, ZR_CLIPPING_ON);
+        popup->buffer.widths = &ctx->widths;
     } else {
         /* check if user clicked outside the popup and close if so */
         int in_panel, in_body, in_header;
@@ -44,6 +44,12 @@ extern "C" {
 #define ZR_MAX_FONT_HEIGHT_STACK 32
 /* Number of temporary configuration font height changes that can be stored */
 #define ZR_MAX_NUMBER_BUFFER 64
+#define ZR_FONT_PAGE_COUNT 256
+/* Number of 256 codepoint pages inside the font glyph lookup table */
+#define ZR_MAX_DAMAGE_REGIONS 8
+/* Number of clip regions per window compared for damaged rectangles */
+#define ZR_MAX_FRAMES 3
+/* Max number of command buffers a context can cycle through */
 /*
  * ==============================================================
  *
@@ -62,6 +68,11 @@ extern "C" {
  library, which allows you to convert queue commands into vertex draw commands.
  If you do not want or need a default backend you can set this flag to zero
  and the module of the library will not be compiled */
+#define ZR_COMPILE_WITH_32BIT_DRAW_INDEX 0
+/* setting this to 1 changes the vertex buffer element type `zr_draw_index`
+ from 16-bit to 32-bit, which lifts the limit of 65536 vertexes per
+ converted frame. The render backend has to draw with 32-bit indices as well.
+ With 16-bit indices all shapes past the limit are dropped. */
 #define ZR_COMPILE_WITH_FONT 1
 /* setting this to 1 adds the `stb_truetype` and `stb_rect_pack` header
  to this library and provides a default font for font loading and rendering.
@@ -127,7 +138,7 @@ struct zr_recti {short x,y,w,h;};
 typedef char zr_glyph[ZR_UTF_SIZE];
 typedef union {void *ptr; int id;} zr_handle;
 struct zr_image {zr_handle handle;unsigned short w,h;unsigned short region[4];};
-struct zr_scroll {unsigned short x, y;};
+struct zr_scroll {zr_uint x, y;};
 
 /* math */
 struct zr_rect zr_get_null_rect(void);
@@ -277,6 +288,10 @@ struct zr_buffer {
 void zr_buffer_init(struct zr_buffer*, const struct zr_allocator*, zr_size size);
 void zr_buffer_init_fixed(struct zr_buffer*, void *memory, zr_size size);
 void zr_buffer_info(struct zr_memory_status*, struct zr_buffer*);
+void zr_buffer_reserve(struct zr_buffer*, zr_size size);
+/* grows a dynamic buffer to hold at least `size` bytes. Only the allocated
+ * front and back parts are copied, so it is cheapest while the buffer is
+ * almost empty. Fixed buffers are left untouched. */
 void zr_buffer_free(struct zr_buffer*);
 void *zr_buffer_memory(struct zr_buffer*);
 zr_size zr_buffer_total(struct zr_buffer*);
@@ -323,6 +338,7 @@ zr_size zr_buffer_total(struct zr_buffer*);
     format.
 */
 typedef zr_size(*zr_text_width_f)(zr_handle, float h, const char*, zr_size len);
+typedef float(*zr_glyph_advance_f)(zr_handle, float h, zr_rune codepoint);
 typedef void(*zr_query_font_glyph_f)(zr_handle handle, float font_height,
                                     struct zr_user_font_glyph *glyph,
                                     zr_rune codepoint, zr_rune next_codepoint);
@@ -347,14 +363,29 @@ struct zr_user_font {
     /* max height of the font */
     zr_text_width_f width;
     /* font string width in pixel callback */
+    zr_glyph_advance_f advance;
+    /* optional glyph advance in pixel callback. If set text hit testing and
+     * clamping sums up glyph advances instead of measuring every prefix of
+     * the string with `width`, so the sum of all advances of a string has to
+     * be equal to its width */
 #if ZR_COMPILE_WITH_VERTEX_BUFFER
     zr_query_font_glyph_f query;
     /* font glyph callback to query drawing info */
     zr_handle texture;
     /* texture handle to the used font atlas or texture */
+    int dynamic;
+    /* glyph texture coordinates can change between frames, so glyph quads
+     * are not cached and `zr_convert` does not dispatch windows to threads
+     * for frames with text drawn in this font */
 #endif
 };
 
+/* callbacks to run independent jobs, for example on worker threads. Used by
+ * `zr_convert` and `zr_font_bake_dispatch` */
+typedef void(*zr_convert_job_f)(void *data, unsigned int index);
+typedef void(*zr_convert_dispatch_f)(zr_handle, zr_convert_job_f,
+                                    void *data, unsigned int count);
+
 #ifdef ZR_COMPILE_WITH_FONT
 enum zr_font_coord_type {
     ZR_COORD_UV,
@@ -374,6 +405,8 @@ struct zr_baked_font {
     /* number of glyphs of this font inside the glyph baking array output */
     const zr_rune *ranges;
     /* font codepoint ranges as pairs of (from/to) and 0 as last element */
+    float sdf_spread;
+    /* pixel distance covered by signed distance field glyphs or 0 */
 };
 
 struct zr_font_config {
@@ -395,6 +428,36 @@ struct zr_font_config {
     /* list of unicode ranges (2 values per range, zero terminated) */
     struct zr_baked_font *font;
     /* font to setup in the baking process  */
+    float sdf_spread;
+    /* if not 0 glyphs are baked as signed distance fields instead of
+     * coverage. Each texel stores the distance to the glyph outline mapped
+     * from [-spread,spread] pixels to [0,255] with the outline at 128, so
+     * one bake can be drawn sharp at any height with a distance threshold.
+     * Oversampling is ignored for distance fields */
+};
+
+struct zr_font_pack_stats {
+    int glyph_count;
+    /* number of glyphs inside the font codepoint ranges */
+    int packed_count;
+    /* number of glyphs which found space inside the image */
+    zr_size used;
+    /* image bytes covered by the packed glyphs including padding */
+    float fill;
+    /* share of the image covered by the packed glyphs (0.0 - 1.0) */
+};
+
+struct zr_font_pack_report {
+    int width, height;
+    /* pixel size of the image the glyphs were packed into */
+    zr_size image_size;
+    /* size of the image in bytes */
+    zr_size wasted;
+    /* image bytes covered neither by glyphs nor by the custom space */
+    float fill;
+    /* share of the image covered by glyphs and custom space (0.0 - 1.0) */
+    struct zr_font_pack_stats total;
+    /* glyphs of all fonts inside the image */
 };
 
 struct zr_font_glyph {
@@ -409,6 +472,49 @@ struct zr_font_glyph {
     /* texture coordinates either in pixel or clamped (0.0 - 1.0) */
 };
 
+enum zr_font_page_type {
+    ZR_FONT_PAGE_SEARCH,
+    /* page has no lookup entry and glyph ranges are searched linearly */
+    ZR_FONT_PAGE_EMPTY,
+    /* page does not contain any glyph and always returns the fallback glyph */
+    ZR_FONT_PAGE_DIRECT
+    /* page is covered by one glyph range and the glyph is directly indexed */
+};
+
+struct zr_font_page {
+    int offset;
+    /* glyph array index of the first codepoint in the page (can be negative) */
+    zr_byte first, last;
+    /* lowest and highest codepoint byte inside the page covered by glyphs */
+    zr_byte type;
+    /* lookup type of the page (enum zr_font_page_type) */
+};
+
+struct zr_font_cache {
+    void *image;
+    /* baked font image */
+    int image_width, image_height;
+    /* pixel width/height of the image */
+    zr_size image_size;
+    /* size of the image in bytes */
+    struct zr_recti custom;
+    /* custom space inside the image */
+    struct zr_font_glyph *glyphs;
+    /* baked glyph array of all fonts */
+    int glyph_count;
+    /* number of glyphs in the glyph array */
+    struct zr_baked_font *fonts;
+    /* baked font metrics and ranges */
+    int font_count;
+    /* number of baked fonts */
+    zr_uint identity;
+    /* TTF files and configurations the fonts were baked from, as returned
+     * by `zr_font_cache_identity` */
+};
+
+struct zr_font_atlas;
+/* dynamic glyph atlas state, see `zr_font_init_dynamic` */
+
 struct zr_font {
     float size;
     /* pixel height of the font */
@@ -428,6 +534,15 @@ struct zr_font {
     /* glyph unicode ranges in the font */
     zr_handle atlas;
     /* font image atlas handle */
+    float sdf_spread;
+    /* pixel distance covered by signed distance field glyphs or 0 for
+     * coverage glyphs. A renderer draws a texel value `v` at height `h` with
+     * alpha smoothstep(0.5 - w, 0.5 + w, v) and w = 0.5 * size / (h * 2 * spread) */
+    struct zr_font_atlas *dynamic;
+    /* glyph atlas filled on demand or NULL for a baked font */
+    struct zr_font_page pages[ZR_FONT_PAGE_COUNT];
+    /* codepoint to glyph lookup table for the basic multilingual plane with
+     * 256 codepoints per page. Is build by `zr_font_init` */
 };
 
 /* some language glyph codepoint ranges */
@@ -466,6 +581,30 @@ int zr_font_bake_pack(zr_size *img_memory, int *img_width, int *img_height,
     - custom space bounds with position and size inside image which can be
         filled by the user
 */
+int zr_font_bake_pack_tight(zr_size *img_memory, int *img_width, int *img_height,
+                            struct zr_recti *custom_space,
+                            void *temporary_memory, zr_size temporary_size,
+                            const struct zr_font_config*, int font_count);
+/*  same as `zr_font_bake_pack` but instead of a fixed image width depending
+    on the number of glyphs it searches the smallest power of two image with
+    at most twice the width as height or height as width all glyphs fit into.
+    Each size is tried with both stb_rect_pack skyline heuristics, so packing
+    takes longer than `zr_font_bake_pack`. Falls back to the layout of
+    `zr_font_bake_pack` if no size is found.
+*/
+void zr_font_bake_report(struct zr_font_pack_report*, struct zr_font_pack_stats*,
+                            const void *temporary_memory, int font_count);
+/*  this function describes how well the glyphs were packed and has to be
+    called after `zr_font_bake_pack` or `zr_font_bake_pack_tight` and before
+    `zr_font_bake`.
+    Input:
+    - temporary memory block that was used to pack the glyphs
+    - number of configuration fonts that were packed
+    Output:
+    - image size, wasted bytes and fill ratio of all glyphs
+    - NULL or array of `font_count` entries with glyph counts and
+        covered bytes for every font
+*/
 void zr_font_bake(void *image_memory, int image_width, int image_height,
                     void *temporary_memory, zr_size temporary_memory_size,
                     struct zr_font_glyph*, int glyphs_count,
@@ -481,6 +620,17 @@ void zr_font_bake(void *image_memory, int image_width, int image_height,
     - image filled with glyphs
     - filled glyph array
 */
+void zr_font_bake_dispatch(void *image_memory, int image_width, int image_height,
+                    void *temporary_memory, zr_size temporary_memory_size,
+                    struct zr_font_glyph*, int glyphs_count,
+                    const struct zr_font_config*, int font_count,
+                    zr_convert_dispatch_f dispatch, zr_handle userdata);
+/*  same as `zr_font_bake` but splits the glyphs packed by `zr_font_bake_pack`
+    into jobs of up to 256 glyphs. The dispatch callback has to call
+    `job(data, i)` for every index in [0,count) and may only return once all
+    jobs are finished. Jobs rasterize into disjoint parts of the image and can
+    run on different threads at the same time.
+*/
 void zr_font_bake_custom_data(void *img_memory, int img_width, int img_height,
                             struct zr_recti img_dst, const char *image_data_mask,
                             int tex_width, int tex_height,char white,char black);
@@ -506,6 +656,96 @@ void zr_font_init(struct zr_font*, float pixel_height, zr_rune fallback_codepoin
 struct zr_user_font zr_font_ref(struct zr_font*);
 const struct zr_font_glyph* zr_font_find_glyph(struct zr_font*, zr_rune unicode);
 
+/* font cache functions */
+zr_uint zr_font_cache_identity(const struct zr_font_config*, int count);
+/*  this function hashes the TTF files, sizes, oversampling and all other
+    baking relevant values of the configurations, so a cache is only loaded
+    for the fonts it was baked from
+    Input:
+    - array of configuration for every font baked into one image
+    - number of configuration fonts in the array
+    Output:
+    - identity to store in and compare against a font cache
+*/
+zr_size zr_font_cache_size(const struct zr_font_cache*);
+/*  this function calculates the size of a serialized font cache
+    Input:
+    - baking output with image, glyphs and fonts
+    Output:
+    - number of bytes needed by `zr_font_cache_store`
+*/
+zr_size zr_font_cache_store(void *memory, zr_size size, const struct zr_font_cache*);
+/*  this function writes the baking output into one versioned memory block
+    that can be saved to a file, so later runs do not have to bake the same
+    fonts again.
+    Input:
+    - memory block of at least `zr_font_cache_size` bytes
+    - baking output with image, glyphs, fonts and identity
+    Output:
+    - number of bytes written or 0 if the memory block is too small
+*/
+int zr_font_cache_load(struct zr_font_cache*, struct zr_baked_font *fonts,
+                        int max_fonts, zr_uint identity, void *memory,
+                        zr_size size);
+/*  this function reads a memory block written by `zr_font_cache_store`, for
+    example a memory mapped file. Nothing is copied, the image and glyphs
+    point into the memory block which therefore has to outlive all fonts
+    initialized from it and must be aligned to at least 8 bytes.
+    Input:
+    - array of baked fonts to fill with font metrics and ranges
+    - size of the baked font array
+    - identity of the font configurations from `zr_font_cache_identity`
+    - memory block with the cache and its size
+    Output:
+    - font cache pointing into the memory block
+    - zr_true if the cache is valid and was written by the same version and
+        platform for the same fonts, zr_false otherwise
+*/
+
+/* dynamic font atlas functions */
+void zr_font_dynamic_memory(zr_size *memory, int width, int height,
+                            const struct zr_font_config*);
+/*  this function calculates the memory needed by a dynamic font atlas
+    Input:
+    - pixel width/height of the atlas image
+    - font configuration with the size of the font
+    Output:
+    - amount of memory needed for the atlas image, glyphs and packer
+*/
+int zr_font_init_dynamic(struct zr_font*, float pixel_height,
+                        zr_rune fallback_codepoint, struct zr_recti *custom,
+                        void *memory, zr_size size, int width, int height,
+                        const struct zr_font_config*, zr_handle atlas);
+/*  this function sets up a font without baking any glyphs up front. Glyphs
+    are rasterized into an alpha8 atlas image the first time they are looked
+    up and packed into a few horizontal pages. If all pages are full the page
+    drawn from least recently is cleared. Only the TTF blob, size, spacing,
+    pixel snapping and coordinate type of the configuration are used, the
+    optional range restricts which codepoints are rasterized and oversampling
+    is not supported. A dynamic font is written to on every lookup and can
+    therefore only be used by one context and thread at a time and not with
+    contexts created by `zr_init_buffered`.
+    Input:
+    - memory block of the size returned by `zr_font_dynamic_memory`
+    - pixel width/height of the atlas image
+    - NULL or custom space inside the image (will be modifed to fit!)
+    - font configuration
+    Output:
+    - custom space bounds in the upper left corner of the image
+    - zr_true if the font could be set up, zr_false otherwise
+*/
+void *zr_font_dynamic_image(struct zr_font*, int *width, int *height);
+/*  this function returns the alpha8 atlas image of a dynamic font, for
+    example to bake custom data into it or to upload it the first time */
+int zr_font_dynamic_update(struct zr_font*, struct zr_recti *dirty);
+/*  this function has to be called once per frame before drawing. It returns
+    zr_true if glyphs were rasterized or pages cleared since the last call and
+    `dirty` has to be uploaded from the atlas image. Pages drawn from in the
+    next frame cannot be cleared until it is called again.
+    Output:
+    - sub-rectangle of the atlas image that changed
+*/
+
 #endif
 /* ===============================================================
  *
@@ -608,7 +848,9 @@ struct zr_command_image {
 
 struct zr_command_text {
     struct zr_command header;
-    const struct zr_user_font *font;
+    struct zr_user_font font;
+    /* copy of the font the text was drawn with, so retained commands and
+     * frame handles do not depend on the style font of the context */
     struct zr_color background;
     struct zr_color foreground;
     short x, y;
@@ -623,6 +865,18 @@ enum zr_command_clipping {
     ZR_CLIPPING_ON = zr_true
 };
 
+struct zr_text_width;
+struct zr_text_width_cache {
+    struct zr_text_width *slots;
+    /* hash table of measured strings or NULL if not allocated */
+    unsigned int seq;
+    /* current frame used to evict strings not measured anymore */
+    unsigned int hits;
+    /* number of string widths taken from the cache */
+    unsigned int misses;
+    /* number of string widths measured by the font width callback */
+};
+
 struct zr_command_buffer {
     struct zr_buffer *base;
     /* memory buffer to store the command */
@@ -630,11 +884,17 @@ struct zr_command_buffer {
     /* current clipping rectangle */
     int use_clipping;
     /* flag if the command buffer should clip commands */
+    struct zr_text_width_cache *widths;
+    /* string width cache of the owning context or NULL */
     zr_size begin, end, last;
 };
 
 #if ZR_COMPILE_WITH_VERTEX_BUFFER
+#if ZR_COMPILE_WITH_32BIT_DRAW_INDEX
+typedef zr_uint zr_draw_index;
+#else
 typedef unsigned short zr_draw_index;
+#endif
 typedef zr_uint zr_draw_vertex_color;
 
 enum zr_anti_aliasing {
@@ -650,6 +910,45 @@ struct zr_draw_vertex {
     zr_draw_vertex_color col;
 };
 
+enum zr_draw_vertex_layout_attribute {
+    ZR_VERTEX_POSITION,
+    /* two component screen space position */
+    ZR_VERTEX_COLOR,
+    /* four component color */
+    ZR_VERTEX_TEXCOORD,
+    /* two component texture coordinate */
+    ZR_VERTEX_ATTRIBUTE_COUNT
+};
+
+enum zr_draw_vertex_layout_format {
+    ZR_FORMAT_SCHAR,
+    ZR_FORMAT_SSHORT,
+    ZR_FORMAT_SINT,
+    ZR_FORMAT_UCHAR,
+    ZR_FORMAT_USHORT,
+    ZR_FORMAT_UINT,
+    ZR_FORMAT_FLOAT,
+    ZR_FORMAT_HALF,
+    /* IEEE 754 half precision float stored in an unsigned short */
+    ZR_FORMAT_DOUBLE,
+    /* formats for position and texture coordinates */
+    ZR_FORMAT_R8G8B8A8,
+    ZR_FORMAT_B8G8R8A8,
+    ZR_FORMAT_R32G32B32A32_FLOAT,
+    /* formats for colors with float components in range [0,1] */
+    ZR_FORMAT_COUNT
+};
+
+struct zr_draw_vertex_layout_element {
+    enum zr_draw_vertex_layout_attribute attribute;
+    /* attribute to write into the vertex */
+    enum zr_draw_vertex_layout_format format;
+    /* component type the attribute is written as */
+    zr_size offset;
+    /* byte offset of the attribute inside the vertex */
+};
+#define ZR_VERTEX_LAYOUT_END {ZR_VERTEX_ATTRIBUTE_COUNT,ZR_FORMAT_COUNT,0}
+
 struct zr_draw_command {
     unsigned int elem_count;
     /* number of elements in the current draw batch */
@@ -1187,8 +1486,14 @@ enum zr_window_flags {
      * be used to create perfectly fitting windows as well */
     ZR_WINDOW_NO_SCROLLBAR  = ZR_FLAG(7),
     /* Removes the scrollbar from the window */
-    ZR_WINDOW_TITLE         = ZR_FLAG(8)
+    ZR_WINDOW_TITLE         = ZR_FLAG(8),
     /* Removes the scrollbar from the window */
+    ZR_WINDOW_CACHED        = ZR_FLAG(9)
+    /* Reuses the drawing commands of the last frame as long as the window
+     * input, bounds and state did not change. In that case `zr_begin` returns
+     * false and the window content does not have to be filled. Changes from
+     * outside the window input (data or style) require a call to
+     * `zr_window_invalidate` */
 };
 
 struct zr_popup_buffer {
@@ -1210,6 +1515,10 @@ struct zr_layout {
     /* position and size of the window in the os window */
     struct zr_scroll *offset;
     /* window scrollbar offset */
+    struct zr_scroll scrollbar;
+    /* group scrollbar offset copied out of the persistent window state */
+    zr_uint *scrollbar_state[2];
+    /* persistent window state of the group scrollbar offset */
     float at_x, at_y, max_x;
     /* index position of the current widget row and column  */
     float width, height;
@@ -1232,6 +1541,40 @@ struct zr_layout {
     struct zr_layout *parent;
 };
 
+struct zr_list_view {
+    zr_size begin;
+    /* index of the first visible row */
+    zr_size end;
+    /* index one past the last visible row */
+    zr_size count;
+    /* total number of rows in the list */
+    float row_height;
+    /* height of every row without item spacing */
+    float at_y;
+    /* layout position of the first row */
+    zr_uint offset;
+    /* part of the scroll offset covered by the skipped rows which is moved
+     * into the row positions between begin and end */
+};
+/*  The list view only lays out the rows inside the clipping rectangle of
+    the current window. `zr_list_view_begin` starts a single column row layout
+    with `row_height`, skips all rows above the visible area in one step and
+    returns the visible range in `begin` and `end`. Only those rows have to
+    be pushed by the caller while `zr_list_view_end` advances the layout past
+    the remaining rows. Rows can be split into multiple columns by the caller
+    as long as the row height stays the same. Between begin and end the
+    window scroll offset is reduced by the height of the skipped rows, so
+    rows keep pixel precision in lists taller than a float can address.
+
+    if (zr_begin(ctx, &layout, "Log", bounds, ZR_WINDOW_BORDER)) {
+        struct zr_list_view view;
+        zr_list_view_begin(ctx, &view, line_count, 18);
+        for (i = view.begin; i < view.end; ++i)
+            zr_label(ctx, lines[i], ZR_TEXT_LEFT);
+        zr_list_view_end(ctx, &view);
+    }
+    zr_end(ctx); */
+
 /*==============================================================
  *                          CONTEXT
  * =============================================================*/
@@ -1244,6 +1587,28 @@ struct zr_clipboard {
     /* copy callback for the edit box  */
 };
 
+struct zr_text_run;
+struct zr_text_run_cache {
+    struct zr_text_run *runs;
+    /* hash table of cached glyph layouts or NULL if the cache is disabled */
+    zr_size run_count;
+    /* number of hash table entries (power of two) */
+    zr_byte *pool;
+    /* ring buffer holding the glyphs and text of all runs */
+    zr_size pool_size;
+    /* size of the ring buffer in bytes */
+    zr_size head;
+    /* offset the next run is written to */
+    unsigned int lap;
+    /* number of times the ring buffer wrapped around */
+    zr_size size;
+    /* requested size of the memory block (`zr_convert_config.text_cache_size`) */
+    unsigned int hits;
+    /* number of texts drawn from the cache */
+    unsigned int misses;
+    /* number of texts laid out by the user font query callback */
+};
+
 struct zr_canvas {
     enum zr_anti_aliasing shape_AA;
     /* flag indicating if anti-aliasing should be used to render shapes */
@@ -1263,6 +1628,9 @@ struct zr_canvas {
     /* total number of elements inside the elements buffer */
     unsigned int vertex_count;
     /* total number of vertexes inside the vertex buffer */
+    int overflow;
+    /* set if shapes were dropped because the vertexes did not fit into the
+     * 16-bit draw index range (see ZR_COMPILE_WITH_32BIT_DRAW_INDEX) */
     zr_size cmd_offset;
     /* offset to the first command in the buffer */
     unsigned int cmd_count;
@@ -1271,8 +1639,31 @@ struct zr_canvas {
     /* current number of points inside the path */
     unsigned int path_offset;
     /* offset to the first point in the buffer */
+    const struct zr_draw_vertex_layout_element *vertex_layout;
+    /* output vertex format or NULL for `struct zr_draw_vertex` */
+    zr_size vertex_size;
+    /* size of each vertex in the vertex buffer */
+    zr_size vertex_alignment;
+    /* alignment of the first vertex in the vertex buffer */
     struct zr_vec2 circle_vtx[12];
     /* small lookup table for fast circle drawing */
+    struct zr_text_run_cache text_cache;
+    /* glyph layouts of recently drawn text */
+    unsigned int seq;
+    /* frame counter used to evict cached glyph layouts */
+};
+
+struct zr_frame {
+    const void *memory;
+    /* command memory of the frame */
+    zr_size begin;
+    /* offset of the first command */
+    zr_size end;
+    /* end of the command stream inside the command memory */
+#if ZR_COMPILE_WITH_VERTEX_BUFFER
+    struct zr_canvas canvas;
+    /* vertex conversion state of `zr_frame_convert` */
+#endif
 };
 
 struct zr_context {
@@ -1282,6 +1673,12 @@ struct zr_context {
     struct zr_buffer memory;
     struct zr_clipboard clip;
     void *pool;
+    struct zr_text_width_cache widths;
+    /* frame persistent string width cache used by all widgets */
+    struct zr_buffer frames[ZR_MAX_FRAMES-1];
+    /* command buffers of previous frames, least recently used first */
+    unsigned int frame_count;
+    /* number of command buffers cycled through by `zr_clear` or 0 */
 
 #if ZR_COMPILE_WITH_VERTEX_BUFFER
     struct zr_canvas canvas;
@@ -1294,19 +1691,60 @@ struct zr_context {
     struct zr_window *current;
     struct zr_window *freelist;
     unsigned int count;
+    struct zr_window **index;
+    /* open addressing hash table of all windows by name or NULL */
+    unsigned int index_size;
+    /* number of slots inside the window hash table */
+    struct zr_rect damage;
+    /* area of all windows removed since the last damage query */
+    zr_hash frame;
+    /* hash over the command stream of the last checked frame */
+    int frame_changed;
+    /* result of the frame change check for the current frame or -1 */
 };
 
 /*--------------------------------------------------------------
  *                          CONTEXT
  * -------------------------------------------------------------*/
+/* The library has no global or static mutable state, so independent contexts
+ * can be used on different threads at the same time. Everything a context
+ * writes to is owned by it. A `zr_font` and its glyph table and atlas are
+ * only read after `zr_font_init` and can be shared between all contexts,
+ * as long as the user font callbacks and allocators passed to more than one
+ * context are thread-safe themselves. Fonts set up by `zr_font_init_dynamic`
+ * rasterize glyphs on lookup and cannot be shared. A single context must only
+ * be used by one thread at a time. */
 int zr_init_fixed(struct zr_context*, void *memory, zr_size size,
                     const struct zr_user_font*);
 int zr_init_custom(struct zr_context*, struct zr_buffer *cmds,
                     struct zr_buffer *pool, const struct zr_user_font*);
 int zr_init(struct zr_context*, struct zr_allocator*,
             const struct zr_user_font*);
+int zr_init_buffered(struct zr_context*, struct zr_allocator*,
+            const struct zr_user_font*, unsigned int frames);
+/* same as `zr_init` but `zr_clear` switches between `frames` (2 or 3)
+ * command buffers, so commands of the last `frames`-1 frames stay valid
+ * while the next frame is built. This allows a render thread to walk or
+ * convert a frame handle from `zr_frame_get` in parallel to the UI thread.
+ * Fonts set up by `zr_font_init_dynamic` cannot be used with buffered frames,
+ * since glyph lookups write to the atlas and only pages drawn from in the
+ * current frame are kept, so older frames can point at cleared pages. */
+void zr_reserve(struct zr_context*, zr_size size);
+/* grows the command memory of a context created by `zr_init` or
+ * `zr_init_buffered` to at least `size` bytes. `zr_clear` only grows the
+ * memory after a frame came close to filling it, so a frame whose commands
+ * appear all at once, like a large window opened for the first time, still
+ * grows it while the commands are built. Reserving the peak `needed` value
+ * from `zr_buffer_info` of earlier runs up front avoids that. Has to be
+ * called between frames while no `zr_frame_get` handle is in use. */
 void zr_clear(struct zr_context*);
 void zr_free(struct zr_context*);
+void zr_text_cache_clear(struct zr_context*);
+/* forgets all cached string widths and glyph layouts. Cached text is keyed
+ * by the font handles, callbacks and height so switching fonts needs no
+ * call, but it has to be called if the glyphs behind unchanged handles
+ * change, for example after baking the font atlas again into the same
+ * texture. */
 
 /* window */
 int zr_begin(struct zr_context*, struct zr_layout*, const char *title,
@@ -1336,6 +1774,7 @@ void zr_window_collapse(struct zr_context *ctx, const char *name,
                         enum zr_collapse_states);
 void zr_window_collapse_if(struct zr_context *ctx, const char *name,
                             enum zr_collapse_states, int cond);
+void zr_window_invalidate(struct zr_context*, const char *name);
 
 /*--------------------------------------------------------------
  *                      DRAWING
@@ -1344,8 +1783,34 @@ void zr_window_collapse_if(struct zr_context *ctx, const char *name,
 #define zr_command(t, c) ((const struct zr_command_##t*)c)
 #define zr_foreach(c, ctx) for((c)=zr__begin(ctx); (c)!=0; (c)=zr__next(ctx, c))
 const struct zr_command* zr__next(struct zr_context*, const struct zr_command*);
+int zr_frame_changed(struct zr_context*);
+/* returns if the command stream of the current frame differs from the
+ * last checked frame. Unchanged frames do not have to be converted or drawn
+ * again. Has to be called after all windows are finished and before
+ * `zr_clear`. */
+int zr_damage(struct zr_context*, struct zr_rect *rects, int max);
+/* compares the command stream of the current frame with the one of the last
+ * call per window clip region and writes up to `max` rectangles
+ * covering all screen areas that changed. Returns the number of rectangles.
+ * Has to be called each frame after all windows are finished and before
+ * `zr_clear`. */
 const struct zr_command* zr__begin(struct zr_context*);
 
+void zr_frame_get(struct zr_context*, struct zr_frame*);
+/* returns a handle to the command stream of the current frame. Has to be
+ * called after all windows are finished and before `zr_clear`. The handle does
+ * not reference the context and stays valid until its command buffer is reused,
+ * which is after the next `zr_clear` or for contexts created by
+ * `zr_init_buffered` after `frames` calls to `zr_clear`. Text commands carry a
+ * copy of the user font they were drawn with, so the style font can be changed
+ * while a frame is walked, but the font behind the copied handles has to stay
+ * alive and its callbacks have to be safe to call from the walking thread.
+ * Therefore a dynamic font cannot be used by a handle that is walked after
+ * the next frame was started. */
+#define zr_frame_foreach(c, f) for((c)=zr__frame_begin(f); (c)!=0; (c)=zr__frame_next(f, c))
+const struct zr_command* zr__frame_begin(const struct zr_frame*);
+const struct zr_command* zr__frame_next(const struct zr_frame*, const struct zr_command*);
+
 /* vertex command drawing */
 struct zr_convert_config {
     float line_thickness;
@@ -1358,6 +1823,29 @@ struct zr_convert_config {
     /* number of segments used for circle and curves: default to 22 */
     struct zr_draw_null_texture null;
     /* handle to texture with a white pixel to draw text */
+    const struct zr_draw_vertex_layout_element *vertex_layout;
+    /* optional vertex format terminated by ZR_VERTEX_LAYOUT_END. If NULL
+     * vertexes are written as `struct zr_draw_vertex`. Attributes are written
+     * directly at their offset so each has to be aligned to its format. */
+    zr_size vertex_size;
+    /* size of one vertex in bytes (stride) for a custom vertex layout. Has
+     * to be a multiple of `vertex_alignment` */
+    zr_size vertex_alignment;
+    /* alignment of the vertex buffer for a custom vertex layout */
+    zr_convert_dispatch_f dispatch;
+    /* optional callback to convert each window on its own. It has to call
+     * `job(data, i)` for every index in [0,count), for example on worker
+     * threads, and may only return once all jobs are finished. The results
+     * are afterwards merged in window order. Only used for contexts created
+     * by `zr_init` whose allocator and user font have to be thread-safe */
+    zr_handle userdata;
+    /* handle passed to the dispatch callback */
+    zr_size text_cache_size;
+    /* optional number of bytes the context allocator provides to cache the
+     * glyph layout of recently drawn text, or 0 to query the user font for
+     * every drawn text. Pays off for fonts with costly glyph queries. Sizes
+     * below a few kilobytes leave the cache disabled. Only used without
+     * dispatch callback by contexts created with an allocator */
 };
 
 void zr_convert(struct zr_context*, struct zr_buffer *cmds,
@@ -1370,6 +1858,18 @@ const struct zr_draw_command* zr__draw_begin(const struct zr_context*,
 const struct zr_draw_command* zr__draw_next(const struct zr_draw_command*,
                                             const struct zr_buffer*,
                                             const struct zr_context*);
+void zr_frame_convert(struct zr_frame*, struct zr_buffer *cmds,
+                struct zr_buffer *vertexes, struct zr_buffer *elements,
+                const struct zr_convert_config*);
+/* converts the commands of a frame handle like `zr_convert` but without
+ * touching the context. The dispatch callback is not used. */
+#define zr_frame_draw_foreach(cmd, f, b)\
+    for((cmd)=zr__frame_draw_begin(f, b); (cmd)!=0; (cmd)=zr__frame_draw_next(cmd, b, f))
+const struct zr_draw_command* zr__frame_draw_begin(const struct zr_frame*,
+                                            const struct zr_buffer*);
+const struct zr_draw_command* zr__frame_draw_next(const struct zr_draw_command*,
+                                            const struct zr_buffer*,
+                                            const struct zr_frame*);
 
 /*--------------------------------------------------------------
  *                      INPUT
@@ -1444,6 +1944,11 @@ struct zr_vec2 zr_layout_space_to_local(struct zr_context*, struct zr_vec2);
 struct zr_rect zr_layout_space_rect_to_screen(struct zr_context*, struct zr_rect);
 struct zr_rect zr_layout_space_rect_to_local(struct zr_context*, struct zr_rect);
 
+/* list view layout */
+void zr_list_view_begin(struct zr_context*, struct zr_list_view*, zr_size count,
+                        float row_height);
+void zr_list_view_end(struct zr_context*, struct zr_list_view*);
+
 /* group layout */
 int zr_group_begin(struct zr_context*, struct zr_layout*, const char *title, zr_flags);
 void zr_group_end(struct zr_context *ctx);